@@ -28,6 +28,8 @@
 #include "NUM2.h"
 #include "Sound_and_Spectrum.h"
 #include "Sound_extensions.h"
+#include "MelderThread.h"
+#include <vector>
 
 #define TOLOG(x) ((1 / NUMln10) * log ((x) + 1e-30))
 #define TO10LOG(x) ((10 / NUMln10) * log ((x) + 1e-30))
@@ -267,53 +269,246 @@ autoPowerCepstrogram Matrix_to_PowerCepstrogram (Matrix me) {
 	}
 }
 
+/*
+	The resampled and pre-emphasized sound, and the frame times, that Sound_to_PowerCepstrogram and Sound_getCPPS analyse.
+*/
+static autoSound Sound_to_PowerCepstrogram_prepare (Sound me, double pitchFloor, double dt, double maximumFrequency, double preEmphasisFrequency,
+	double *windowDuration, long *nFrames, double *t1)
+{
+	// minimum analysis window has 3 periods of lowest pitch
+	double analysisWidth = 3.0  / pitchFloor;
+	*windowDuration = 2.0 * analysisWidth; /* gaussian window */
+
+	// Convenience: analyse the whole sound into one Cepstrogram_frame
+	if (*windowDuration > my dx * my nx) {
+		*windowDuration = my dx * my nx;
+	}
+	autoSound sound = Sound_resample (me, 2 * maximumFrequency, 50);
+	Sound_preEmphasis (sound.get(), preEmphasisFrequency);
+	Sampled_shortTermAnalysis (me, *windowDuration, dt, nFrames, t1);
+	return sound;
+}
+
+/*
+	One frame goes through the steps of Sound_to_Spectrum and Spectrum_to_PowerCepstrum.
+	On return, fft [1..nfft/2+1] contains the power cepstrum of the frame centred at time t.
+*/
+static void Sound_into_PowerCepstrum_frame (Sound sound, Sound window, double t, double windowDuration,
+	NUMfft_Table fftTable, long nfft, double *frame, double *fft)
+{
+	long nsamp_window = window -> nx, nq = nfft / 2 + 1;
+	double sampleScaling = window -> dx;   // the sample period of the frame, as in Sound_to_Spectrum
+	double frequencyScaling = 1.0 / (window -> dx * nfft);   // the frequency step of the spectrum, as in Spectrum_to_Sound
+	long index = Sampled_xToNearestIndex (sound, t - windowDuration / 2);   // as in Sound_into_Sound
+	double sum = 0.0;
+	for (long i = 1; i <= nsamp_window; i ++) {
+		long j = index - 1 + i;
+		frame [i] = j < 1 || j > sound -> nx ? 0 : sound -> z [1] [j];
+		sum += frame [i];
+	}
+	double mean = sum / nsamp_window;
+	for (long i = 1; i <= nsamp_window; i ++) {
+		fft [i] = (frame [i] - mean) * window -> z [1] [i];
+	}
+	for (long i = nsamp_window + 1; i <= nfft; i ++) {
+		fft [i] = 0.0;
+	}
+	NUMfft_forward (fftTable, fft);
+	/*
+		The log power spectrum, in the layout of NUMfft_backward:
+		the imaginary parts are zero, also after scaling.
+	*/
+	double re = fft [1] * sampleScaling;
+	fft [1] = log (re * re + 1e-300) * frequencyScaling;
+	for (long i = 2; i < nq; i ++) {
+		re = fft [i + i - 2] * sampleScaling;
+		double im = fft [i + i - 1] * sampleScaling;
+		fft [i + i - 2] = log (re * re + im * im + 1e-300) * frequencyScaling;
+		fft [i + i - 1] = 0.0;
+	}
+	re = fft [nfft] * sampleScaling;
+	fft [nfft] = log (re * re + 1e-300) * frequencyScaling;
+	NUMfft_backward (fftTable, fft);
+	for (long i = 1; i <= nq; i ++) {
+		fft [i] *= fft [i];
+	}
+}
+
 autoPowerCepstrogram Sound_to_PowerCepstrogram (Sound me, double pitchFloor, double dt, double maximumFrequency, double preEmphasisFrequency) {
 	try {
-		// minimum analysis window has 3 periods of lowest pitch
-		double analysisWidth = 3.0  / pitchFloor;
-		double windowDuration = 2.0 * analysisWidth; /* gaussian window */
+		double windowDuration, t1, samplingFrequency = 2 * maximumFrequency;
 		long nFrames;
-
-		// Convenience: analyse the whole sound into one Cepstrogram_frame
-		if (windowDuration > my dx * my nx) {
-			windowDuration = my dx * my nx;
-		}
-		double t1, samplingFrequency = 2 * maximumFrequency;
-		autoSound sound = Sound_resample (me, samplingFrequency, 50);
-		Sound_preEmphasis (sound.get(), preEmphasisFrequency);
-		Sampled_shortTermAnalysis (me, windowDuration, dt, & nFrames, & t1);
-		autoSound sframe = Sound_createSimple (1, windowDuration, samplingFrequency);
+		autoSound sound = Sound_to_PowerCepstrogram_prepare (me, pitchFloor, dt, maximumFrequency, preEmphasisFrequency, & windowDuration, & nFrames, & t1);
 		autoSound window = Sound_createGaussian (windowDuration, samplingFrequency);
+		long nsamp_window = window -> nx;
 		// find out the size of the FFT
 		long nfft = 2;
-		while (nfft < sframe -> nx) nfft *= 2;
+		while (nfft < nsamp_window) nfft *= 2;
 		long nq = nfft / 2 + 1;
 		double qmax = 0.5 * nfft / samplingFrequency, dq = qmax / (nq - 1);
 		autoPowerCepstrogram thee = PowerCepstrogram_create (my xmin, my xmax, nFrames, dt, t1, 0, qmax, nq, dq, 0);
 
 		autoMelderProgress progress (U"Cepstrogram analysis");
 
-		for (long iframe = 1; iframe <= nFrames; iframe++) {
-			double t = Sampled_indexToX (thee.get(), iframe);
-			Sound_into_Sound (sound.get(), sframe.get(), t - windowDuration / 2);
-			Vector_subtractMean (sframe.get());
-			Sounds_multiply (sframe.get(), window.get());
-			autoSpectrum spec = Sound_to_Spectrum (sframe.get(), 1); // FFT yes
-			autoPowerCepstrum cepstrum = Spectrum_to_PowerCepstrum (spec.get());
-			for (long i = 1; i <= nq; i++) {
-				thy z[i][iframe] = cepstrum -> z[1][i];
-			}
-			if ((iframe % 10) == 1) {
-				Melder_progress ((double) iframe / nFrames, U"PowerCepstrogram analysis of frame ",
-					iframe, U" out of ", nFrames, U".");
+		/*
+			The frames are analysed in buffers that every thread allocates only once.
+		*/
+		autoNUMfft_CachedTable fftTable (nfft);
+		const int numberOfThreads = MelderThread_getNumberOfThreadsToUse (nFrames, 10);
+		autoNUMmatrix <double> frames (0, numberOfThreads - 1, 1, nsamp_window);
+		autoNUMmatrix <double> ffts (0, numberOfThreads - 1, 1, nfft);
+		MelderThread_forRange (nFrames, numberOfThreads, 10,
+			[&] (long firstFrame, long lastFrame, int ithread) {
+				double *frame = frames [ithread], *fft = ffts [ithread];
+				for (long iframe = firstFrame; iframe <= lastFrame; iframe ++) {
+					Sound_into_PowerCepstrum_frame (sound.get(), window.get(), Sampled_indexToX (thee.get(), iframe), windowDuration,
+						fftTable.table, nfft, frame, fft);
+					for (long i = 1; i <= nq; i ++) {
+						thy z [i] [iframe] = fft [i];
+					}
+				}
+			},
+			[&] (double fractionDone) {
+				Melder_progress (fractionDone, U"PowerCepstrogram analysis of ", nFrames, U" frames.");
 			}
-		}
+		);
 		return thee;
 	} catch (MelderError) {
 		Melder_throw (me, U": no PowerCepstrogram created.");
 	}
 }
 
+double Sound_getCPPS (Sound me, double pitchFloor, double dt, double maximumFrequency, double preEmphasisFrequency,
+	bool subtractTiltBeforeSmoothing, double timeAveragingWindow, double quefrencyAveragingWindow,
+	double peakSearchPitchFloor, double peakSearchPitchCeiling, int interpolation, double qstartFit, double qendFit, int lineType, int fitMethod)
+{
+	try {
+		double windowDuration, t1, samplingFrequency = 2 * maximumFrequency;
+		long nFrames;
+		autoSound sound = Sound_to_PowerCepstrogram_prepare (me, pitchFloor, dt, maximumFrequency, preEmphasisFrequency, & windowDuration, & nFrames, & t1);
+		autoSound window = Sound_createGaussian (windowDuration, samplingFrequency);
+		long nsamp_window = window -> nx;
+		long nfft = 2;
+		while (nfft < nsamp_window) nfft *= 2;
+		long nq = nfft / 2 + 1;
+		double qmax = 0.5 * nfft / samplingFrequency, dq = qmax / (nq - 1);
+		/*
+			Output frame i is the average of the frames jfrom..jto, as in PowerCepstrogram_smooth (NUMvector_smoothByMovingAverage);
+			only the most recent frames are kept, in a ring that has room for one averaging window and one batch of new frames.
+			A frame in the ring is only overwritten after all the output frames that need it have been done.
+		*/
+		long numberOfAveragedFrames = (long) floor (timeAveragingWindow / dt);
+		if (numberOfAveragedFrames < 1) {
+			numberOfAveragedFrames = 1;   // averaging over one frame is no averaging
+		}
+		long numberOfQuefrencyBins = (long) floor (quefrencyAveragingWindow / dq);
+		long halfWindowBefore = numberOfAveragedFrames / 2;
+		long halfWindowAfter = numberOfAveragedFrames / 2 - (numberOfAveragedFrames % 2 == 0 ? 1 : 0);
+		const long batchSize = 100;
+		long ringSize = numberOfAveragedFrames + batchSize;
+		autoNUMmatrix <double> ring (0, ringSize - 1, 1, nq);
+		autoNUMvector <double> cpps (1, batchSize + numberOfAveragedFrames);
+
+		autoMelderProgress progress (U"CPPS analysis");
+
+		autoNUMfft_CachedTable fftTable (nfft);
+		const int numberOfThreads = MelderThread_getNumberOfThreadsToUse (batchSize, 10);
+		autoNUMmatrix <double> frames (0, numberOfThreads - 1, 1, nsamp_window);
+		autoNUMmatrix <double> ffts (0, numberOfThreads - 1, 1, nfft);
+		autoNUMmatrix <double> averages (0, numberOfThreads - 1, 1, nq);
+		std::vector <autoPowerCepstrum> cepstra (numberOfThreads);
+		for (int ithread = 0; ithread < numberOfThreads; ithread ++) {
+			cepstra [ithread] = PowerCepstrum_create (qmax, nq);
+		}
+		PowerCepstrum_checkTiltLineFitRange (cepstra [0].get(), qstartFit, qendFit, lineType);   // here rather than on the workers
+
+		long numberOfComputedFrames = 0, numberOfFinishedFrames = 0, numberOfDefinedFrames = 0;
+		double sum = 0.0;
+		while (numberOfFinishedFrames < nFrames) {
+			Melder_progress ((double) numberOfFinishedFrames / nFrames, U"CPPS analysis: frame ", numberOfFinishedFrames + 1, U" out of ", nFrames);
+			/*
+				Step 1: the next batch of power cepstra, with their tilt subtracted if so requested, as in PowerCepstrogram_subtractTilt.
+			*/
+			long firstNewFrame = numberOfComputedFrames + 1;
+			long lastNewFrame = numberOfComputedFrames + batchSize;
+			if (lastNewFrame > nFrames) lastNewFrame = nFrames;
+			MelderThread_forRange (lastNewFrame - firstNewFrame + 1, numberOfThreads, 10,
+				[&] (long firstItem, long lastItem, int ithread) {
+					double *frame = frames [ithread], *fft = ffts [ithread];
+					PowerCepstrum him = cepstra [ithread].get();
+					for (long item = firstItem; item <= lastItem; item ++) {
+						long iframe = firstNewFrame - 1 + item;
+						Sound_into_PowerCepstrum_frame (sound.get(), window.get(), t1 + (iframe - 1) * dt, windowDuration,
+							fftTable.table, nfft, frame, fft);
+						double *row = ring [(iframe - 1) % ringSize];
+						if (subtractTiltBeforeSmoothing) {
+							NUMvector_copyElements (fft, his z [1], 1, nq);
+							PowerCepstrum_subtractTilt_inline (him, qstartFit, qendFit, lineType, fitMethod);
+							NUMvector_copyElements (his z [1], row, 1, nq);
+						} else {
+							NUMvector_copyElements (fft, row, 1, nq);
+						}
+					}
+				}
+			);
+			numberOfComputedFrames = lastNewFrame;
+			/*
+				Step 2: the peak prominence of every output frame whose averaging window is now complete.
+			*/
+			long firstOutputFrame = numberOfFinishedFrames + 1;
+			long lastOutputFrame = numberOfComputedFrames == nFrames ? nFrames : numberOfComputedFrames - halfWindowAfter;
+			if (lastOutputFrame < firstOutputFrame) {
+				continue;
+			}
+			MelderThread_forRange (lastOutputFrame - firstOutputFrame + 1, numberOfThreads, 10,
+				[&] (long firstItem, long lastItem, int ithread) {
+					double *average = averages [ithread];
+					PowerCepstrum him = cepstra [ithread].get();
+					for (long item = firstItem; item <= lastItem; item ++) {
+						long iframe = firstOutputFrame - 1 + item;
+						long jfrom = iframe - halfWindowBefore, jto = iframe + halfWindowAfter;
+						if (jfrom < 1) jfrom = 1;
+						if (jto > nFrames) jto = nFrames;
+						for (long iq = 1; iq <= nq; iq ++) {
+							average [iq] = 0.0;
+						}
+						for (long j = jfrom; j <= jto; j ++) {
+							const double *row = ring [(j - 1) % ringSize];
+							for (long iq = 1; iq <= nq; iq ++) {
+								average [iq] += row [iq];
+							}
+						}
+						for (long iq = 1; iq <= nq; iq ++) {
+							average [iq] /= jto - jfrom + 1;
+						}
+						if (numberOfQuefrencyBins > 1) {
+							NUMvector_smoothByMovingAverage (average, nq, numberOfQuefrencyBins, his z [1]);
+						} else {
+							NUMvector_copyElements (average, his z [1], 1, nq);
+						}
+						cpps [item] = PowerCepstrum_getPeakProminence (him, peakSearchPitchFloor, peakSearchPitchCeiling, interpolation,
+							qstartFit, qendFit, lineType, fitMethod, nullptr);
+					}
+				}
+			);
+			/*
+				The sum in the order of the frames, as in PowerCepstrogram_getCPPS; frames without a defined peak prominence are skipped.
+			*/
+			for (long iframe = firstOutputFrame; iframe <= lastOutputFrame; iframe ++) {
+				double cpp = cpps [iframe - firstOutputFrame + 1];
+				if (NUMdefined (cpp)) {
+					sum += cpp;
+					numberOfDefinedFrames ++;
+				}
+			}
+			numberOfFinishedFrames = lastOutputFrame;
+		}
+		return numberOfDefinedFrames > 0 ? sum / numberOfDefinedFrames : NUMundefined;
+	} catch (MelderError) {
+		Melder_throw (me, U": no CPPS value calculated.");
+	}
+}
+
 autoCepstrum Spectrum_to_Cepstrum_hillenbrand (Spectrum me);
 autoCepstrum Spectrum_to_Cepstrum_hillenbrand (Spectrum me) {
 	try {
@@ -464,8 +659,19 @@ double PowerCepstrogram_getCPPS (PowerCepstrogram me, bool subtractTiltBeforeSmo
 		}
 		autoPowerCepstrogram smooth = PowerCepstrogram_smooth (flattened ? flattened.get() : me, timeAveragingWindow, quefrencyAveragingWindow);
 		autoTable table = PowerCepstrogram_to_Table_cpp (smooth.get(), pitchFloor, pitchCeiling, deltaF0, interpolation, qstartFit, qendFit, lineType, fitMethod);
-		double cpps = Table_getMean (table.get(), 3);
-		return cpps;
+		/*
+			The mean over the frames that have a defined peak prominence (e.g. not in silence).
+		*/
+		double sum = 0.0;
+		long numberOfDefinedFrames = 0;
+		for (long irow = 1; irow <= table -> rows.size; irow ++) {
+			double cpp = Table_getNumericValue_Assert (table.get(), irow, 3);
+			if (NUMdefined (cpp)) {
+				sum += cpp;
+				numberOfDefinedFrames ++;
+			}
+		}
+		return numberOfDefinedFrames > 0 ? sum / numberOfDefinedFrames : NUMundefined;
 	} catch (MelderError) {
 		Melder_throw (me, U": no CPPS value calculated.");
 	}
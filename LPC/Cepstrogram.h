@@ -73,6 +73,17 @@ void PowerCepstrogram_subtractTilt_inline (PowerCepstrogram me, double qstartFit
 double PowerCepstrogram_getCPPS_hillenbrand (PowerCepstrogram me, bool subtractTiltBeforeSmoothing, double timeAveragingWindow, double quefrencyAveragingWindow, double pitchFloor, double pitchCeiling);
 
 double PowerCepstrogram_getCPPS (PowerCepstrogram me, bool subtractTiltBeforeSmoothing, double timeAveragingWindow, double quefrencyAveragingWindow, double pitchFloor, double pitchCeiling, double deltaF0, int interpolation, double qstartFit, double qendFit, int lineType, int fitMethod);
+/*
+	The mean cepstral peak prominence over the frames where it is defined; undefined if it is defined in no frame.
+*/
+
+double Sound_getCPPS (Sound me, double pitchFloor, double dt, double maximumFrequency, double preEmphasisFrequency,
+	bool subtractTiltBeforeSmoothing, double timeAveragingWindow, double quefrencyAveragingWindow,
+	double peakSearchPitchFloor, double peakSearchPitchCeiling, int interpolation, double qstartFit, double qendFit, int lineType, int fitMethod);
+/*
+	The value of Sound_to_PowerCepstrogram followed by PowerCepstrogram_getCPPS, computed frame by frame:
+	only the frames within one time averaging window are kept in memory, not the whole (smoothed) PowerCepstrogram.
+*/
 
 autoMatrix PowerCepstrogram_to_Matrix (PowerCepstrogram me);
 
@@ -215,18 +215,34 @@ void PowerCepstrum_drawTiltLine (PowerCepstrum me, Graphics g, double qmin, doub
  * method == 1 : Least squares fit
  * method == 2 : Theil's partial robust fit
  */
+/*
+	The quefrency samples imin..imax that the tilt line is fitted through; returns 0 if there are none.
+*/
+static long PowerCepstrum_getTiltLineFitSamples (PowerCepstrum me, double qmin, double qmax, int lineType, long *imin, long *imax) {
+	if (qmax <= qmin) {
+		qmin = my xmin; qmax = my xmax;
+	}
+	if (! Matrix_getWindowSamplesX (me, qmin, qmax, imin, imax)) {
+		return 0;
+	}
+	*imin = (lineType == 2 && *imin == 1) ? 2 : *imin; // log(0) is undefined!
+	return *imax - *imin + 1;
+}
+
+void PowerCepstrum_checkTiltLineFitRange (PowerCepstrum me, double qmin, double qmax, int lineType) {
+	long imin, imax;
+	if (PowerCepstrum_getTiltLineFitSamples (me, qmin, qmax, lineType, & imin, & imax) < 2) {
+		Melder_throw (U"Not enough points for fit.");
+	}
+}
+
 void PowerCepstrum_fitTiltLine (PowerCepstrum me, double qmin, double qmax, double *a, double *intercept, int lineType, int method) {
 	try {
-		if (qmax <= qmin) {
-			qmin = my xmin; qmax = my xmax;
-		}
-
 		long imin, imax;
-		if (! Matrix_getWindowSamplesX (me, qmin, qmax, & imin, & imax)) {
+		long numberOfPoints = PowerCepstrum_getTiltLineFitSamples (me, qmin, qmax, lineType, & imin, & imax);
+		if (numberOfPoints == 0) {
 			return;
 		}
-		imin = (lineType == 2 && imin == 1) ? 2 : imin; // log(0) is undefined!
-		long numberOfPoints = imax - imin + 1;
 		if (numberOfPoints < 2) {
 			Melder_throw (U"Not enough points for fit.");
 		}
@@ -25,6 +25,8 @@
 #include "LPC_and_Formant.h"
 #include "LPC_and_Polynomial.h"
 #include "NUM2.h"
+#include "MelderThread.h"
+#include <vector>
 
 void Formant_Frame_init (Formant_Frame me, long nFormants) {
 	my nFormants = nFormants;
@@ -83,11 +85,35 @@ void LPC_Frame_into_Formant_Frame (LPC_Frame me, Formant_Frame thee, double samp
 	Roots_into_Formant_Frame (r.get(), thee, 1 / samplingPeriod, margin);
 }
 
+/*
+	As LPC_Frame_into_Formant_Frame, but starting from the roots of the previous frame, if any;
+	only if these cannot be refined into the roots of this frame are the roots computed from scratch.
+	On return, roots contains the roots of this frame, moved into the unit circle, or nullptr if none could be found.
+	Runs on worker threads, so issues no messages: returns false if not all roots could be found.
+*/
+static bool LPC_Frame_into_Formant_Frame_tracking (LPC_Frame me, Formant_Frame thee, double samplingPeriod, double margin, autoRoots & roots) {
+	thy intensity = my gain;
+	if (my nCoefficients == 0) {
+		roots.reset();
+		return true;
+	}
+	autoPolynomial p = LPC_Frame_to_Polynomial (me);
+	bool allRootsFound = true;
+	if (! roots || ! Roots_and_Polynomial_refine (roots.get(), p.get(), 20)) {
+		roots = Polynomial_to_Roots_quiet (p.get(), & allRootsFound);
+		if (! roots) {
+			return false;
+		}
+	}
+	Roots_fixIntoUnitCircle (roots.get());
+	Roots_into_Formant_Frame (roots.get(), thee, 1 / samplingPeriod, margin);
+	return allRootsFound;
+}
+
 autoFormant LPC_to_Formant (LPC me, double margin) {
 	try {
 		double samplingFrequency = 1.0 / my samplingPeriod;
-		long nmax = my maxnCoefficients, err = 0;
-		long interval = nmax > 20 ? 1 : 10;
+		long nmax = my maxnCoefficients;
 
 		if (nmax > 99) {
 			Melder_throw (U"We cannot find the roots of a polynomial of order > 99.");
@@ -100,23 +126,51 @@ autoFormant LPC_to_Formant (LPC me, double margin) {
 
 		autoMelderProgress progress (U"LPC to Formant");
 
-		for (long i = 1; i <= my nx; i++) {
-			Formant_Frame formant = & thy d_frames[i];
-			LPC_Frame lpc = & my d_frames[i];
-
-			// Initialisation of Formant_Frame is taken care of in Roots_into_Formant_Frame!
-
-			try {
-				LPC_Frame_into_Formant_Frame (lpc, formant, my samplingPeriod, margin);
-			} catch (MelderError) {
-				Melder_clearError();
-				err++;
-			}
-
-			if ( (interval == 1 || (i % interval) == 1)) {
-				Melder_progress ( (double) i / my nx, U"LPC to Formant: frame ", i,
+		/*
+			The roots of successive frames lie close together, so each frame starts from the roots of the previous one.
+			The frames are divided into blocks whose first frame is always solved from scratch;
+			the threads work on whole blocks, so that the result does not depend on the number of threads.
+		*/
+		const long blockSize = 16;
+		long numberOfBlocks = (my nx - 1) / blockSize + 1;
+		const int numberOfThreads = MelderThread_getNumberOfThreadsToUse (numberOfBlocks, 2);
+		std::vector <long> frameErrorCounts (numberOfThreads, 0);
+		MelderThread_forRange (numberOfBlocks, numberOfThreads, 1,
+			[&] (long firstBlock, long lastBlock, int ithread) {
+				for (long iblock = firstBlock; iblock <= lastBlock; iblock ++) {
+					long firstFrame = (iblock - 1) * blockSize + 1, lastFrame = iblock * blockSize;
+					if (lastFrame > my nx) {
+						lastFrame = my nx;
+					}
+					autoRoots roots;
+					for (long i = firstFrame; i <= lastFrame; i++) {
+						Formant_Frame formant = & thy d_frames[i];
+						LPC_Frame lpc = & my d_frames[i];
+
+						// Initialisation of Formant_Frame is taken care of in Roots_into_Formant_Frame!
+
+						try {
+							if (! LPC_Frame_into_Formant_Frame_tracking (lpc, formant, my samplingPeriod, margin, roots)) {
+								frameErrorCounts [ithread] ++;
+							}
+						} catch (MelderError) {
+							roots.reset();
+							frameErrorCounts [ithread] ++;   // the error buffer is cleared on the main thread below
+						}
+					}
+				}
+			},
+			[&] (double fractionDone) {
+				Melder_progress (fractionDone, U"LPC to Formant: frame ", (long) floor (fractionDone * my nx),
 				                   U" out of ", my nx, U".");
 			}
+		);
+		long err = 0;
+		for (int ithread = 0; ithread < numberOfThreads; ithread ++) {
+			err += frameErrorCounts [ithread];
+		}
+		if (err > 0) {
+			Melder_clearError ();
 		}
 
 		Formant_sort (thee.get());
@@ -30,6 +30,8 @@
 #include "Vector.h"
 #include "Spectrum.h"
 #include "NUM2.h"
+#include "MelderThread.h"
+#include <vector>
 
 #define LPC_METHOD_AUTO 1
 #define LPC_METHOD_COVAR 2
@@ -71,13 +73,14 @@ void LPC_Frame_and_Sound_filterInverse (LPC_Frame me, Sound thee, int channel) {
 	}
 }
 
-static int Sound_into_LPC_Frame_auto (Sound me, LPC_Frame thee) {
+static int Sound_into_LPC_Frame_auto (Sound me, LPC_Frame thee, double *work) {
 	long i = 1; // For error condition at end
 	long m = thy nCoefficients;
 
-	autoNUMvector<double> r (1, m + 1);
-	autoNUMvector<double> a (1, m + 1);
-	autoNUMvector<double> rc (1, m);
+	double *r = work, *a = work + m + 1, *rc = work + m + 1 + m + 1;
+	for (long j = 1; j <= m + 1 + m + 1 + m; j++) {
+		work[j] = 0.0;
+	}
 
 	double  *x = my z[1];
 	for (i = 1; i <= m + 1; i++) {
@@ -130,15 +133,14 @@ end:
 	cc = & work[m+1)/2+m+m+1+m+1]
 	for (i=1; i<=m(m+1)/2+m+m+1+m+m+1;i++) work[i] = 0;
 */
-static int Sound_into_LPC_Frame_covar (Sound me, LPC_Frame thee) {
+static int Sound_into_LPC_Frame_covar (Sound me, LPC_Frame thee, double *work) {
 	long i = 1, n = my nx, m = thy nCoefficients;
 	double *x = my z[1];
 
-	autoNUMvector<double> b (1, m * (m + 1) / 2);
-	autoNUMvector<double> grc (1, m);
-	autoNUMvector<double> a (1, m + 1);
-	autoNUMvector<double> beta (1, m);
-	autoNUMvector<double> cc (1, m + 1);
+	double *b = work, *grc = work + m * (m + 1) / 2, *a = grc + m, *beta = a + m + 1, *cc = beta + m;
+	for (long j = 1; j <= m * (m + 1) / 2 + m + m + 1 + m + m + 1; j++) {
+		work[j] = 0.0;
+	}
 
 	thy gain = 0.0;
 	for (i = m + 1; i <= n; i++) {
@@ -223,8 +225,11 @@ end:
 	return 0; // Melder_warning ("Less coefficienst than asked for.");
 }
 
-static int Sound_into_LPC_Frame_burg (Sound me, LPC_Frame thee) {
-	int status = NUMburg (my z[1], my nx, thy a, thy nCoefficients, &thy gain);
+/*
+	work[1..n+n+m]
+*/
+static int Sound_into_LPC_Frame_burg (Sound me, LPC_Frame thee, double *work) {
+	int status = NUMburg_preallocated (my z[1], my nx, thy a, thy nCoefficients, &thy gain, work, work + my nx, work + my nx + my nx);
 	thy gain *= my nx;
 	for (long i = 1; i <= thy nCoefficients; i++) {
 		thy a[i] = -thy a[i];
@@ -232,14 +237,18 @@ static int Sound_into_LPC_Frame_burg (Sound me, LPC_Frame thee) {
 	return status;
 }
 
-static int Sound_into_LPC_Frame_marple (Sound me, LPC_Frame thee, double tol1, double tol2) {
+/*
+	work[1..3*(mmax+1)]
+*/
+static int Sound_into_LPC_Frame_marple (Sound me, LPC_Frame thee, double tol1, double tol2, double *work) {
 	long m = 1, n = my nx, mmax = thy nCoefficients;
 	int status = 1;
 	double *a = thy a, *x = my z[1];
 
-	autoNUMvector<double> c (1, mmax + 1);
-	autoNUMvector<double> d (1, mmax + 1);
-	autoNUMvector<double> r (1, mmax + 1);
+	double *c = work, *d = work + mmax + 1, *r = work + mmax + 1 + mmax + 1;
+	for (long k = 1; k <= 3 * (mmax + 1); k++) {
+		work[k] = 0.0;
+	}
 	double e0 = 0.0;
 	for (long k = 1; k <= n; k++) {
 		e0 += x[k] * x[k];
@@ -368,10 +377,43 @@ end:
 	return status == 1 || status == 4 || status == 5;
 }
 
+long Sound_into_LPC_frames (Sound me, LPC thee, Sound window, int numberOfThreads,
+	const std::function <bool (Sound frame, LPC_Frame lpcFrame, long iframe, int threadNumber)>& analyse)
+{
+	double windowDuration = window -> xmax - window -> xmin;
+	std::vector <autoSound> sframes (numberOfThreads);
+	for (int ithread = 0; ithread < numberOfThreads; ithread ++) {
+		sframes [ithread] = Data_copy (window);
+	}
+	std::vector <long> frameErrorCounts (numberOfThreads, 0);
+	MelderThread_forRange (thy nx, numberOfThreads, 10,
+		[&] (long firstFrame, long lastFrame, int ithread) {
+			Sound sframe = sframes [ithread].get();
+			for (long iframe = firstFrame; iframe <= lastFrame; iframe ++) {
+				double t = Sampled_indexToX (thee, iframe);
+				Sound_into_Sound (me, sframe, t - windowDuration / 2);
+				Vector_subtractMean (sframe);
+				Sounds_multiply (sframe, window);
+				if (! analyse (sframe, (LPC_Frame) & thy d_frames [iframe], iframe, ithread)) {
+					frameErrorCounts [ithread] ++;
+				}
+			}
+		},
+		[&] (double fractionDone) {
+			Melder_progress (fractionDone, U"LPC analysis of ", thy nx, U" frames.");
+		}
+	);
+	long frameErrorCount = 0;
+	for (int ithread = 0; ithread < numberOfThreads; ithread ++) {
+		frameErrorCount += frameErrorCounts [ithread];
+	}
+	return frameErrorCount;
+}
+
 static autoLPC _Sound_to_LPC (Sound me, int predictionOrder, double analysisWidth, double dt, double preEmphasisFrequency, int method, double tol1, double tol2) {
 	double t1, samplingFrequency = 1.0 / my dx;
 	double windowDuration = 2 * analysisWidth; /* gaussian window */
-	long nFrames, frameErrorCount = 0;
+	long nFrames;
 
 	if (floor (windowDuration / my dx) < predictionOrder + 1) {
 		Melder_throw (U"Analysis window duration too short.\n For a prediction order of ", predictionOrder,
@@ -383,7 +425,6 @@ static autoLPC _Sound_to_LPC (Sound me, int predictionOrder, double analysisWidt
 	}
 	Sampled_shortTermAnalysis (me, windowDuration, dt, & nFrames, & t1);
 	autoSound sound = Data_copy (me);
-	autoSound sframe = Sound_createSimple (1, windowDuration, samplingFrequency);
 	autoSound window = Sound_createGaussian (windowDuration, samplingFrequency);
 	autoLPC thee = LPC_create (my xmin, my xmax, nFrames, dt, t1, predictionOrder, my dx);
 
@@ -393,34 +434,26 @@ static autoLPC _Sound_to_LPC (Sound me, int predictionOrder, double analysisWidt
 		Sound_preEmphasis (sound.get(), preEmphasisFrequency);
 	}
 
-	for (long i = 1; i <= nFrames; i++) {
-		LPC_Frame lpcframe = (LPC_Frame) & thy d_frames[i];
-		double t = Sampled_indexToX (thee.get(), i);
-		LPC_Frame_init (lpcframe, predictionOrder);
-		Sound_into_Sound (sound.get(), sframe.get(), t - windowDuration / 2);
-		Vector_subtractMean (sframe.get());
-		Sounds_multiply (sframe.get(), window.get());
-		if (method == LPC_METHOD_AUTO) {
-			if (! Sound_into_LPC_Frame_auto (sframe.get(), lpcframe)) {
-				frameErrorCount++;
-			}
-		} else if (method == LPC_METHOD_COVAR) {
-			if (! Sound_into_LPC_Frame_covar (sframe.get(), lpcframe)) {
-				frameErrorCount++;
-			}
-		} else if (method == LPC_METHOD_BURG) {
-			if (! Sound_into_LPC_Frame_burg (sframe.get(), lpcframe)) {
-				frameErrorCount++;
-			}
-		} else if (method == LPC_METHOD_MARPLE) {
-			if (! Sound_into_LPC_Frame_marple (sframe.get(), lpcframe, tol1, tol2)) {
-				frameErrorCount++;
+	/*
+		One work vector per thread, large enough for each of the methods.
+	*/
+	long m = predictionOrder, n = window -> nx;
+	const int numberOfThreads = MelderThread_getNumberOfThreadsToUse (nFrames, 10);
+	autoNUMmatrix <double> work (0, numberOfThreads - 1, 1, m * (m + 1) / 2 + m + m + 1 + m + m + 1 + n + n);
+	Sound_into_LPC_frames (sound.get(), thee.get(), window.get(), numberOfThreads,
+		[&] (Sound sframe, LPC_Frame lpcframe, long /* iframe */, int ithread) -> bool {
+			LPC_Frame_init (lpcframe, predictionOrder);
+			if (method == LPC_METHOD_AUTO) {
+				return Sound_into_LPC_Frame_auto (sframe, lpcframe, work [ithread]);
+			} else if (method == LPC_METHOD_COVAR) {
+				return Sound_into_LPC_Frame_covar (sframe, lpcframe, work [ithread]);
+			} else if (method == LPC_METHOD_BURG) {
+				return Sound_into_LPC_Frame_burg (sframe, lpcframe, work [ithread]);
+			} else {
+				return Sound_into_LPC_Frame_marple (sframe, lpcframe, tol1, tol2, work [ithread]);
 			}
 		}
-		if ((i % 10) == 1) {
-			Melder_progress ( (double) i / nFrames, U"LPC analysis of frame ", i, U" out of ", nFrames, U".");
-		}
-	}
+	);
 	return thee;
 }
 
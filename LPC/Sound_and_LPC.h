@@ -27,6 +27,7 @@
 
 #include "LPC.h"
 #include "Sound.h"
+#include <functional>
 
 autoLPC Sound_to_LPC_auto (Sound me, int predictionOrder, double analysisWidth, double dt, double preEmphasisFrequency);
 
@@ -36,6 +37,17 @@ autoLPC Sound_to_LPC_burg (Sound me, int predictionOrder, double analysisWidth,
 
 autoLPC Sound_to_LPC_marple (Sound me, int predictionOrder, double analysisWidth, double dt, double preEmphasisFrequency, double tol1, double tol2);
 
+long Sound_into_LPC_frames (Sound me, LPC thee, Sound window, int numberOfThreads,
+	const std::function <bool (Sound frame, LPC_Frame lpcFrame, long iframe, int threadNumber)>& analyse);
+/*
+	The frame loop of the LPC analyses.
+	For every frame of `thee`, the part of `me` around the time of the frame is copied into a Sound as long as `window`,
+	its mean is subtracted and it is multiplied by `window`; then `analyse` computes the frame from it.
+	The frames are divided over at most `numberOfThreads` threads (see MelderThread_forRange),
+	and `analyse` should only use the workspace that belongs to `threadNumber`, so that the result does not depend on the division.
+	Returns the number of frames for which `analyse` returned false.
+*/
+
 /*
  * Function:
  *	Calculate linear prediction coefficients according to following model:
@@ -33,6 +33,8 @@
 #include "SVD.h"
 #include "Vector.h"
 #include "NUM2.h"
+#include "MelderThread.h"
+#include <vector>
 
 struct huber_struct {
 	autoSound e;
@@ -109,7 +111,7 @@ static void huber_struct_getWeightedCovars (struct huber_struct *hs, double *s)
 	}
 }
 
-static void huber_struct_solvelpc (struct huber_struct *hs) {
+static bool huber_struct_solvelpc (struct huber_struct *hs) {
 	SVD me = hs -> svd.get();
 	double **covar = hs -> covar;
 
@@ -120,14 +122,17 @@ static void huber_struct_solvelpc (struct huber_struct *hs) {
 	}
 
 	SVD_setTolerance (me, hs -> tol_svd);
-	SVD_compute (me);
+	if (! SVD_compute_quiet (me)) {
+		return false;
+	}
 
 	//long nzeros = SVD_zeroSmallSingularValues (me, 0);
 
 	SVD_solve (me, hs -> c, hs -> a);
+	return true;
 }
 
-void LPC_Frames_and_Sound_huber (LPC_Frame me, Sound thee, LPC_Frame him, struct huber_struct *hs) {
+bool LPC_Frames_and_Sound_huber (LPC_Frame me, Sound thee, LPC_Frame him, struct huber_struct *hs) {
 	long p = my nCoefficients > his nCoefficients ? his nCoefficients : my nCoefficients;
 	long n = hs -> e -> nx > thy nx ? thy nx : hs -> e -> nx;
 	double *e = hs -> e -> z[1], *s = thy z[1];
@@ -146,20 +151,20 @@ void LPC_Frames_and_Sound_huber (LPC_Frame me, Sound thee, LPC_Frame him, struct
 
 		s0 = hs -> scale;
 
-		NUMstatistics_huber (e, n, & (hs -> location), hs -> wantlocation, & (hs -> scale), hs -> wantscale, hs -> k, hs -> tol, hs -> work);
+		if (! NUMstatistics_huber_quiet (e, n, & (hs -> location), hs -> wantlocation, & (hs -> scale), hs -> wantscale, hs -> k, hs -> tol, hs -> work)) {
+			return false;   // scale is zero
+		}
 
 		huber_struct_getWeights (hs, e);
 		huber_struct_getWeightedCovars (hs, s);
 
 		// Solve C a = [-] c */
-		try {
-			huber_struct_solvelpc (hs);
-		} catch (MelderError) {
+		if (! huber_struct_solvelpc (hs)) {
 			// Copy the starting lpc coeffs */
 			for (long i = 1; i <= p; i++) {
 				his a[i] = my a[i];
 			}
-			throw MelderError();
+			return false;
 		}
 		for (long i = 1; i <= p; i++) {
 			his a[i] = hs -> a[i];
@@ -167,6 +172,7 @@ void LPC_Frames_and_Sound_huber (LPC_Frame me, Sound thee, LPC_Frame him, struct
 
 		(hs -> iter) ++;
 	} while ( (hs -> iter < hs -> itermax) && (fabs (s0 - hs -> scale) > hs -> tol * s0));
+	return true;
 }
 
 #if 0
@@ -184,11 +190,11 @@ void LPC_Frames_and_Sound_huber (LPC_Frame me, Sound thee, LPC_Frame him, struct
 	
 autoLPC LPC_and_Sound_to_LPC_robust (LPC thee, Sound me, double analysisWidth, double preEmphasisFrequency, double k,
 	int itermax, double tol, int wantlocation) {
-	struct huber_struct struct_huber { autoSound(), 0.0, 0.0, 0.0, 0, 0, 0, 0, 0.0, 0.0, 0, 0, nullptr, nullptr, nullptr, nullptr, nullptr, autoSVD() };
+	std::vector <struct huber_struct> hubers;   // one per thread
 	try {
 		double t1, samplingFrequency = 1.0 / my dx, tol_svd = 0.000001;
 		double location = 0, windowDuration = 2 * analysisWidth; /* Gaussian window */
-		long nFrames, frameErrorCount = 0, iter = 0;
+		long nFrames;
 		long p = thy maxnCoefficients;
 
 		if (my xmin != thy xmin || my xmax != thy xmax) {
@@ -206,50 +212,57 @@ autoLPC LPC_and_Sound_to_LPC_robust (LPC thee, Sound me, double analysisWidth, d
 		}
 
 		autoSound sound = Data_copy (me);
-		autoSound sframe = Sound_createSimple (1, windowDuration, samplingFrequency);
 		autoSound window = Sound_createGaussian (windowDuration, samplingFrequency);
 		autoLPC him = Data_copy (thee);
-		huber_struct_init (&struct_huber, windowDuration, p, samplingFrequency, location, wantlocation);
-
-		struct_huber.k = k;
-		struct_huber.tol = tol;
-		struct_huber.tol_svd = tol_svd;
-		struct_huber.itermax = itermax;
+		const int numberOfThreads = MelderThread_getNumberOfThreadsToUse (nFrames, 10);
+		hubers.resize (numberOfThreads);
+		for (int ithread = 0; ithread < numberOfThreads; ithread ++) {
+			struct huber_struct *hs = & hubers [ithread];
+			huber_struct_init (hs, windowDuration, p, samplingFrequency, location, wantlocation);
+			hs -> k = k;
+			hs -> tol = tol;
+			hs -> tol_svd = tol_svd;
+			hs -> itermax = itermax;
+		}
+		std::vector <long> iters (numberOfThreads, 0);
 
 		autoMelderProgress progess (U"LPC analysis");
 
 		Sound_preEmphasis (sound.get(), preEmphasisFrequency);
 
-		for (long i = 1; i <= nFrames; i++) {
-			LPC_Frame lpc = (LPC_Frame) & thy d_frames[i];
-			LPC_Frame lpcto = (LPC_Frame) & his d_frames[i];
-			double t = Sampled_indexToX (thee, i);
-
-			Sound_into_Sound (sound.get(), sframe.get(), t - windowDuration / 2);
-			Vector_subtractMean (sframe.get());
-			Sounds_multiply (sframe.get(), window.get());
-
-			try {
-				LPC_Frames_and_Sound_huber (lpc, sframe.get(), lpcto, & struct_huber);
-			} catch (MelderError) {
-				frameErrorCount++;
-			}
-
-			iter += struct_huber.iter;
-
-			if ( (i % 10) == 1) {
-				Melder_progress ( (double) i / nFrames, U"LPC analysis of frame ", i, U" out of ", nFrames, U".");
+		/*
+			The input LPC is only read, and every frame starts the iteration afresh,
+			so that the result does not depend on how the frames are divided over the threads.
+		*/
+		long frameErrorCount = Sound_into_LPC_frames (sound.get(), thee, window.get(), numberOfThreads,
+			[&] (Sound sframe, LPC_Frame lpc, long iframe, int ithread) -> bool {
+				LPC_Frame lpcto = (LPC_Frame) & his d_frames[iframe];
+				struct huber_struct *hs = & hubers [ithread];
+				bool ok = LPC_Frames_and_Sound_huber (lpc, sframe, lpcto, hs);   // no error messages on worker threads
+				iters [ithread] += hs -> iter;
+				return ok;
 			}
+		);
+		long iter = 0;
+		for (int ithread = 0; ithread < numberOfThreads; ithread ++) {
+			iter += iters [ithread];
 		}
 
-		if (frameErrorCount) Melder_warning (U"Results of ", frameErrorCount,
-			U" frame(s) out of ", nFrames, U" could not be optimised.");
+		if (frameErrorCount) {
+			Melder_clearError ();
+			Melder_warning (U"Results of ", frameErrorCount,
+				U" frame(s) out of ", nFrames, U" could not be optimised.");
+		}
 		MelderInfo_writeLine (U"Number of iterations: ", iter,
 			U"\n   Average per frame: ", ((double) iter) / nFrames);
-		huber_struct_destroy (&struct_huber);
+		for (int ithread = 0; ithread < numberOfThreads; ithread ++) {
+			huber_struct_destroy (& hubers [ithread]);
+		}
 		return him;
 	} catch (MelderError) {
-		huber_struct_destroy (&struct_huber);
+		for (size_t ithread = 0; ithread < hubers.size (); ithread ++) {
+			huber_struct_destroy (& hubers [ithread]);
+		}
 		Melder_throw (me, U": no robust LPC created.");
 	}
 }
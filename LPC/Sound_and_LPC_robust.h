@@ -27,7 +27,10 @@
 #include "Formant.h"
 #include "Sound.h"
 
-void LPC_Frames_and_Sound_huber (LPC_Frame me, Sound thee, LPC_Frame him, struct huber_struct *hs);
+bool LPC_Frames_and_Sound_huber (LPC_Frame me, Sound thee, LPC_Frame him, struct huber_struct *hs);
+/* Returns false, without an error message, if the frame could not be optimised
+	(zero scale or no SVD solution), so that it can be used on worker threads.
+*/
 /*int LPC_Frames_and_Sound_huber (LPC_Frame me, Sound thee, LPC_Frame him, void *huber);
 	The gnu c compiler (version 3.3.1) complaints about having two LPC_Frame types
 	in the argument list:
@@ -990,6 +990,47 @@ DO
 	}
 END2 }
 	
+FORM (Sound_getCPPS, U"Sound: Get CPPS", nullptr) {
+	LABEL (U"", U"Analysis:")
+	POSITIVE (U"Pitch floor (Hz)", U"60.0")
+	POSITIVE (U"Time step (s)", U"0.002")
+	POSITIVE (U"Maximum frequency (Hz)", U"5000.0")
+	POSITIVE (U"Pre-emphasis from (Hz)", U"50")
+	LABEL (U"", U"Smoothing:")
+	BOOLEAN (U"Subtract tilt before smoothing", true)
+	REAL (U"Time averaging window (s)", U"0.001")
+	REAL (U"Quefrency averaging window (s)", U"0.00005")
+	LABEL (U"", U"Peak search:")
+	REAL (U"left Peak search pitch range (Hz)", U"60.0")
+	REAL (U"right Peak search pitch range (Hz)", U"330.0")
+	RADIO (U"Interpolation", 2)
+	RADIOBUTTON (U"None")
+	RADIOBUTTON (U"Parabolic")
+	RADIOBUTTON (U"Cubic")
+	RADIOBUTTON (U"Sinc70")
+	LABEL (U"", U"Tilt line:")
+	REAL (U"left Tilt line quefrency range (s)", U"0.001")
+	REAL (U"right Tilt line quefrency range (s)", U"0.0 (= end)")
+	OPTIONMENU (U"Line type", 2)
+	OPTION (U"Straight")
+	OPTION (U"Exponential decay")
+	OPTIONMENU (U"Fit method", 2)
+	OPTION (U"Least squares")
+	OPTION (U"Robust")
+	OK2
+DO
+	LOOP {
+		iam (Sound);
+		double cpps = Sound_getCPPS (me, GET_REAL (U"Pitch floor"), GET_REAL (U"Time step"), GET_REAL (U"Maximum frequency"),
+			GET_REAL (U"Pre-emphasis from"), GET_INTEGER (U"Subtract tilt before smoothing"), GET_REAL (U"Time averaging window"),
+			GET_REAL (U"Quefrency averaging window"),
+			GET_REAL (U"left Peak search pitch range"), GET_REAL (U"right Peak search pitch range"),
+			GET_INTEGER (U"Interpolation") - 1, GET_REAL (U"left Tilt line quefrency range"), GET_REAL (U"right Tilt line quefrency range"),
+			GET_INTEGER (U"Line type"), GET_INTEGER (U"Fit method"));
+		Melder_informationReal (cpps, U" dB");
+	}
+END2 }
+
 FORM (Sound_to_Formant_robust, U"Sound: To Formant (robust)", U"Sound: To Formant (robust)...") {
 	REAL (U"Time step (s)", U"0.0 (= auto)")
 	POSITIVE (U"Max. number of formants", U"5.0")
@@ -1384,6 +1425,7 @@ void praat_uvafon_LPC_init () {
 	praat_addAction1 (classSound, 0, U"To Formant (robust)...", U"To Formant (sl)...", 2, DO_Sound_to_Formant_robust);
 	praat_addAction1 (classSound, 0, U"To PowerCepstrogram...", U"To Harmonicity (gne)...", 1, DO_Sound_to_PowerCepstrogram);
 	praat_addAction1 (classSound, 0, U"To PowerCepstrogram (hillenbrand)...", U"To Harmonicity (gne)...", praat_HIDDEN + praat_DEPTH_1, DO_Sound_to_PowerCepstrogram_hillenbrand);
+	praat_addAction1 (classSound, 1, U"Get CPPS...", U"To PowerCepstrogram (hillenbrand)...", 1, DO_Sound_getCPPS);
 	
 	praat_addAction1 (classVocalTract, 0, U"Draw segments...", U"Draw", 0, DO_VocalTract_drawSegments);
 	praat_addAction1 (classVocalTract, 1, U"Get length", U"Draw segments...", 0, DO_VocalTract_getLength);
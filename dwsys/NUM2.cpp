@@ -2087,13 +2087,16 @@ aa = & work[n+n+1];
 for (i=1; i<=n+n+n; i++) work[i]=0;
 */
 int NUMburg (double x[], long n, double a[], int m, double *xms) {
-	for (long j = 1; j <= m; j++) {
-		a[j] = 0.0;
-	}
-
 	autoNUMvector<double> b1 (1, n);
 	autoNUMvector<double> b2 (1, n);
 	autoNUMvector<double> aa (1, m);
+	return NUMburg_preallocated (x, n, a, m, xms, b1.peek(), b2.peek(), aa.peek());
+}
+
+int NUMburg_preallocated (double x[], long n, double a[], int m, double *xms, double b1[], double b2[], double aa[]) {
+	for (long j = 1; j <= m; j++) {
+		a[j] = 0.0;
+	}
 
 	// (3)
 
@@ -310,6 +310,13 @@ void NUMstatistics_huber (double *x, long n, double *location, int wantlocation,
 	If work == NULL, the routine allocates (and destroys) its own memory.
 */
 
+bool NUMstatistics_huber_quiet (double *x, long n, double *location, int wantlocation,
+	double *scale, int wantscale, double k, double tol, double *work);
+/*
+	As NUMstatistics_huber, but returns false instead of throwing if the scale is zero,
+	so that it can be used on worker threads. Throws only if out of memory.
+*/
+
 void NUMmonotoneRegression (const double x[], long n, double xs[]);
 /*
 	Find numbers xs[1..n] that have a monotone relationship with
@@ -1008,6 +1015,12 @@ int NUMburg (double x[], long n, double a[], int m, double *xms);
 	Spectrum Analysis, IEEE Press, 1978, 252-255.
 */
 
+int NUMburg_preallocated (double x[], long n, double a[], int m, double *xms, double b1[], double b2[], double aa[]);
+/*
+	As NUMburg, with the work vectors b1[1..n], b2[1..n] and aa[1..m] supplied by the caller,
+	e.g. once per thread instead of once per frame.
+*/
+
 void NUMdmatrix_to_dBs (double **m, long rb, long re, long cb, long ce,
 	double ref, double factor, double floor);
 /*
@@ -1159,6 +1172,7 @@ struct structNUMfft_Table
   long n;
   double *trigcache;
   long *splitcache;
+  struct structNUMfft_Bluestein *bluestein;   /* only for lengths with a large prime factor; trigcache and splitcache are then NULL */
 };
 
 typedef struct structNUMfft_Table_f *NUMfft_Table_f;
@@ -1168,6 +1182,28 @@ void NUMfft_Table_init_f (NUMfft_Table_f table, long n);
 void NUMfft_Table_init (NUMfft_Table table, long n);
 /*
 	n : data size
+	Any n > 0 is allowed. The transform is done by the mixed-radix FFTPACK algorithm,
+	which is fastest if n has only factors 2, 3 and 5. If the double-precision table finds
+	a prime factor greater than NUMfft_BLUESTEIN_MINIMUM_PRIME_FACTOR in n, it transforms
+	with Bluestein's chirp-z algorithm instead, so that the time is O(n log n) for any n.
+	That costs memory: with m the smallest length of at least 2n-1 with only factors 2, 3 and 5,
+	the table takes 3m+2n numbers, and every transform needs a scratch space of 4m numbers
+	besides the work space of m numbers of its two FFTs of length m. Like that work space,
+	the scratch space is kept per thread between transforms up to NUMfft_MAXIMUM_KEPT_WORK_SPACE numbers.
+*/
+#define NUMfft_BLUESTEIN_MINIMUM_PRIME_FACTOR  200
+
+void NUMfft_Table_free_f (NUMfft_Table_f table);
+void NUMfft_Table_free (NUMfft_Table table);
+
+void NUMfft_Bluestein_delete (struct structNUMfft_Bluestein *plan);
+int64 NUMfft_Bluestein_getNumberOfBytes (struct structNUMfft_Bluestein *plan);
+
+long NUMfft_getGoodLength (long minimumLength);
+/*
+	The smallest length >= minimumLength that has no prime factors other than 2, 3 and 5.
+	Use this instead of the next power of two when padding for convolution or filtering:
+	the padding is then at most a few percent instead of almost 100 percent.
 */
 
 struct autoNUMfft_Table : public structNUMfft_Table {
@@ -1175,13 +1211,64 @@ struct autoNUMfft_Table : public structNUMfft_Table {
                 n = 0;
                 trigcache = 0;
                 splitcache = 0;
+                bluestein = 0;
         }
         ~autoNUMfft_Table () {
+                NUMfft_Table_free (this);
+        }
+};
+
+struct autoNUMfft_Table_f : public structNUMfft_Table_f {
+        autoNUMfft_Table_f () throw () {
+                n = 0;
+                trigcache = 0;
+                splitcache = 0;
+        }
+        ~autoNUMfft_Table_f () {
                 NUMvector_free (trigcache, 0);
                 NUMvector_free (splitcache, 0);
         }
 };
 
+/*
+	A process-wide cache of FFT tables, keyed by length and precision,
+	so that analyses that transform many frames of the same length compute the trigonometric tables only once.
+	Safe to use from several threads. A retained table must not be modified, and stays valid until it is released.
+	Tables that are in use are never evicted; unused tables are evicted, least recently used first,
+	as soon as all cached tables together take up more than NUMfft_CACHE_MAXIMUM_NUMBER_OF_BYTES.
+	The cached tables are not counted as arrays in "Report memory use", so that they do not show up as leaks.
+*/
+#define NUMfft_CACHE_MAXIMUM_NUMBER_OF_BYTES  (32 * 1024 * 1024)
+/*
+	Besides the table, a transform of length n needs a work space of n numbers.
+	Every thread keeps its work space between transforms if n is at most NUMfft_MAXIMUM_KEPT_WORK_SPACE,
+	i.e. at most 512 kilobytes per thread in double precision; longer transforms allocate and free their own.
+*/
+#define NUMfft_MAXIMUM_KEPT_WORK_SPACE  65536
+
+NUMfft_Table NUMfft_Table_retainCached (long n);
+void NUMfft_Table_releaseCached (NUMfft_Table table);
+NUMfft_Table_f NUMfft_Table_retainCached_f (long n);
+void NUMfft_Table_releaseCached_f (NUMfft_Table_f table);
+
+struct autoNUMfft_CachedTable {
+	NUMfft_Table table;
+	explicit autoNUMfft_CachedTable (long n) : table (NUMfft_Table_retainCached (n)) { }
+	~autoNUMfft_CachedTable () { NUMfft_Table_releaseCached (table); }
+	autoNUMfft_CachedTable (const autoNUMfft_CachedTable&) = delete;
+	autoNUMfft_CachedTable& operator= (const autoNUMfft_CachedTable&) = delete;
+};
+
+struct autoNUMfft_CachedTable_f {
+	NUMfft_Table_f table;
+	explicit autoNUMfft_CachedTable_f (long n) : table (NUMfft_Table_retainCached_f (n)) { }
+	~autoNUMfft_CachedTable_f () { NUMfft_Table_releaseCached_f (table); }
+	autoNUMfft_CachedTable_f (const autoNUMfft_CachedTable_f&) = delete;
+	autoNUMfft_CachedTable_f& operator= (const autoNUMfft_CachedTable_f&) = delete;
+};
+
+void NUMfft_getCacheStatistics (int64 *numberOfHits, int64 *numberOfMisses, long *numberOfTables, int64 *numberOfBytes);
+
 void NUMfft_forward_f (NUMfft_Table_f table, float *data);
 void NUMfft_forward (NUMfft_Table table, double *data);
 /*
@@ -1236,7 +1323,6 @@ void NUMfft_backward (NUMfft_Table table, double *data);
 		Calculates the inverse transform of a complex array if it is the transform of real data.
 		(Result in this case must be multiplied by 1/n.)
 	Preconditions:
-		n is an integer power of 2.
 		data != NULL;
 		data [1] contains real valued first component (Direct Current)
 		data [2..n-1] even index : real part; odd index: imaginary part of DFT.
@@ -1280,7 +1366,6 @@ void NUMforwardRealFastFourierTransform (double  *data, long n);
 		Replaces this data in array data [1...n] by the positive frequency half
 		of its complex Fourier Transform, with a minus sign in the exponent.
 	Preconditions:
-		n is an integer power of 2.
 		data != NULL;
 	Postconditions:
 		data [1] contains real valued first component (Direct Current)
@@ -1294,7 +1379,6 @@ void NUMreverseRealFastFourierTransform (double  *data, long n);
 		Calculates the inverse transform of a complex array if it is the transform of real data.
 		(Result in this case must be multiplied by 1/n.)
 	Preconditions:
-		n is an integer power of 2.
 		data != NULL;
 		data [1] contains real valued first component (Direct Current)
 		data [2] contains real valued last component (Nyquist frequency)
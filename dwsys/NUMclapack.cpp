@@ -10,12 +10,15 @@
  djmw 20030205 Latest modification
 */
 /* #include "blaswrap.h" */
+#include "MelderThread.h"   // before the f2c macros
 #include "NUMf2c.h"
 #include "NUMclapack.h"
 #include "NUMcblas.h"
 #include "NUM2.h"
 #include "melder.h"
 
+MelderThread_StaticMutex NUMclapack_mutex;
+
 /* Table of constant values */
 
 static long c__0 = 0;
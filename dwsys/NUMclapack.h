@@ -37,6 +37,16 @@
 
 */
 
+#include "MelderThread.h"
+
+extern MelderThread_StaticMutex NUMclapack_mutex;
+/*
+	The translated routines keep intermediate results in static variables,
+	so no two threads should be inside them at the same time. Code that can run on several threads
+	(such as Polynomial_to_Roots and SVD_compute) holds an autoMelderThread_Lock on this mutex
+	around its calls to NUMlapack_*.
+*/
+
 int NUMlapack_dbdsqr(const char *uplo, long *n, long *ncvt, long *nru, long *ncc,
 	double *d, double *e, double *vt, long *ldvt, double *u, long *ldu,
 	double *c, long *ldc, double *work, long *info);
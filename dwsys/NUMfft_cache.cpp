@@ -0,0 +1,198 @@
+/* NUMfft_cache.cpp
+ *
+ * Copyright (C) 2016 David Weenink
+ *
+ * This code is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this work. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "NUM2.h"
+#include "MelderThread.h"
+#include <vector>
+
+/*
+	One cache per precision. The entries own their storage in std::vectors rather than in NUMvectors,
+	so that the cache is invisible to the array counts of "Report memory use".
+*/
+static int64 NUMfft_Table_getNumberOfExtraBytes (structNUMfft_Table *table) { return NUMfft_Bluestein_getNumberOfBytes (table -> bluestein); }
+static int64 NUMfft_Table_getNumberOfExtraBytes (structNUMfft_Table_f *) { return 0; }
+static void NUMfft_Table_deleteExtras (structNUMfft_Table *table) { NUMfft_Bluestein_delete (table -> bluestein); }
+static void NUMfft_Table_deleteExtras (structNUMfft_Table_f *) { }
+
+template <typename T, typename TableStruct>
+struct NUMfft_CacheEntry {
+	TableStruct table;
+	std::vector <T> trigcache;
+	std::vector <long> splitcache;
+	long numberOfUsers;
+	int64 lastUse;
+	~NUMfft_CacheEntry () { NUMfft_Table_deleteExtras (& table); }
+	int64 numberOfBytes () {
+		return (int64) (trigcache.size () * sizeof (T) + splitcache.size () * sizeof (long)) + NUMfft_Table_getNumberOfExtraBytes (& table);
+	}
+};
+
+template <typename T, typename TableStruct>
+struct NUMfft_Cache {
+	std::vector <NUMfft_CacheEntry <T, TableStruct> *> entries;
+	int64 numberOfBytes;
+};
+
+static MelderThread_StaticMutex theCacheMutex;   // protects both caches and the statistics
+static NUMfft_Cache <double, structNUMfft_Table> theCache;
+static NUMfft_Cache <float, structNUMfft_Table_f> theCache_f;
+static int64 theNumberOfHits, theNumberOfMisses, theClock;
+
+/*
+	Called with the mutex locked. Returns the index of the least recently used table in `me` that has no users, or -1.
+*/
+template <typename T, typename TableStruct>
+static long NUMfft_Cache_findOldestUnused (NUMfft_Cache <T, TableStruct> *me) {
+	long oldest = -1;
+	for (long i = 0; i < (long) my entries.size (); i ++) {
+		NUMfft_CacheEntry <T, TableStruct> *entry = my entries [i];
+		if (entry -> numberOfUsers == 0 && (oldest < 0 || entry -> lastUse < my entries [oldest] -> lastUse))
+			oldest = i;
+	}
+	return oldest;
+}
+
+template <typename T, typename TableStruct>
+static void NUMfft_Cache_remove (NUMfft_Cache <T, TableStruct> *me, long index) {
+	my numberOfBytes -= my entries [index] -> numberOfBytes ();
+	delete my entries [index];
+	my entries.erase (my entries.begin () + index);
+}
+
+/*
+	Called with the mutex locked.
+	The two caches share one budget, so throw away unused tables from either of them,
+	least recently used first, until they are small enough together.
+*/
+static void NUMfft_Caches_evict () {
+	while (theCache. numberOfBytes + theCache_f. numberOfBytes > NUMfft_CACHE_MAXIMUM_NUMBER_OF_BYTES) {
+		long oldest = NUMfft_Cache_findOldestUnused (& theCache);
+		long oldest_f = NUMfft_Cache_findOldestUnused (& theCache_f);
+		if (oldest < 0 && oldest_f < 0) return;   // everything is in use
+		if (oldest_f < 0 || (oldest >= 0 && theCache. entries [oldest] -> lastUse < theCache_f. entries [oldest_f] -> lastUse))
+			NUMfft_Cache_remove (& theCache, oldest);
+		else
+			NUMfft_Cache_remove (& theCache_f, oldest_f);
+	}
+}
+
+/*
+	Called with the mutex locked. Returns the entry for n, or nullptr.
+*/
+template <typename T, typename TableStruct>
+static TableStruct *NUMfft_Cache_retainExisting (NUMfft_Cache <T, TableStruct> *me, long n) {
+	for (NUMfft_CacheEntry <T, TableStruct> *entry : my entries) {
+		if (entry -> table. n == n) {
+			entry -> numberOfUsers += 1;
+			entry -> lastUse = ++ theClock;
+			return & entry -> table;
+		}
+	}
+	return nullptr;
+}
+
+template <typename T, typename TableStruct>
+static TableStruct *NUMfft_Cache_retain (NUMfft_Cache <T, TableStruct> *me, long n, void (*init) (TableStruct *, long)) {
+	Melder_assert (n >= 1);
+	{// scope
+		autoMelderThread_Lock lock (theCacheMutex);
+		TableStruct *table = NUMfft_Cache_retainExisting (me, n);
+		if (table) theNumberOfHits += 1; else theNumberOfMisses += 1;
+		if (table) return table;
+	}
+
+	/*
+		Compute the table outside the lock, because that takes O(n) trigonometry.
+		The counted arrays that `init` allocates are moved into uncounted storage.
+	*/
+	NUMfft_CacheEntry <T, TableStruct> *entry = new NUMfft_CacheEntry <T, TableStruct> ();
+	try {
+		init (& entry -> table, n);   // from here on, the entry owns any extras
+		if (entry -> table. trigcache) {
+			entry -> trigcache. assign (entry -> table. trigcache, entry -> table. trigcache + n);
+			entry -> splitcache. assign (entry -> table. splitcache, entry -> table. splitcache + 32);
+			NUMvector_free (entry -> table. trigcache, 0);
+			NUMvector_free (entry -> table. splitcache, 0);
+			entry -> table. trigcache = & entry -> trigcache [0];
+			entry -> table. splitcache = & entry -> splitcache [0];
+		}
+	} catch (MelderError) {
+		delete entry;
+		throw;
+	}
+	entry -> numberOfUsers = 1;
+
+	TableStruct *table;
+	try {
+		autoMelderThread_Lock lock (theCacheMutex);
+		table = NUMfft_Cache_retainExisting (me, n);   // another thread may have been quicker
+		if (! table) {
+			entry -> lastUse = ++ theClock;
+			my entries. push_back (entry);   // may throw, in which case the lock is released and the entry deleted below
+			my numberOfBytes += entry -> numberOfBytes ();
+			NUMfft_Caches_evict ();
+			table = & entry -> table;
+			entry = nullptr;
+		}
+	} catch (...) {
+		delete entry;
+		throw;
+	}
+	delete entry;
+	return table;
+}
+
+template <typename T, typename TableStruct>
+static void NUMfft_Cache_release (NUMfft_Cache <T, TableStruct> *me, TableStruct *table) {
+	if (! table) return;
+	autoMelderThread_Lock lock (theCacheMutex);
+	for (NUMfft_CacheEntry <T, TableStruct> *entry : my entries) {
+		if (& entry -> table == table) {
+			Melder_assert (entry -> numberOfUsers > 0);
+			entry -> numberOfUsers -= 1;
+			break;
+		}
+	}
+	NUMfft_Caches_evict ();
+}
+
+NUMfft_Table NUMfft_Table_retainCached (long n) {
+	return NUMfft_Cache_retain (& theCache, n, NUMfft_Table_init);
+}
+
+void NUMfft_Table_releaseCached (NUMfft_Table table) {
+	NUMfft_Cache_release (& theCache, table);
+}
+
+NUMfft_Table_f NUMfft_Table_retainCached_f (long n) {
+	return NUMfft_Cache_retain (& theCache_f, n, NUMfft_Table_init_f);
+}
+
+void NUMfft_Table_releaseCached_f (NUMfft_Table_f table) {
+	NUMfft_Cache_release (& theCache_f, table);
+}
+
+void NUMfft_getCacheStatistics (int64 *numberOfHits, int64 *numberOfMisses, long *numberOfTables, int64 *numberOfBytes) {
+	autoMelderThread_Lock lock (theCacheMutex);
+	if (numberOfHits) *numberOfHits = theNumberOfHits;
+	if (numberOfMisses) *numberOfMisses = theNumberOfMisses;
+	if (numberOfTables) *numberOfTables = (long) (theCache. entries.size () + theCache_f. entries.size ());
+	if (numberOfBytes) *numberOfBytes = theCache. numberOfBytes + theCache_f. numberOfBytes;
+}
+
+/* End of file NUMfft_cache.cpp */
@@ -112,7 +112,7 @@ static void NUMrffti (long n, FFT_DATA_TYPE * wsave, long *ifac)
 
 	if (n == 1)
 		return;
-	drfti1 (n, wsave + n, ifac);
+	drfti1 (n, wsave, ifac);   /* wsave [0..n-1]; the work space of drftf1 and drftb1 is no longer in front of it */
 }
 
 /* void NUMcosqi(long n, FFT_DATA_TYPE *wsave, long *ifac){ static
@@ -22,6 +22,7 @@
  */
 
 #include "NUM2.h"
+#include <vector>
 #include "melder.h"
 
 #define my me ->
@@ -29,10 +30,36 @@
 #define FFT_DATA_TYPE double
 #include "NUMfft_core.h"
 
+/*
+	drftf1 and drftb1 use a work space of n elements, which used to be the first part of the table's trigcache.
+	Since one cached table can be used by several threads at the same time (see NUMfft_Table_retainCached),
+	every thread has a work space of its own; the table itself is only read.
+	A thread keeps its work space for the next transform only up to NUMfft_MAXIMUM_KEPT_WORK_SPACE elements;
+	a longer transform gets a work space that is freed when the transform is done.
+	The scratch space of the Bluestein transforms (see below) is kept in the same way, in a vector of its own,
+	because a Bluestein transform calls NUMfft_forward while it uses its scratch space.
+*/
+static thread_local std::vector <double> theKeptWorkSpace, theKeptBluesteinSpace;
+
+struct NUMfft_WorkSpace {
+	std::vector <double> ownSpace;
+	double *data;
+	NUMfft_WorkSpace (std::vector <double>& keptSpace, long n) {
+		if (n <= NUMfft_MAXIMUM_KEPT_WORK_SPACE) {
+			if ((long) keptSpace. size () < n) {
+				keptSpace. resize (n);
+			}
+			data = & keptSpace [0];
+		} else {
+			ownSpace. resize (n);
+			data = & ownSpace [0];
+		}
+	}
+};
+
 void NUMforwardRealFastFourierTransform (double *data, long n) {
-	autoNUMfft_Table table;
-	NUMfft_Table_init (& table, n);
-	NUMfft_forward (& table, data);
+	autoNUMfft_CachedTable table (n);
+	NUMfft_forward (table.table, data);
 
 	if (n > 1) {
 		// To be compatible with old behaviour
@@ -45,8 +72,6 @@ void NUMforwardRealFastFourierTransform (double *data, long n) {
 }
 
 void NUMreverseRealFastFourierTransform (double *data, long n) {
-	autoNUMfft_Table table;
-
 	if (n > 1) {
 		// To be compatible with old behaviour
 		double tmp = data[2];
@@ -56,31 +81,276 @@ void NUMreverseRealFastFourierTransform (double *data, long n) {
 		data[n] = tmp;
 	}
 
-	NUMfft_Table_init (& table, n);
-	NUMfft_backward (& table, data);
+	autoNUMfft_CachedTable table (n);
+	NUMfft_backward (table.table, data);
+}
+
+/*
+	Bluestein's algorithm writes the DFT of length n as a convolution with the chirp w [j] = exp (-i pi j^2 / n),
+	because 2jk = j^2 + k^2 - (k-j)^2:
+
+		X [k] = w [k] * sum (j = 0 .. n-1) (x [j] w [j]) conj (w [k-j])
+
+	The convolution is done cyclically with FFTs of a length m >= 2n-1 that has only factors 2, 3 and 5.
+	The plan is read-only after creation, so that a cached table can be used by several threads at once;
+	the storage is in std::vectors, so that cached plans do not show up as arrays in "Report memory use".
+*/
+struct structNUMfft_Bluestein {
+	long n, m;
+	std::vector <double> trigcache;
+	std::vector <long> splitcache;
+	structNUMfft_Table table;   // real FFT of length m
+	std::vector <double> chirpRe, chirpIm;   // w [0 .. n-1]
+	std::vector <double> filterRe, filterIm;   // DFT of conj (w), wrapped around to length m, divided by m
+};
+
+static long NUMfft_getLargestPrimeFactor (long n) {
+	long largest = 1;
+	for (long factor = 2; factor <= n / factor; factor ++) {
+		while (n % factor == 0) {
+			largest = factor;
+			n /= factor;
+		}
+	}
+	return n > 1 ? n : largest;
+}
+
+long NUMfft_getGoodLength (long minimumLength) {
+	for (long length = minimumLength < 1 ? 1 : minimumLength; ; length ++) {
+		long rest = length;
+		while (rest % 2 == 0) rest /= 2;
+		while (rest % 3 == 0) rest /= 3;
+		while (rest % 5 == 0) rest /= 5;
+		if (rest == 1) return length;
+	}
+}
+
+/*
+	In-place packed half spectrum (as produced by NUMfft_forward) -> complex value at frequency index k in [0, m).
+*/
+static inline void getComplexValue (const double *packed, long m, long k, double *re, double *im) {
+	if (k == 0) {
+		*re = packed [1];
+		*im = 0.0;
+	} else if (2 * k == m) {
+		*re = packed [m];
+		*im = 0.0;
+	} else if (2 * k < m) {
+		*re = packed [k + k];
+		*im = packed [k + k + 1];
+	} else {
+		*re = packed [2 * (m - k)];
+		*im = - packed [2 * (m - k) + 1];
+	}
+}
+
+/*
+	Complex forward DFT of length m by two real FFTs.
+	re [1..m] and im [1..m] are destroyed; the result goes to outRe [0..m-1] and outIm [0..m-1].
+*/
+static void complexForward (NUMfft_Table table, double *re, double *im, double *outRe, double *outIm) {
+	long m = table -> n;
+	NUMfft_forward (table, re);
+	NUMfft_forward (table, im);
+	for (long k = 0; k < m; k ++) {
+		double rr, ri, ir, ii;
+		getComplexValue (re, m, k, & rr, & ri);
+		getComplexValue (im, m, k, & ir, & ii);
+		outRe [k] = rr - ii;
+		outIm [k] = ri + ir;
+	}
+}
+
+static struct structNUMfft_Bluestein *NUMfft_Bluestein_create (long n) {
+	struct structNUMfft_Bluestein *me = new structNUMfft_Bluestein;
+	try {
+		my n = n;
+		my m = NUMfft_getGoodLength (2 * n - 1);
+		my trigcache. resize (my m);
+		my splitcache. resize (32);
+		my table. n = my m;
+		my table. trigcache = & my trigcache [0];
+		my table. splitcache = & my splitcache [0];
+		my table. bluestein = nullptr;
+		NUMrffti (my m, my table. trigcache, my table. splitcache);
+
+		my chirpRe. resize (n);
+		my chirpIm. resize (n);
+		for (long j = 0; j < n; j ++) {
+			long long jsquaredModulo2n = ((long long) j * j) % (2LL * n);   // keeps the phase accurate for large j
+			double phase = NUMpi * (double) jsquaredModulo2n / n;
+			my chirpRe [j] = cos (phase);
+			my chirpIm [j] = - sin (phase);
+		}
+
+		autoNUMvector <double> re (1, my m), im (1, my m);
+		re [1] = 1.0;
+		for (long j = 1; j < n; j ++) {
+			re [1 + j] = re [1 + my m - j] = my chirpRe [j];
+			im [1 + j] = im [1 + my m - j] = - my chirpIm [j];
+		}
+		my filterRe. resize (my m);
+		my filterIm. resize (my m);
+		complexForward (& my table, re.peek(), im.peek(), & my filterRe [0], & my filterIm [0]);
+		for (long k = 0; k < my m; k ++) {
+			my filterRe [k] /= my m;
+			my filterIm [k] /= my m;
+		}
+		return me;
+	} catch (MelderError) {
+		delete me;
+		throw;
+	} catch (std::bad_alloc&) {
+		delete me;
+		Melder_throw (U"Out of memory: cannot create FFT table for ", n, U" samples.");
+	}
+}
+
+void NUMfft_Bluestein_delete (struct structNUMfft_Bluestein *me) {
+	delete me;
+}
+
+int64 NUMfft_Bluestein_getNumberOfBytes (struct structNUMfft_Bluestein *me) {
+	if (! me) return 0;
+	return (int64) ((my trigcache.size () + my chirpRe.size () + my chirpIm.size () + my filterRe.size () + my filterIm.size ()) * sizeof (double)
+		+ my splitcache.size () * sizeof (long));
+}
+
+/*
+	The scratch space of one Bluestein transform: 4m numbers, kept per thread (see NUMfft_WorkSpace).
+	The chirped input goes into re [1..m] and im [1..m] (zero beyond n);
+	NUMfft_Bluestein_convolve leaves the convolution in spectrumRe [0..m-1] and spectrumIm [0..m-1].
+*/
+struct NUMfft_BluesteinScratch {
+	NUMfft_WorkSpace space;
+	double *re, *im, *spectrumRe, *spectrumIm;
+	explicit NUMfft_BluesteinScratch (struct structNUMfft_Bluestein *me) : space (theKeptBluesteinSpace, 4 * my m) {
+		re = space. data - 1;
+		im = re + my m;
+		spectrumRe = space. data + 2 * my m;
+		spectrumIm = spectrumRe + my m;
+		for (long j = my n + 1; j <= my m; j ++) {
+			re [j] = im [j] = 0.0;
+		}
+	}
+};
+
+/*
+	Convolves the chirped input with the chirp. Afterwards, X [k] = conj (spectrum [k]) * w [k] is the DFT of the input.
+*/
+static void NUMfft_Bluestein_convolve (struct structNUMfft_Bluestein *me, NUMfft_BluesteinScratch *scratch) {
+	double *re = scratch -> re, *im = scratch -> im, *spectrumRe = scratch -> spectrumRe, *spectrumIm = scratch -> spectrumIm;
+	complexForward (& my table, re, im, spectrumRe, spectrumIm);
+	/*
+		Multiply by the filter, and do the inverse DFT as conj (DFT (conj (.))).
+	*/
+	for (long k = 0; k < my m; k ++) {
+		double productRe = spectrumRe [k] * my filterRe [k] - spectrumIm [k] * my filterIm [k];
+		double productIm = spectrumRe [k] * my filterIm [k] + spectrumIm [k] * my filterRe [k];
+		re [1 + k] = productRe;
+		im [1 + k] = - productIm;
+	}
+	complexForward (& my table, re, im, spectrumRe, spectrumIm);
+}
+
+static inline void NUMfft_Bluestein_getOutput (struct structNUMfft_Bluestein *me, NUMfft_BluesteinScratch *scratch, long k,
+	double *outRe, double *outIm)
+{
+	double convolutionRe = scratch -> spectrumRe [k], convolutionIm = - scratch -> spectrumIm [k];
+	*outRe = convolutionRe * my chirpRe [k] - convolutionIm * my chirpIm [k];
+	*outIm = convolutionRe * my chirpIm [k] + convolutionIm * my chirpRe [k];
+}
+
+static void NUMfft_Bluestein_forward (struct structNUMfft_Bluestein *me, double *data) {
+	long n = my n;
+	NUMfft_BluesteinScratch scratch (me);
+	for (long j = 0; j < n; j ++) {
+		scratch. re [1 + j] = data [1 + j] * my chirpRe [j];
+		scratch. im [1 + j] = data [1 + j] * my chirpIm [j];
+	}
+	NUMfft_Bluestein_convolve (me, & scratch);
+	double re, im;
+	NUMfft_Bluestein_getOutput (me, & scratch, 0, & re, & im);
+	data [1] = re;
+	for (long k = 1; 2 * k < n; k ++) {
+		NUMfft_Bluestein_getOutput (me, & scratch, k, & data [k + k], & data [k + k + 1]);
+	}
+	if (n % 2 == 0) {
+		NUMfft_Bluestein_getOutput (me, & scratch, n / 2, & re, & im);
+		data [n] = re;
+	}
+}
+
+static void NUMfft_Bluestein_backward (struct structNUMfft_Bluestein *me, double *data) {
+	/*
+		x [j] = sum (k) X [k] exp (2 pi i jk / n) = conj (DFT (conj (X))) [j], of which we need only the real part.
+	*/
+	long n = my n;
+	NUMfft_BluesteinScratch scratch (me);
+	for (long k = 0; k < n; k ++) {
+		double zRe, zIm;
+		getComplexValue (data, n, k, & zRe, & zIm);
+		zIm = - zIm;
+		scratch. re [1 + k] = zRe * my chirpRe [k] - zIm * my chirpIm [k];
+		scratch. im [1 + k] = zRe * my chirpIm [k] + zIm * my chirpRe [k];
+	}
+	NUMfft_Bluestein_convolve (me, & scratch);
+	for (long j = 0; j < n; j ++) {
+		double re, im;
+		NUMfft_Bluestein_getOutput (me, & scratch, j, & re, & im);
+		data [1 + j] = re;
+	}
 }
 
 void NUMfft_forward (NUMfft_Table me, double *data) {
 	if (my n == 1) {
 		return;
 	}
-	drftf1 (my n, &data[1], my trigcache, my trigcache + my n, my splitcache);
+	if (my bluestein) {
+		NUMfft_Bluestein_forward (my bluestein, data);
+		return;
+	}
+	NUMfft_WorkSpace workSpace (theKeptWorkSpace, my n);
+	drftf1 (my n, &data[1], workSpace. data, my trigcache, my splitcache);
 }
 
 void NUMfft_backward (NUMfft_Table me, double *data) {
 	if (my n == 1) {
 		return;
 	}
-	drftb1 (my n, &data[1], my trigcache, my trigcache + my n, my splitcache);
+	if (my bluestein) {
+		NUMfft_Bluestein_backward (my bluestein, data);
+		return;
+	}
+	NUMfft_WorkSpace workSpace (theKeptWorkSpace, my n);
+	drftb1 (my n, &data[1], workSpace. data, my trigcache, my splitcache);
 }
 
 void NUMfft_Table_init (NUMfft_Table me, long n) {
 	my n = n;
-	my trigcache = NUMvector <double> (0, 3 * n - 1);
+	if (NUMfft_getLargestPrimeFactor (n) > NUMfft_BLUESTEIN_MINIMUM_PRIME_FACTOR) {
+		my trigcache = nullptr;
+		my splitcache = nullptr;
+		my bluestein = NUMfft_Bluestein_create (n);
+		return;
+	}
+	my bluestein = nullptr;
+	my trigcache = NUMvector <double> (0, n - 1);
 	my splitcache = NUMvector <long> (0, 31);
 	NUMrffti (n, my trigcache, my splitcache);
 }
 
+void NUMfft_Table_free (NUMfft_Table me) {
+	if (me) {
+		NUMvector_free (my trigcache, 0);
+		NUMvector_free (my splitcache, 0);
+		NUMfft_Bluestein_delete (my bluestein);
+		my trigcache = nullptr;
+		my splitcache = nullptr;
+		my bluestein = nullptr;
+	}
+}
+
 void NUMrealft (double *data, long n, int isign) {
 	isign == 1 ? NUMforwardRealFastFourierTransform (data, n) :
 	NUMreverseRealFastFourierTransform (data, n);
@@ -21,6 +21,7 @@
 	djmw 20040511 Added n>1 test for compatibility with old behaviour.
 */
 #include "NUM2.h"
+#include <vector>
 #include "melder.h"
 
 #define my me ->
@@ -28,13 +29,33 @@
 #define FFT_DATA_TYPE float
 #include "NUMfft_core.h"
 
-void NUMforwardRealFastFourierTransform_f (float *data, long n) {
-	struct NUMfft_Table_f table_struct;
-	NUMfft_Table_f table = &table_struct;
-
-	NUMfft_Table_init_f (table, n);
+/*
+	drftf1 and drftb1 use a work space of n elements, which used to be the first part of the table's trigcache.
+	Since one cached table can be used by several threads at the same time (see NUMfft_Table_retainCached_f),
+	every thread has a work space of its own; the table itself is only read.
+	A thread keeps its work space for the next transform only up to NUMfft_MAXIMUM_KEPT_WORK_SPACE elements;
+	a longer transform gets a work space that is freed when the transform is done.
+*/
+struct NUMfft_WorkSpace_f {
+	std::vector <float> ownSpace;
+	float *data;
+	explicit NUMfft_WorkSpace_f (long n) {
+		static thread_local std::vector <float> keptSpace;
+		if (n <= NUMfft_MAXIMUM_KEPT_WORK_SPACE) {
+			if ((long) keptSpace. size () < n) {
+				keptSpace. resize (n);
+			}
+			data = & keptSpace [0];
+		} else {
+			ownSpace. resize (n);
+			data = & ownSpace [0];
+		}
+	}
+};
 
-	NUMfft_forward_f (table, data);
+void NUMforwardRealFastFourierTransform_f (float *data, long n) {
+	autoNUMfft_CachedTable_f table (n);
+	NUMfft_forward_f (table.table, data);
 
 	if (n > 1) {
 		// To be compatible with old behaviour
@@ -44,14 +65,9 @@ void NUMforwardRealFastFourierTransform_f (float *data, long n) {
 		}
 		data[2] = tmp;
 	}
-
-	NUMfft_Table_free_f (table);
 }
 
 void NUMreverseRealFastFourierTransform_f (float *data, long n) {
-	struct NUMfft_Table_f table_struct;
-	NUMfft_Table_f table = &table_struct;
-
 	if (n > 1) {
 		// To be compatible with old behaviour
 		float tmp = data[2];
@@ -61,28 +77,29 @@ void NUMreverseRealFastFourierTransform_f (float *data, long n) {
 		data[n] = tmp;
 	}
 
-	NUMfft_Table_init_f (table, n);
-	NUMfft_backward_f (table, data);
-	NUMfft_Table_free_f (table);
+	autoNUMfft_CachedTable_f table (n);
+	NUMfft_backward_f (table.table, data);
 }
 
 void NUMfft_forward_f (NUMfft_Table_f me, float *data) {
 	if (my n == 1) {
 		return;
 	}
-	drftf1 (my n, &data[1], my trigcache, my trigcache + my n, my splitcache);
+	NUMfft_WorkSpace_f workSpace (my n);
+	drftf1 (my n, &data[1], workSpace. data, my trigcache, my splitcache);
 }
 
 void NUMfft_backward_f (NUMfft_Table_f me, float *data) {
 	if (my n == 1) {
 		return;
 	}
-	drftb1 (my n, &data[1], my trigcache, my trigcache + my n, my splitcache);
+	NUMfft_WorkSpace_f workSpace (my n);
+	drftb1 (my n, &data[1], workSpace. data, my trigcache, my splitcache);
 }
 
 void NUMfft_Table_init_f (NUMfft_Table_f me, long n) {
 	my n = n;
-	my trigcache = NUMvector<float> (0, 3 * n - 1);
+	my trigcache = NUMvector<float> (0, n - 1);
 	my splitcache = NUMvector<long> (0, 31);
 	NUMrffti (n, my trigcache, my splitcache);
 }
@@ -61,7 +61,10 @@ static double NUMgauss (double x) {
 	return NUM1_sqrt2pi * exp (- 0.5 * x * x);
 }
 
-void NUMstatistics_huber (double *x, long n, double *location, int wantlocation,
+/*
+	Returns false if the scale is zero. Throws only if out of memory.
+*/
+static bool NUMstatistics_huber_ (double *x, long n, double *location, int wantlocation,
                           double *scale, int wantscale, double k, double tol, double *work) {
 	double *tmp = work;
 	double theta = 2.0 * NUMgaussP (k) - 1.0;
@@ -79,7 +82,7 @@ void NUMstatistics_huber (double *x, long n, double *location, int wantlocation,
 		*scale = mad;
 	}
 	if (*scale == 0) {
-		Melder_throw (U"Scale is zero.");
+		return false;
 	}
 
 	double mu0, mu1 = *location;
@@ -128,4 +131,17 @@ void NUMstatistics_huber (double *x, long n, double *location, int wantlocation,
 	if (wantscale) {
 		*scale = s1;
 	}
+	return true;
+}
+
+void NUMstatistics_huber (double *x, long n, double *location, int wantlocation,
+                          double *scale, int wantscale, double k, double tol, double *work) {
+	if (! NUMstatistics_huber_ (x, n, location, wantlocation, scale, wantscale, k, tol, work)) {
+		Melder_throw (U"Scale is zero.");
+	}
+}
+
+bool NUMstatistics_huber_quiet (double *x, long n, double *location, int wantlocation,
+                          double *scale, int wantscale, double k, double tol, double *work) {
+	return NUMstatistics_huber_ (x, n, location, wantlocation, scale, wantscale, k, tol, work);
 }
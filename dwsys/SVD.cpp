@@ -201,43 +201,63 @@ static void NUMtranspose_d (double **m, long n) {
 		double *s, double *u, long *ldu, double *vt, long *ldvt, double *work,
 		long *lwork, long *info);
 */
-void SVD_compute (SVD me) {
-	try {
-		char jobu = 'S', jobvt = 'O';
-		long m, lda, ldu, ldvt, info, lwork = -1;
-		double wt[2];
-		int transpose = my numberOfRows < my numberOfColumns;
-
-		// Transpose: if rows < cols then data in v
-		if (transpose) {
-			SVD_transpose (me);
-		}
+/*
+	Returns 0 if the decomposition succeeded, else 1 if the work space query failed, 2 if the decomposition failed.
+	Throws only if out of memory.
+*/
+static int SVD_compute_ (SVD me) {
+	char jobu = 'S', jobvt = 'O';
+	long m, lda, ldu, ldvt, info, lwork = -1;
+	double wt[2];
+	int transpose = my numberOfRows < my numberOfColumns;
+
+	// Transpose: if rows < cols then data in v
+	if (transpose) {
+		SVD_transpose (me);
+	}
 
-		lda = ldu = ldvt = m = my numberOfColumns;
-		long n = my numberOfRows;
+	lda = ldu = ldvt = m = my numberOfColumns;
+	long n = my numberOfRows;
 
-		(void) NUMlapack_dgesvd (&jobu, &jobvt, &m, &n, &my u[1][1], &lda, &my d[1], &my v[1][1], &ldu, nullptr, &ldvt, wt, &lwork, &info);
+	autoMelderThread_Lock lock (NUMclapack_mutex);
+	(void) NUMlapack_dgesvd (&jobu, &jobvt, &m, &n, &my u[1][1], &lda, &my d[1], &my v[1][1], &ldu, nullptr, &ldvt, wt, &lwork, &info);
 
-		if (info != 0) {
+	if (info != 0) {
+		return 1;
+	}
+
+	lwork = wt[0];
+	autoNUMvector<double> work (0L, lwork);
+	(void) NUMlapack_dgesvd (&jobu, &jobvt, &m, &n, &my u[1][1], &lda, &my d[1], &my v[1][1], &ldu, nullptr, &ldvt, work.peek(), &lwork, &info);
+	if (info != 0) {
+		return 2;
+	}
+
+	NUMtranspose_d (my v, MIN (m, n));
+	if (transpose) {
+		SVD_transpose (me);
+	}
+	return 0;
+}
+
+void SVD_compute (SVD me) {
+	try {
+		int status = SVD_compute_ (me);
+		if (status == 1) {
 			Melder_throw (U"SVD not precomputed.");
 		}
-
-		lwork = wt[0];
-		autoNUMvector<double> work (0L, lwork);
-		(void) NUMlapack_dgesvd (&jobu, &jobvt, &m, &n, &my u[1][1], &lda, &my d[1], &my v[1][1], &ldu, nullptr, &ldvt, work.peek(), &lwork, &info);
-		if (info != 0) {
+		if (status == 2) {
 			Melder_throw (U"SVD not computed.");
 		}
-
-		NUMtranspose_d (my v, MIN (m, n));
-		if (transpose) {
-			SVD_transpose (me);
-		}
 	} catch (MelderError) {
 		Melder_throw (me, U": SVD could not be computed.");
 	}
 }
 
+bool SVD_compute_quiet (SVD me) {
+	return SVD_compute_ (me) == 0;
+}
+
 // V D^2 V'or V D^-2 V
 void SVD_getSquared (SVD me, double **m, bool inverse) {
 	for (long i = 1; i <= my numberOfColumns; i++) {
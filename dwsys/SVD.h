@@ -53,6 +53,11 @@ void SVD_svd_f (SVD me, float **m);
 
 void SVD_compute (SVD me);
 
+bool SVD_compute_quiet (SVD me);
+/* As SVD_compute, but returns false instead of throwing if the decomposition fails,
+ * so that it can be used on worker threads. Throws only if out of memory.
+ */
+
 void SVD_solve (SVD me, double b[], double x[]);
 /* Solve Ax = b */
 
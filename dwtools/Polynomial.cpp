@@ -1170,75 +1170,109 @@ void Roots_draw (Roots me, Graphics g, double rmin, double rmax, double imin, do
 	}
 }
 
-autoRoots Polynomial_to_Roots (Polynomial me) {
-	try {
-		long np1 = my numberOfCoefficients, n = np1 - 1, n2 = n * n;
-
-		if (n < 1) {
-			Melder_throw (U"Cannot find roots of a constant function.");
-		}
+/*
+	The eigenvalue computation behind Polynomial_to_Roots and Polynomial_to_Roots_quiet.
+	Issues no messages; throws only if out of memory.
+	*info is as returned by NUMlapack_dhseqr: 0 if all roots were found,
+	i > 0 if only the last n - i roots were found, negative for an illegal argument.
+	Returns nullptr if no roots were found.
+*/
+static autoRoots Polynomial_to_Roots_ (Polynomial me, long *info) {
+	long np1 = my numberOfCoefficients, n = np1 - 1, n2 = n * n;
+	Melder_assert (n >= 1);
 
-		// Allocate storage for Hessenberg matrix (n * n) plus real and imaginary
-		// parts of eigenvalues wr[1..n] and wi[1..n].
+	// Allocate storage for Hessenberg matrix (n * n) plus real and imaginary
+	// parts of eigenvalues wr[1..n] and wi[1..n].
 
-		autoNUMvector<double> hes (1, n2 + n + n);
-		double *wr = &hes[n2];
-		double *wi = &hes[n2 + n];
+	autoNUMvector<double> hes (1, n2 + n + n);
+	double *wr = &hes[n2];
+	double *wi = &hes[n2 + n];
 
-		// Fill the upper Hessenberg matrix (storage is Fortran)
-		// C: [i][j] -> Fortran: (j-1)*n + i
+	// Fill the upper Hessenberg matrix (storage is Fortran)
+	// C: [i][j] -> Fortran: (j-1)*n + i
 
-		for (long i = 1; i <= n; i++) {
-			hes[ (i - 1) *n + 1] = - (my coefficients[np1 - i] / my coefficients[np1]);
-			if (i < n) {
-				hes[ (i - 1) *n + 1 + i] = 1;
-			}
+	for (long i = 1; i <= n; i++) {
+		hes[ (i - 1) *n + 1] = - (my coefficients[np1 - i] / my coefficients[np1]);
+		if (i < n) {
+			hes[ (i - 1) *n + 1 + i] = 1;
 		}
+	}
+
+	char job = 'E', compz = 'N';
+	long ilo = 1, ihi = n, ldh = n, ldz = n, lwork = -1;
+	double *z = 0, wt[1];
+	{// scope
+		autoMelderThread_Lock lock (NUMclapack_mutex);
 
 		// Find out the working storage needed
 
-		char job = 'E', compz = 'N';
-		long ilo = 1, ihi = n, ldh = n, ldz = n, lwork = -1, info;
-		double *z = 0, wt[1];
-		NUMlapack_dhseqr (&job, &compz, &n, &ilo, &ihi, &hes[1], &ldh, &wr[1], &wi[1], z, &ldz, wt, &lwork, &info);
-		if (info != 0) {
-			if (info < 0) {
-				Melder_throw (U"Programming error. Argument ", info, U" in NUMlapack_dhseqr has illegal value.");
-			}
+		NUMlapack_dhseqr (&job, &compz, &n, &ilo, &ihi, &hes[1], &ldh, &wr[1], &wi[1], z, &ldz, wt, &lwork, info);
+		if (*info < 0) {
+			return autoRoots ();
 		}
 		lwork = (long) floor (wt[0]);
 		autoNUMvector<double> work (1, lwork);
 
 		// Find eigenvalues.
 
-		NUMlapack_dhseqr (&job, &compz, &n, &ilo, &ihi, &hes[1], &ldh, &wr[1], &wi[1], z, &ldz, &work[1], &lwork, &info);
-		long nrootsfound = n;
-		long ioffset = 0;
-		if (info > 0) {
-			// if INFO = i, NUMlapack_dhseqr failed to compute all of the eigenvalues. Elements i+1:n of
-			// WR and WI contain those eigenvalues which have been successfully computed
-			nrootsfound -= info;
-			if (nrootsfound < 1) {
-				Melder_throw (U"No roots found.");
-			}
-			Melder_warning (U"Calculated only ", nrootsfound, U" roots.");
-			ioffset = info;
-		} else if (info < 0) {
+		NUMlapack_dhseqr (&job, &compz, &n, &ilo, &ihi, &hes[1], &ldh, &wr[1], &wi[1], z, &ldz, &work[1], &lwork, info);
+	}
+	long nrootsfound = n;
+	long ioffset = 0;
+	if (*info > 0) {
+		// if INFO = i, NUMlapack_dhseqr failed to compute all of the eigenvalues. Elements i+1:n of
+		// WR and WI contain those eigenvalues which have been successfully computed
+		nrootsfound -= *info;
+		ioffset = *info;
+	} else if (*info < 0) {
+		return autoRoots ();
+	}
+	if (nrootsfound < 1) {
+		return autoRoots ();
+	}
+
+	autoRoots thee = Roots_create (nrootsfound);
+	for (long i = 1; i <= nrootsfound; i++) {
+		(thy v[i]).re = wr[ioffset + i];
+		(thy v[i]).im = wi[ioffset + i];
+	}
+	Roots_and_Polynomial_polish (thee.get(), me);
+	return thee;
+}
+
+autoRoots Polynomial_to_Roots (Polynomial me) {
+	try {
+		if (my numberOfCoefficients < 2) {
+			Melder_throw (U"Cannot find roots of a constant function.");
+		}
+		long info;
+		autoRoots thee = Polynomial_to_Roots_ (me, & info);
+		if (info < 0) {
 			Melder_throw (U"Programming error. Argument ", info, U" in NUMlapack_dhseqr has illegal value.");
 		}
-
-		autoRoots thee = Roots_create (nrootsfound);
-		for (long i = 1; i <= nrootsfound; i++) {
-			(thy v[i]).re = wr[ioffset + i];
-			(thy v[i]).im = wi[ioffset + i];
+		if (! thee) {
+			Melder_throw (U"No roots found.");
+		}
+		if (info > 0) {
+			Melder_warning (U"Calculated only ", thy max, U" roots.");
 		}
-		Roots_and_Polynomial_polish (thee.get(), me);
 		return thee;
 	} catch (MelderError) {
 		Melder_throw (me, U": no roots can be calculated.");
 	}
 }
 
+autoRoots Polynomial_to_Roots_quiet (Polynomial me, bool *allRootsFound) {
+	*allRootsFound = false;
+	if (my numberOfCoefficients < 2) {
+		return autoRoots ();
+	}
+	long info;
+	autoRoots thee = Polynomial_to_Roots_ (me, & info);
+	*allRootsFound = thee && info == 0;
+	return thee;
+}
+
 void Roots_sort (Roots me) {
 	(void) me;
 }
@@ -1261,6 +1295,93 @@ void Roots_and_Polynomial_polish (Roots me, Polynomial thee) {
 	}
 }
 
+/*
+	Simultaneous Newton iterations with implicit deflation (Aberth-Ehrlich):
+	each estimate z[i] is corrected by w = N / (1 - N S), where N = p(z[i]) / p'(z[i]) is the Newton step
+	and S = sum (j != i) 1 / (z[i] - z[j]) keeps the estimates from converging to the same root.
+*/
+bool Roots_and_Polynomial_refine (Roots me, Polynomial thee, long maxit) {
+	long n = thy numberOfCoefficients - 1;
+	if (n < 1 || my min != 1 || my max != n) {
+		return false;
+	}
+	dcomplex *z = my v;
+	bool converged = false;
+	for (long iter = 1; iter <= maxit && ! converged; iter++) {
+		converged = true;
+		for (long i = 1; i <= n; i++) {
+			dcomplex p, dp;
+			Polynomial_evaluateWithDerivative_z (thee, & z[i], & p, & dp);
+			double dpabs2 = dp.re * dp.re + dp.im * dp.im;
+			if (dpabs2 == 0.0) {
+				return false;
+			}
+			double nre = (p.re * dp.re + p.im * dp.im) / dpabs2, nim = (p.im * dp.re - p.re * dp.im) / dpabs2;
+			double sre = 0.0, sim = 0.0;
+			for (long j = 1; j <= n; j++) {
+				if (j != i) {
+					double dre = z[i].re - z[j].re, dim = z[i].im - z[j].im, d2 = dre * dre + dim * dim;
+					if (d2 == 0.0) {
+						return false;
+					}
+					sre += dre / d2; sim -= dim / d2;
+				}
+			}
+			double denre = 1.0 - (nre * sre - nim * sim), denim = - (nre * sim + nim * sre);
+			double den2 = denre * denre + denim * denim;
+			if (den2 == 0.0) {
+				return false;
+			}
+			double wre = (nre * denre + nim * denim) / den2, wim = (nim * denre - nre * denim) / den2;
+			z[i].re -= wre; z[i].im -= wim;
+			if (! isfinite (z[i].re) || ! isfinite (z[i].im)) {
+				return false;
+			}
+			if (wre * wre + wim * wim > 1e-24 * (z[i].re * z[i].re + z[i].im * z[i].im)) {
+				converged = false;
+			}
+		}
+	}
+	if (! converged) {
+		return false;
+	}
+
+	// The coefficients are real: make the real roots exactly real and store each complex pair as (a+bi, a-bi).
+
+	for (long i = 1; i <= n; i++) {
+		if (fabs (z[i].im) <= 1e-10 * dcomplex_abs (z[i])) {
+			z[i].im = 0.0;
+		}
+	}
+	long i = 1;
+	while (i <= n) {
+		if (z[i].im == 0.0) {
+			i++; continue;
+		}
+		long jmin = 0;
+		double dmin = 0.0;
+		for (long j = i + 1; j <= n; j++) {
+			if (z[j].im * z[i].im < 0.0) {
+				double d = dcomplex_abs (dcomplex_sub (z[j], dcomplex_conjugate (z[i])));
+				if (jmin == 0 || d < dmin) {
+					jmin = j; dmin = d;
+				}
+			}
+		}
+		if (jmin == 0 || dmin > 1e-8 * dcomplex_abs (z[i])) {
+			return false;
+		}
+		dcomplex t = z[i + 1]; z[i + 1] = z[jmin]; z[jmin] = t;
+		if (z[i].im < 0.0) {
+			t = z[i]; z[i] = z[i + 1]; z[i + 1] = t;
+		}
+		z[i + 1] = dcomplex_conjugate (z[i]);
+		i += 2;
+	}
+	Roots_and_Polynomial_polish (me, thee);
+	return true;
+}
+
 autoPolynomial Roots_to_Polynomial (Roots me, bool rootsAreReal) {
 	try {
 		(void) me;
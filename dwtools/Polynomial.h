@@ -205,6 +205,12 @@ autoSpectrum Roots_to_Spectrum (Roots me, double nyquistFrequency, long numberOf
 autoRoots Polynomial_to_Roots (Polynomial me);
 /* Find roots of polynomial and polish them */
 
+autoRoots Polynomial_to_Roots_quiet (Polynomial me, bool *allRootsFound);
+/* As Polynomial_to_Roots, but without error messages or warnings, so that it can be used on worker threads:
+ * returns nullptr if no roots can be found, and sets *allRootsFound to false if some or all roots are missing.
+ * Throws only if out of memory.
+ */
+
 double Polynomial_findOneSimpleRealRoot_nr (Polynomial me, double xmin, double xmax);
 double Polynomial_findOneSimpleRealRoot_ridders (Polynomial me, double xmin, double xmax);
 /* Preconditions: there must be exactly one root in the [xmin, xmax] interval;
@@ -213,6 +219,13 @@ double Polynomial_findOneSimpleRealRoot_ridders (Polynomial me, double xmin, dou
 
 void Roots_and_Polynomial_polish (Roots me, Polynomial thee);
 
+bool Roots_and_Polynomial_refine (Roots me, Polynomial thee, long maxit);
+/* Refines estimates of the roots of thee (e.g. the roots of a nearby polynomial) by simultaneous
+ * Newton iterations and polishes them. Returns false, leaving the roots undefined, if the number of roots
+ * differs from the degree of thee or the iterations do not converge within maxit steps;
+ * the caller can then fall back on Polynomial_to_Roots.
+ */
+
 autoPolynomial Roots_to_Polynomial (Roots me, bool rootsAreReal);
 
 autoPolynomial TableOfReal_to_Polynomial (TableOfReal me, long degree, long xcol, long ycol, long scol);
@@ -31,6 +31,7 @@
 #include "Sound_to_Pitch.h"
 #include "Vector.h"
 #include "NUM2.h"
+#include "MelderThread.h"
 
 #define MIN(m,n) ((m) < (n) ? (m) : (n))
 // prototypes
@@ -87,30 +88,155 @@ static autoSpectrum Sound_to_Spectrum_power (Sound me) {
 	}
 }
 
-static void Sound_into_BarkSpectrogram_frame (Sound me, BarkSpectrogram thee, long frame) {
-	autoSpectrum him = Sound_to_Spectrum_power (me);
+/*
+	A bank of filters on the frequency bins of the power spectrum of a frame, as a sparse band matrix:
+	filter i has the weights [i] [1..numberOfBins [i]] for the bins firstBin [i] .. firstBin [i] + numberOfBins [i] - 1.
+	It is computed once per analysis, instead of once per frame, and shared by all threads.
+*/
+Thing_define (SpectralFilterBank, Thing) {
+	long numberOfFrequencies;   // of the power spectrum
+	long numberOfFilters;
+	autoNUMvector <long> firstBin, numberOfBins;
+	autoNUMmatrix <double> weights;
+};
+
+Thing_implement (SpectralFilterBank, Thing, 0);
+
+static autoSpectralFilterBank SpectralFilterBank_create (long numberOfFrequencies, long numberOfFilters, long maximumNumberOfBins) {
+	autoSpectralFilterBank me = Thing_new (SpectralFilterBank);
+	my numberOfFrequencies = numberOfFrequencies;
+	my numberOfFilters = numberOfFilters;
+	my firstBin.reset (1, numberOfFilters);
+	my numberOfBins.reset (1, numberOfFilters);
+	my weights.reset (1, numberOfFilters, 1, maximumNumberOfBins);
+	return me;
+}
+
+/*
+	An empty Spectrum with the frequency grid that Sound_to_Spectrum_power gives for a frame as long as the window.
+*/
+static autoSpectrum Sound_to_Spectrum_frameGrid (Sound window) {
+	long nfft = 2;
+	while (nfft < window -> nx) nfft *= 2;
+	autoSpectrum thee = Spectrum_create (0.5 / window -> dx, nfft / 2 + 1);
+	thy dx = 1.0 / (window -> dx * nfft);   // as in Sound_to_Spectrum
+	return thee;
+}
+
+/*
+	The filters of Sound_to_BarkSpectrogram: the Sekey & Hanson filters cover all frequencies.
+*/
+static autoSpectralFilterBank BarkSpectrogram_to_SpectralFilterBank (BarkSpectrogram me, Spectrum him) {
 	long numberOfFrequencies = his nx;
+	autoSpectralFilterBank thee = SpectralFilterBank_create (numberOfFrequencies, my ny, numberOfFrequencies);
 	autoNUMvector<double> z (1, numberOfFrequencies);
-
 	for (long ifreq = 1; ifreq <= numberOfFrequencies; ifreq++) {
 		double fhz = his x1 + (ifreq - 1) * his dx;
-		z[ifreq] = thy v_hertzToFrequency (fhz);
+		z[ifreq] = my v_hertzToFrequency (fhz);
 	}
-
-	for (long i = 1; i <= thy ny; i++) {
-		double p = 0;
-		double z0 = thy y1 + (i - 1) * thy dy;
-		double *pow = his z[1]; // TODO ??
+	for (long i = 1; i <= my ny; i++) {
+		double z0 = my y1 + (i - 1) * my dy;
+		thy firstBin [i] = 1;
+		thy numberOfBins [i] = numberOfFrequencies;
 		for (long ifreq = 1; ifreq <= numberOfFrequencies; ifreq++) {
 			// Sekey & Hanson filter is defined in the power domain.
 			// We therefore multiply the power with a (and not a^2).
 			// integral (F(z),z=0..25) = 1.58/9
+			thy weights [i] [ifreq] = NUMsekeyhansonfilter_amplitude (z0, z[ifreq]);
+		}
+	}
+	return thee;
+}
 
-			double a = NUMsekeyhansonfilter_amplitude (z0, z[ifreq]);
-			p += a * pow[ifreq] ;
+/*
+	The filters of Sound_to_MelSpectrogram: each triangular filter covers only the bins between its neighbours' centre frequencies.
+*/
+static autoSpectralFilterBank MelSpectrogram_to_SpectralFilterBank (MelSpectrogram me, Spectrum him) {
+	autoNUMvector <long> ifroms (1, my ny), itos (1, my ny);
+	long maximumNumberOfBins = 1;
+	for (long ifilter = 1; ifilter <= my ny; ifilter ++) {
+		double fc_mel = my y1 + (ifilter - 1) * my dy;
+		Sampled_getWindowSamples (him, my v_frequencyToHertz (fc_mel - my dy), my v_frequencyToHertz (fc_mel + my dy), & ifroms [ifilter], & itos [ifilter]);
+		if (itos [ifilter] - ifroms [ifilter] + 1 > maximumNumberOfBins) {
+			maximumNumberOfBins = itos [ifilter] - ifroms [ifilter] + 1;
+		}
+	}
+	autoSpectralFilterBank thee = SpectralFilterBank_create (his nx, my ny, maximumNumberOfBins);
+	for (long ifilter = 1; ifilter <= my ny; ifilter ++) {
+		double fc_mel = my y1 + (ifilter - 1) * my dy;
+		double fc_hz = my v_frequencyToHertz (fc_mel);
+		double fl_hz = my v_frequencyToHertz (fc_mel - my dy);
+		double fh_hz =  my v_frequencyToHertz (fc_mel + my dy);
+		long ifrom = ifroms [ifilter], ito = itos [ifilter];
+		thy firstBin [ifilter] = ito >= ifrom ? ifrom : 1;
+		thy numberOfBins [ifilter] = ito >= ifrom ? ito - ifrom + 1 : 0;
+		for (long i = ifrom; i <= ito; i++) {
+			// Bin with a triangular filter the power (= amplitude-squared)
+			double f = his x1 + (i - 1) * his dx;
+			thy weights [ifilter] [i - ifrom + 1] = NUMtriangularfilter_amplitude (fl_hz, fc_hz, fh_hz, f);
 		}
-		thy z[i][frame] = p;
 	}
+	return thee;
+}
+
+/*
+	Fills all the frames of the spectrogram: each frame goes through the steps of Sound_into_Sound, Sounds_multiply
+	and Sound_to_Spectrum_power, in buffers that every thread allocates only once, and is then filtered by the bank.
+*/
+static void Sound_into_BandFilterSpectrogram (Sound me, BandFilterSpectrogram thee, Sound window, double windowDuration,
+	SpectralFilterBank bank, const char32 *analysisName)
+{
+	long nsamp_window = window -> nx, numberOfFrequencies = bank -> numberOfFrequencies;
+	long nfft = 2 * (numberOfFrequencies - 1);
+	double scaling = window -> dx;   // as in Sound_to_Spectrum
+	double frequencyStep = 1.0 / (window -> dx * nfft);
+	double powerScale = 2.0 * frequencyStep / (window -> xmax - window -> xmin);   // as in Sound_to_Spectrum_power
+	autoNUMfft_CachedTable fftTable (nfft);
+	const int numberOfThreads = MelderThread_getNumberOfThreadsToUse (thy nx, 10);
+	autoNUMmatrix <double> ffts (0, numberOfThreads - 1, 1, nfft);
+	autoNUMmatrix <double> powers (0, numberOfThreads - 1, 1, numberOfFrequencies);
+	MelderThread_forRange (thy nx, numberOfThreads, 10,
+		[&] (long firstFrame, long lastFrame, int ithread) {
+			double *fft = ffts [ithread], *power = powers [ithread];
+			for (long iframe = firstFrame; iframe <= lastFrame; iframe ++) {
+				double t = Sampled_indexToX (thee, iframe);
+				long index = Sampled_xToNearestIndex (me, t - windowDuration / 2.0);
+				for (long i = 1; i <= nsamp_window; i ++) {
+					long j = index - 1 + i;
+					fft [i] = j < 1 || j > my nx ? 0 : my z [1] [j];
+					fft [i] *= window -> z [1] [i];
+				}
+				for (long i = nsamp_window + 1; i <= nfft; i ++) {
+					fft [i] = 0.0;
+				}
+				NUMfft_forward (fftTable.table, fft);
+				/*
+					Sound_to_Spectrum_power: factor '2' because we combine positive and negative frequencies,
+					but the frequency bins at 0 Hz and at the Nyquist frequency don't count for two.
+				*/
+				double re = fft [1] * scaling;
+				power [1] = 0.5 * (powerScale * (re * re));
+				for (long i = 2; i < numberOfFrequencies; i ++) {
+					re = fft [i + i - 2] * scaling;
+					double im = fft [i + i - 1] * scaling;
+					power [i] = powerScale * (re * re + im * im);
+				}
+				re = fft [nfft] * scaling;
+				power [numberOfFrequencies] = 0.5 * (powerScale * (re * re));
+				for (long ifilter = 1; ifilter <= bank -> numberOfFilters; ifilter ++) {
+					const double *weight = & bank -> weights [ifilter] [1], *pow = & power [bank -> firstBin [ifilter]];
+					double p = 0.0;
+					for (long k = 0; k < bank -> numberOfBins [ifilter]; k ++) {
+						p += weight [k] * pow [k];
+					}
+					thy z [ifilter] [iframe] = p;
+				}
+			}
+		},
+		[&] (double fractionDone) {
+			Melder_progress (fractionDone, analysisName, U": ", thy nx, U" frames.");
+		}
+	);
 }
 
 autoBarkSpectrogram Sound_to_BarkSpectrogram (Sound me, double analysisWidth, double dt, double f1_bark, double fmax_bark, double df_bark) {
@@ -140,24 +266,14 @@ autoBarkSpectrogram Sound_to_BarkSpectrogram (Sound me, double analysisWidth, do
 
 		long numberOfFrames; double t1;
 		Sampled_shortTermAnalysis (me, windowDuration, dt, & numberOfFrames, & t1);
-		autoSound sframe = Sound_createSimple (1, windowDuration, samplingFrequency);
 		autoSound window = Sound_createGaussian (windowDuration, samplingFrequency);
 		autoBarkSpectrogram thee = BarkSpectrogram_create (my xmin, my xmax, numberOfFrames, dt, t1, fmin_bark, fmax_bark, numberOfFilters, df_bark, f1_bark);
+		autoSpectrum grid = Sound_to_Spectrum_frameGrid (window.get());
+		autoSpectralFilterBank bank = BarkSpectrogram_to_SpectralFilterBank (thee.get(), grid.get());
 
 		autoMelderProgress progess (U"BarkSpectrogram analysis");
 
-		for (long iframe = 1; iframe <= numberOfFrames; iframe++) {
-			double t = Sampled_indexToX (thee.get(), iframe);
-
-			Sound_into_Sound (me, sframe.get(), t - windowDuration / 2.0);
-			Sounds_multiply (sframe.get(), window.get());
-			Sound_into_BarkSpectrogram_frame (sframe.get(), thee.get(), iframe);
-
-			if (iframe % 10 == 1) {
-				Melder_progress ( (double) iframe / numberOfFrames,  U"BarkSpectrogram analysis: frame ",
-					iframe, U" from ", numberOfFrames, U".");
-			}
-		}
+		Sound_into_BandFilterSpectrogram (me, thee.get(), window.get(), windowDuration, bank.get(), U"BarkSpectrogram analysis");
 		
 		_Spectrogram_windowCorrection ((Spectrogram) thee.get(), window -> nx);
 
@@ -167,28 +283,6 @@ autoBarkSpectrogram Sound_to_BarkSpectrogram (Sound me, double analysisWidth, do
 	}
 }
 
-static void Sound_into_MelSpectrogram_frame (Sound me, MelSpectrogram thee, long frame) {
-	autoSpectrum him = Sound_to_Spectrum_power (me);
-
-	for (long ifilter = 1; ifilter <= thy ny; ifilter ++) {
-		double power = 0;
-		double fc_mel = thy y1 + (ifilter - 1) * thy dy;
-		double fc_hz = thy v_frequencyToHertz (fc_mel);
-		double fl_hz = thy v_frequencyToHertz (fc_mel - thy dy);
-		double fh_hz =  thy v_frequencyToHertz (fc_mel + thy dy);
-		long ifrom, ito;
-		Sampled_getWindowSamples (him.get(), fl_hz, fh_hz, &ifrom, &ito);
-		for (long i = ifrom; i <= ito; i++) {
-			// Bin with a triangular filter the power (= amplitude-squared)
-
-			double f = his x1 + (i - 1) * his dx;
-			double a = NUMtriangularfilter_amplitude (fl_hz, fc_hz, fh_hz, f);
-			power += a * his z[1][i];
-		}
-		thy z[ifilter][frame] = power;
-	}
-}
-
 autoMelSpectrogram Sound_to_MelSpectrogram (Sound me, double analysisWidth, double dt, double f1_mel, double fmax_mel, double df_mel) {
 	try {
 		double t1, samplingFrequency = 1.0 / my dx, nyquist = 0.5 * samplingFrequency;
@@ -218,22 +312,14 @@ autoMelSpectrogram Sound_to_MelSpectrogram (Sound me, double analysisWidth, doub
 		fmax_mel = f1_mel + numberOfFilters * df_mel;
 
 		Sampled_shortTermAnalysis (me, windowDuration, dt, &numberOfFrames, &t1);
-		autoSound sframe = Sound_createSimple (1, windowDuration, samplingFrequency);
 		autoSound window = Sound_createGaussian (windowDuration, samplingFrequency);
 		autoMelSpectrogram thee = MelSpectrogram_create (my xmin, my xmax, numberOfFrames, dt, t1, fmin_mel, fmax_mel, numberOfFilters, df_mel, f1_mel);
+		autoSpectrum grid = Sound_to_Spectrum_frameGrid (window.get());
+		autoSpectralFilterBank bank = MelSpectrogram_to_SpectralFilterBank (thee.get(), grid.get());
 
 		autoMelderProgress progress (U"MelSpectrograms analysis");
 
-		for (long iframe = 1; iframe <= numberOfFrames; iframe++) {
-			double t = Sampled_indexToX (thee.get(), iframe);
-			Sound_into_Sound (me, sframe.get(), t - windowDuration / 2.0);
-			Sounds_multiply (sframe.get(), window.get());
-			Sound_into_MelSpectrogram_frame (sframe.get(), thee.get(), iframe);
-			
-			if (iframe % 10 == 1) {
-				Melder_progress ((double) iframe / numberOfFrames, U"Frame ", iframe, U" out of ", numberOfFrames, U".");
-			}
-		}
+		Sound_into_BandFilterSpectrogram (me, thee.get(), window.get(), windowDuration, bank.get(), U"MelSpectrogram analysis");
 		
 		_Spectrogram_windowCorrection ((Spectrogram) thee.get(), window -> nx);
 
@@ -20,6 +20,7 @@
 #include "NUM2.h"
 #include "Formula.h"
 #include "Eigen.h"
+#include "MelderThread.h"
 
 #include "oo_DESTROY.h"
 #include "Matrix_def.h"
@@ -623,17 +624,57 @@ void Matrix_writeToHeaderlessSpreadsheetFile (Matrix me, MelderFile file) {
 	}
 }
 
-void Matrix_formula (Matrix me, const char32 *expression, Interpreter interpreter, Matrix target) {
-	try {
+static void FormulaProgram_runIntoMatrix (FormulaProgram program, long iymin, long iymax, long ixmin, long ixmax, Matrix target) {
+	/*
+		A program that only looks at its own cell gives the same result in any order,
+		so if it is thread-safe we can distribute the cells over threads.
+	*/
+	long numberOfColumns = ixmax - ixmin + 1, numberOfCells = (iymax - iymin + 1) * numberOfColumns;
+	int numberOfThreads = FormulaProgram_isThreadSafe (program) ?
+		MelderThread_getNumberOfThreadsToUse (numberOfCells, 10000) : 1;
+	if (FormulaProgram_canRunOnRows (program)) {
+		/*
+			A program without conditions can be run on whole stretches of a row at a time.
+		*/
+		auto runOnCells = [&] (long firstCell, long lastCell, int /* threadNumber */) {
+			for (long icell = firstCell; icell <= lastCell; ) {
+				long irow = iymin + (icell - 1) / numberOfColumns, icol = ixmin + (icell - 1) % numberOfColumns;
+				long lastColumn = icol + (lastCell - icell) < ixmax ? icol + (lastCell - icell) : ixmax;
+				FormulaProgram_runOnRow (program, irow, icol, lastColumn, & target -> z [irow] [icol]);
+				icell += lastColumn - icol + 1;
+			}
+		};
+		if (numberOfThreads == 1)
+			runOnCells (1, numberOfCells, 0);
+		else
+			MelderThread_forRange (numberOfCells, numberOfThreads, 4096, runOnCells);
+		return;
+	}
+	if (numberOfThreads == 1) {
 		struct Formula_Result result;
-		Formula_compile (interpreter, me, expression, kFormula_EXPRESSION_TYPE_NUMERIC, true);
-		if (! target) target = me;
-		for (long irow = 1; irow <= my ny; irow ++) {
-			for (long icol = 1; icol <= my nx; icol ++) {
-				Formula_run (irow, icol, & result);
+		for (long irow = iymin; irow <= iymax; irow ++) {
+			for (long icol = ixmin; icol <= ixmax; icol ++) {
+				FormulaProgram_run (program, irow, icol, & result);
 				target -> z [irow] [icol] = result. result.numericResult;
 			}
 		}
+		return;
+	}
+	MelderThread_forRange (numberOfCells, numberOfThreads, 4096, [&] (long firstCell, long lastCell, int /* threadNumber */) {
+		struct Formula_Result result;
+		for (long icell = firstCell; icell <= lastCell; icell ++) {
+			long irow = iymin + (icell - 1) / numberOfColumns, icol = ixmin + (icell - 1) % numberOfColumns;
+			FormulaProgram_run (program, irow, icol, & result);
+			target -> z [irow] [icol] = result. result.numericResult;
+		}
+	});
+}
+
+void Matrix_formula (Matrix me, const char32 *expression, Interpreter interpreter, Matrix target) {
+	try {
+		autoFormulaProgram program = Formula_compileProgram (interpreter, me, expression, kFormula_EXPRESSION_TYPE_NUMERIC, true);
+		if (! target) target = me;
+		FormulaProgram_runIntoMatrix (program.get(), 1, my ny, 1, my nx, target);
 	} catch (MelderError) {
 		Melder_throw (me, U": formula not completed.");
 	}
@@ -648,15 +689,9 @@ void Matrix_formula_part (Matrix me, double xmin, double xmax, double ymin, doub
 		long ixmin, ixmax, iymin, iymax;
 		(void) Matrix_getWindowSamplesX (me, xmin, xmax, & ixmin, & ixmax);
 		(void) Matrix_getWindowSamplesY (me, ymin, ymax, & iymin, & iymax);
-		struct Formula_Result result;
-		Formula_compile (interpreter, me, expression, kFormula_EXPRESSION_TYPE_NUMERIC, true);
+		autoFormulaProgram program = Formula_compileProgram (interpreter, me, expression, kFormula_EXPRESSION_TYPE_NUMERIC, true);
 		if (! target) target = me;
-		for (long irow = iymin; irow <= iymax; irow ++) {
-			for (long icol = ixmin; icol <= ixmax; icol ++) {
-				Formula_run (irow, icol, & result);
-				target -> z [irow] [icol] = result. result.numericResult;
-			}
-		}
+		FormulaProgram_runIntoMatrix (program.get(), iymin, iymax, ixmin, ixmax, target);
 	} catch (MelderError) {
 		Melder_throw (me, U": formula not completed.");
 	}
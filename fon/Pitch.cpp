@@ -424,6 +424,49 @@ int Pitch_getMaxnCandidates (Pitch me) {
 	return result;
 }
 
+void Pitch_Frame_getLocalStrengths (Pitch_Frame me, double silenceThreshold, double voicingThreshold,
+	double octaveCost, double ceiling, double ceiling2, double *strengths)
+{
+	double unvoicedStrength = silenceThreshold <= 0 ? 0 :
+		2 - my intensity / (silenceThreshold / (1 + voicingThreshold));
+	unvoicedStrength = voicingThreshold + (unvoicedStrength > 0 ? unvoicedStrength : 0);
+	for (long icand = 1; icand <= my nCandidates; icand ++) {
+		Pitch_Candidate candidate = & my candidate [icand];
+		int voiceless = candidate->frequency == 0 || candidate->frequency > ceiling2;
+		strengths [icand] = voiceless ? unvoicedStrength :
+			candidate->strength - octaveCost * NUMlog2 (ceiling / candidate->frequency);
+	}
+}
+
+double Pitch_getTransitionCost (double previousFrequency, double currentFrequency,
+	double octaveJumpCost, double voicedUnvoicedCost, double ceiling2)
+{
+	bool previousVoiceless = previousFrequency <= 0 || previousFrequency >= ceiling2;
+	bool currentVoiceless = currentFrequency <= 0 || currentFrequency >= ceiling2;
+	if (currentVoiceless) {
+		return previousVoiceless ? 0 : voicedUnvoicedCost;   // both voiceless, or voiced-to-unvoiced transition
+	} else {
+		return previousVoiceless ? voicedUnvoicedCost :   // unvoiced-to-voiced transition
+			octaveJumpCost * fabs (NUMlog2 (previousFrequency / currentFrequency));   // both voiced
+	}
+}
+
+void Pitch_Frame_pullFormants (Pitch_Frame me, double ceiling, double ceiling2) {
+	Pitch_Candidate winner = & my candidate [1];
+	double f = winner -> frequency;
+	if (f > ceiling && f <= ceiling2) {
+		for (long icand = 2; icand <= my nCandidates; icand ++) {
+			Pitch_Candidate loser = & my candidate [icand];
+			if (loser -> frequency == 0.0) {
+				structPitch_Candidate help = * winner;
+				* winner = * loser;
+				* loser = help;
+				break;
+			}
+		}
+	}
+}
+
 void Pitch_pathFinder (Pitch me, double silenceThreshold, double voicingThreshold,
 	double octaveCost, double octaveJumpCost, double voicedUnvoicedCost,
 	double ceiling, int pullFormants)
@@ -452,16 +495,8 @@ void Pitch_pathFinder (Pitch me, double silenceThreshold, double voicingThreshol
 		autoNUMmatrix <long> psi (1, my nx, 1, maxnCandidates);
 
 		for (long iframe = 1; iframe <= my nx; iframe ++) {
-			Pitch_Frame frame = & my frame [iframe];
-			double unvoicedStrength = silenceThreshold <= 0 ? 0 :
-				2 - frame->intensity / (silenceThreshold / (1 + voicingThreshold));
-			unvoicedStrength = voicingThreshold + (unvoicedStrength > 0 ? unvoicedStrength : 0);
-			for (long icand = 1; icand <= frame->nCandidates; icand ++) {
-				Pitch_Candidate candidate = & frame->candidate [icand];
-				int voiceless = candidate->frequency == 0 || candidate->frequency > ceiling2;
-				delta [iframe] [icand] = voiceless ? unvoicedStrength :
-					candidate->strength - octaveCost * NUMlog2 (ceiling / candidate->frequency);
-			}
+			Pitch_Frame_getLocalStrengths (& my frame [iframe], silenceThreshold, voicingThreshold,
+				octaveCost, ceiling, ceiling2, delta [iframe]);
 		}
 
 		/* Look for the most probable path through the maxima. */
@@ -478,34 +513,19 @@ void Pitch_pathFinder (Pitch me, double silenceThreshold, double voicingThreshol
 				place = 0;
 				for (long icand1 = 1; icand1 <= prevFrame -> nCandidates; icand1 ++) {
 					double f1 = prevFrame -> candidate [icand1]. frequency;
-					double transitionCost;
-					bool previousVoiceless = f1 <= 0 || f1 >= ceiling2;
-					bool currentVoiceless = f2 <= 0 || f2 >= ceiling2;
-					if (currentVoiceless) {
-						if (previousVoiceless) {
-							transitionCost = 0;   // both voiceless
-						} else {
-							transitionCost = voicedUnvoicedCost;   // voiced-to-unvoiced transition
-						}
-					} else {
-						if (previousVoiceless) {
-							transitionCost = voicedUnvoicedCost;   // unvoiced-to-voiced transition
-							if (Melder_debug == 30) {
-								/*
-								 * Try to take into account a frequency jump across a voiceless stretch.
-								 */
-								long place1 = icand1;
-								for (long jframe = iframe - 2; jframe >= 1; jframe --) {
-									place1 = psi [jframe + 1] [place1];
-									f1 = my frame [jframe]. candidate [place1]. frequency;
-									if (f1 > 0 && f1 < ceiling) {
-										transitionCost += octaveJumpCost * fabs (NUMlog2 (f1 / f2)) / (iframe - jframe);
-										break;
-									}
-								}
+					double transitionCost = Pitch_getTransitionCost (f1, f2, octaveJumpCost, voicedUnvoicedCost, ceiling2);
+					if (Melder_debug == 30 && (f1 <= 0 || f1 >= ceiling2) && ! (f2 <= 0 || f2 >= ceiling2)) {
+						/*
+						 * Try to take into account a frequency jump across a voiceless stretch.
+						 */
+						long place1 = icand1;
+						for (long jframe = iframe - 2; jframe >= 1; jframe --) {
+							place1 = psi [jframe + 1] [place1];
+							f1 = my frame [jframe]. candidate [place1]. frequency;
+							if (f1 > 0 && f1 < ceiling) {
+								transitionCost += octaveJumpCost * fabs (NUMlog2 (f1 / f2)) / (iframe - jframe);
+								break;
 							}
-						} else {
-							transitionCost = octaveJumpCost * fabs (NUMlog2 (f1 / f2));   // both voiced
 						}
 					}
 					value = prevDelta [icand1] - transitionCost + curDelta [icand2];
@@ -560,20 +580,7 @@ void Pitch_pathFinder (Pitch me, double silenceThreshold, double voicingThreshol
 			if (Melder_debug == 33)
 				Melder_casual (U"Pulling formants...");
 			for (long iframe = my nx; iframe >= 1; iframe --) {
-				Pitch_Frame frame = & my frame [iframe];
-				Pitch_Candidate winner = & frame -> candidate [1];
-				double f = winner -> frequency;
-				if (f > ceiling && f <= ceiling2) {
-					for (long icand = 2; icand <= frame -> nCandidates; icand ++) {
-						Pitch_Candidate loser = & frame -> candidate [icand];
-						if (loser -> frequency == 0.0) {
-							structPitch_Candidate help = * winner;
-							* winner = * loser;
-							* loser = help;
-							break;
-						}
-					}
-				}
+				Pitch_Frame_pullFormants (& my frame [iframe], ceiling, ceiling2);
 			}
 		}
 	} catch (MelderError) {
@@ -123,6 +123,19 @@ void Pitch_pathFinder (Pitch me, double silenceThreshold, double voicingThreshol
 	double octaveCost, double octaveJumpCost, double voicedUnvoicedCost,
 	double ceiling, int pullFormants);
 
+/*
+	The ingredients of the path finder, shared with the online path finder of the PitchTracker (Sound_to_Pitch.h).
+	ceiling2 is twice the ceiling if formants are pulled, else the ceiling itself.
+*/
+void Pitch_Frame_getLocalStrengths (Pitch_Frame me, double silenceThreshold, double voicingThreshold,
+	double octaveCost, double ceiling, double ceiling2, double *strengths);
+/* strengths [1..my nCandidates]: how well each candidate fits this frame, regardless of its neighbours. */
+double Pitch_getTransitionCost (double previousFrequency, double currentFrequency,
+	double octaveJumpCost, double voicedUnvoicedCost, double ceiling2);
+/* The cost of going from a candidate in one frame to a candidate in the next; frequency 0 means voiceless. */
+void Pitch_Frame_pullFormants (Pitch_Frame me, double ceiling, double ceiling2);
+/* If the winner (candidate 1) lies between ceiling and ceiling2, make the frame voiceless. */
+
 /* Drawing methods. */
 #define Pitch_speckle_NO  false
 #define Pitch_speckle_YES  true
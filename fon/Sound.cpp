@@ -25,6 +25,8 @@
 #include "Sound.h"
 #include "Sound_extensions.h"
 #include "NUM2.h"
+#include "Sound_convolve.h"
+#include "Sound_resample.h"
 
 #include "enums_getText.h"
 #include "Sound_enums.h"
@@ -339,8 +341,7 @@ autoMatrix Sound_to_Matrix (Sound me) {
 
 autoSound Sound_upsample (Sound me) {
 	try {
-		long nfft = 1;
-		while (nfft < my nx + 2000) nfft *= 2;
+		long nfft = 2 * NUMfft_getGoodLength ((my nx + 2001) / 2);   // even, as NUMrealft requires
 		autoSound thee = Sound_create (my ny, my xmin, my xmax, my nx * 2, my dx / 2, my x1 - my dx / 4);
 		for (long channel = 1; channel <= my ny; channel ++) {
 			autoNUMvector<double> data (1, 2 * nfft);   // zeroing is important...
@@ -371,10 +372,18 @@ autoSound Sound_resample (Sound me, double samplingFrequency, long precision) {
 		long numberOfSamples = lround ((my xmax - my xmin) * samplingFrequency);
 		if (numberOfSamples < 1)
 			Melder_throw (U"The resampled Sound would have no samples.");
+		autoSound thee = Sound_create (my ny, my xmin, my xmax, numberOfSamples, 1.0 / samplingFrequency,
+			0.5 * (my xmin + my xmax - (numberOfSamples - 1) / samplingFrequency));
+		long up, down;
+		if (precision > 1 && SoundResampler_getFactors (1.0 / my dx, samplingFrequency, precision, & up, & down)) {
+			autoSoundResampler resampler = SoundResampler_create (up, down, Sampled_xToIndex (me, thy x1), precision);
+			SoundResampler_resample (resampler.get(), my z, my ny, 0, 1, my nx, thy z, 0, 1, thy nx);
+			return thee;
+		}
 		autoSound filtered;
 		if (upfactor < 1.0) {   // need anti-aliasing filter?
-			long nfft = 1, antiTurnAround = 1000;
-			while (nfft < my nx + antiTurnAround * 2) nfft *= 2;
+			long antiTurnAround = 1000;
+			long nfft = 2 * NUMfft_getGoodLength ((my nx + antiTurnAround * 2 + 1) / 2);   // even, as NUMrealft requires
 			autoNUMvector<double> data (1, nfft);
 			filtered = Sound_create (my ny, my xmin, my xmax, my nx, my dx, my x1);
 			for (long channel = 1; channel <= my ny; channel ++) {
@@ -396,8 +405,6 @@ autoSound Sound_resample (Sound me, double samplingFrequency, long precision) {
 			}
 			me = filtered.get();   // reference copy; remove at end
 		}
-		autoSound thee = Sound_create (my ny, my xmin, my xmax, numberOfSamples, 1.0 / samplingFrequency,
-			0.5 * (my xmin + my xmax - (numberOfSamples - 1) / samplingFrequency));
 		for (long channel = 1; channel <= my ny; channel ++) {
 			double *from = my z [channel];
 			double *to = thy z [channel];
@@ -516,32 +523,44 @@ autoSound Sounds_convolve (Sound me, Sound thee, enum kSounds_convolve_scaling s
 		if (my dx != thy dx)
 			Melder_throw (U"The sampling frequencies of the two sounds have to be equal.");
 		long n1 = my nx, n2 = thy nx;
-		long n3 = n1 + n2 - 1, nfft = 1;
-		while (nfft < n3) nfft *= 2;
-		autoNUMvector <double> data1 (1, nfft);
-		autoNUMvector <double> data2 (1, nfft);
+		long n3 = n1 + n2 - 1;
 		long numberOfChannels = my ny > thy ny ? my ny : thy ny;
 		autoSound him = Sound_create (numberOfChannels, my xmin + thy xmin, my xmax + thy xmax, n3, my dx, my x1 + thy x1);
-		for (long channel = 1; channel <= numberOfChannels; channel ++) {
-			double *a = my z [my ny == 1 ? 1 : channel];
-			for (long i = n1; i > 0; i --) data1 [i] = a [i];
-			for (long i = n1 + 1; i <= nfft; i ++) data1 [i] = 0.0;
-			a = thy z [thy ny == 1 ? 1 : channel];
-			for (long i = n2; i > 0; i --) data2 [i] = a [i];
-			for (long i = n2 + 1; i <= nfft; i ++) data2 [i] = 0.0;
-			NUMrealft (data1.peek(), nfft, 1);
-			NUMrealft (data2.peek(), nfft, 1);
-			data2 [1] *= data1 [1];
-			data2 [2] *= data1 [2];
-			for (long i = 3; i <= nfft; i += 2) {
-				double temp = data1 [i] * data2 [i] - data1 [i + 1] * data2 [i + 1];
-				data2 [i + 1] = data1 [i] * data2 [i + 1] + data1 [i + 1] * data2 [i];
-				data2 [i] = temp;
-			}
-			NUMrealft (data2.peek(), nfft, -1);
-			a = him -> z [channel];
-			for (long i = 1; i <= n3; i ++) {
-				a [i] = data2 [i];
+		double normalization;   // the factor by which the Fourier transforms have multiplied the result
+		if (Sounds_convolve_preferPartitioned (n1, n2)) {
+			/*
+				One sound is much shorter than the other: convolve block by block.
+			*/
+			Sound kernel = n1 < n2 ? me : thee, signal = n1 < n2 ? thee : me;
+			autoSoundConvolver convolver = SoundConvolver_create (kernel, false);
+			SoundConvolver_convolve (convolver.get(), signal -> z, signal -> ny, 0, 1, signal -> nx, him -> z, 0, 1, n3);
+			normalization = 1.0;
+		} else {
+			long nfft = 2 * NUMfft_getGoodLength ((n3 + 1) / 2);   // even, as NUMrealft requires
+			normalization = nfft;
+			autoNUMvector <double> data1 (1, nfft);
+			autoNUMvector <double> data2 (1, nfft);
+			for (long channel = 1; channel <= numberOfChannels; channel ++) {
+				double *a = my z [my ny == 1 ? 1 : channel];
+				for (long i = n1; i > 0; i --) data1 [i] = a [i];
+				for (long i = n1 + 1; i <= nfft; i ++) data1 [i] = 0.0;
+				a = thy z [thy ny == 1 ? 1 : channel];
+				for (long i = n2; i > 0; i --) data2 [i] = a [i];
+				for (long i = n2 + 1; i <= nfft; i ++) data2 [i] = 0.0;
+				NUMrealft (data1.peek(), nfft, 1);
+				NUMrealft (data2.peek(), nfft, 1);
+				data2 [1] *= data1 [1];
+				data2 [2] *= data1 [2];
+				for (long i = 3; i <= nfft; i += 2) {
+					double temp = data1 [i] * data2 [i] - data1 [i + 1] * data2 [i + 1];
+					data2 [i + 1] = data1 [i] * data2 [i + 1] + data1 [i + 1] * data2 [i];
+					data2 [i] = temp;
+				}
+				NUMrealft (data2.peek(), nfft, -1);
+				a = him -> z [channel];
+				for (long i = 1; i <= n3; i ++) {
+					a [i] = data2 [i];
+				}
 			}
 		}
 		switch (signalOutsideTimeDomain) {
@@ -566,15 +585,15 @@ autoSound Sounds_convolve (Sound me, Sound thee, enum kSounds_convolve_scaling s
 		}
 		switch (scaling) {
 			case kSounds_convolve_scaling_INTEGRAL: {
-				Vector_multiplyByScalar (him.get(), my dx / nfft);
+				Vector_multiplyByScalar (him.get(), my dx / normalization);
 			} break;
 			case kSounds_convolve_scaling_SUM: {
-				Vector_multiplyByScalar (him.get(), 1.0 / nfft);
+				Vector_multiplyByScalar (him.get(), 1.0 / normalization);
 			} break;
 			case kSounds_convolve_scaling_NORMALIZE: {
 				double normalizationFactor = Matrix_getNorm (me) * Matrix_getNorm (thee);
 				if (normalizationFactor != 0.0) {
-					Vector_multiplyByScalar (him.get(), 1.0 / nfft / normalizationFactor);
+					Vector_multiplyByScalar (him.get(), 1.0 / normalization / normalizationFactor);
 				}
 			} break;
 			case kSounds_convolve_scaling_PEAK_099: {
@@ -596,35 +615,61 @@ autoSound Sounds_crossCorrelate (Sound me, Sound thee, enum kSounds_convolve_sca
 			Melder_throw (U"The sampling frequencies of the two sounds have to be equal.");
 		long numberOfChannels = my ny > thy ny ? my ny : thy ny;
 		long n1 = my nx, n2 = thy nx;
-		long n3 = n1 + n2 - 1, nfft = 1;
-		while (nfft < n3) nfft *= 2;
-		autoNUMvector <double> data1 (1, nfft);
-		autoNUMvector <double> data2 (1, nfft);
+		long n3 = n1 + n2 - 1;
 		double my_xlast = my x1 + (n1 - 1) * my dx;
 		autoSound him = Sound_create (numberOfChannels, thy xmin - my xmax, thy xmax - my xmin, n3, my dx, thy x1 - my_xlast);
-		for (long channel = 1; channel <= numberOfChannels; channel ++) {
-			double *a = my z [my ny == 1 ? 1 : channel];
-			for (long i = n1; i > 0; i --) data1 [i] = a [i];
-			for (long i = n1 + 1; i <= nfft; i ++) data1 [i] = 0.0;
-			a = thy z [thy ny == 1 ? 1 : channel];
-			for (long i = n2; i > 0; i --) data2 [i] = a [i];
-			for (long i = n2 + 1; i <= nfft; i ++) data2 [i] = 0.0;
-			NUMrealft (data1.peek(), nfft, 1);
-			NUMrealft (data2.peek(), nfft, 1);
-			data2 [1] *= data1 [1];
-			data2 [2] *= data1 [2];
-			for (long i = 3; i <= nfft; i += 2) {
-				double temp = data1 [i] * data2 [i] + data1 [i + 1] * data2 [i + 1];   // reverse me by taking the conjugate of data1
-				data2 [i + 1] = data1 [i] * data2 [i + 1] - data1 [i + 1] * data2 [i];   // reverse me by taking the conjugate of data1
-				data2 [i] = temp;
-			}
-			NUMrealft (data2.peek(), nfft, -1);
-			a = him -> z [channel];
-			for (long i = 1; i < n1; i ++) {
-				a [i] = data2 [i + (nfft - (n1 - 1))];   // data for the first part ("negative lags") is at the end of data2
+		double normalization;   // the factor by which the Fourier transforms have multiplied the result
+		if (Sounds_convolve_preferPartitioned (n1, n2)) {
+			/*
+				One sound is much shorter than the other: convolve block by block.
+				The cross-correlation is the convolution of the time-reversed me with thee,
+				which is the time-reversed convolution of me with the time-reversed thee.
+			*/
+			if (n1 < n2) {
+				autoSoundConvolver convolver = SoundConvolver_create (me, true);
+				SoundConvolver_convolve (convolver.get(), thy z, thy ny, 0, 1, n2, him -> z, 0, 1, n3);
+			} else {
+				autoSoundConvolver convolver = SoundConvolver_create (thee, true);
+				SoundConvolver_convolve (convolver.get(), my z, my ny, 0, 1, n1, him -> z, 0, 1, n3);
+				for (long channel = 1; channel <= numberOfChannels; channel ++) {
+					double *a = his z [channel];
+					for (long i = 1, j = n3; i < j; i ++, j --) {
+						double temp = a [i];
+						a [i] = a [j];
+						a [j] = temp;
+					}
+				}
 			}
-			for (long i = 1; i <= n2; i ++) {
-				a [i + (n1 - 1)] = data2 [i];   // data for the second part ("positive lags") is at the beginning of data2
+			normalization = 1.0;
+		} else {
+			long nfft = 2 * NUMfft_getGoodLength ((n3 + 1) / 2);   // even, as NUMrealft requires
+			normalization = nfft;
+			autoNUMvector <double> data1 (1, nfft);
+			autoNUMvector <double> data2 (1, nfft);
+			for (long channel = 1; channel <= numberOfChannels; channel ++) {
+				double *a = my z [my ny == 1 ? 1 : channel];
+				for (long i = n1; i > 0; i --) data1 [i] = a [i];
+				for (long i = n1 + 1; i <= nfft; i ++) data1 [i] = 0.0;
+				a = thy z [thy ny == 1 ? 1 : channel];
+				for (long i = n2; i > 0; i --) data2 [i] = a [i];
+				for (long i = n2 + 1; i <= nfft; i ++) data2 [i] = 0.0;
+				NUMrealft (data1.peek(), nfft, 1);
+				NUMrealft (data2.peek(), nfft, 1);
+				data2 [1] *= data1 [1];
+				data2 [2] *= data1 [2];
+				for (long i = 3; i <= nfft; i += 2) {
+					double temp = data1 [i] * data2 [i] + data1 [i + 1] * data2 [i + 1];   // reverse me by taking the conjugate of data1
+					data2 [i + 1] = data1 [i] * data2 [i + 1] - data1 [i + 1] * data2 [i];   // reverse me by taking the conjugate of data1
+					data2 [i] = temp;
+				}
+				NUMrealft (data2.peek(), nfft, -1);
+				a = him -> z [channel];
+				for (long i = 1; i < n1; i ++) {
+					a [i] = data2 [i + (nfft - (n1 - 1))];   // data for the first part ("negative lags") is at the end of data2
+				}
+				for (long i = 1; i <= n2; i ++) {
+					a [i + (n1 - 1)] = data2 [i];   // data for the second part ("positive lags") is at the beginning of data2
+				}
 			}
 		}
 		switch (signalOutsideTimeDomain) {
@@ -649,15 +694,15 @@ autoSound Sounds_crossCorrelate (Sound me, Sound thee, enum kSounds_convolve_sca
 		}
 		switch (scaling) {
 			case kSounds_convolve_scaling_INTEGRAL: {
-				Vector_multiplyByScalar (him.get(), my dx / nfft);
+				Vector_multiplyByScalar (him.get(), my dx / normalization);
 			} break;
 			case kSounds_convolve_scaling_SUM: {
-				Vector_multiplyByScalar (him.get(), 1.0 / nfft);
+				Vector_multiplyByScalar (him.get(), 1.0 / normalization);
 			} break;
 			case kSounds_convolve_scaling_NORMALIZE: {
 				double normalizationFactor = Matrix_getNorm (me) * Matrix_getNorm (thee);
 				if (normalizationFactor != 0.0) {
-					Vector_multiplyByScalar (him.get(), 1.0 / nfft / normalizationFactor);
+					Vector_multiplyByScalar (him.get(), 1.0 / normalization / normalizationFactor);
 				}
 			} break;
 			case kSounds_convolve_scaling_PEAK_099: {
@@ -673,8 +718,7 @@ autoSound Sounds_crossCorrelate (Sound me, Sound thee, enum kSounds_convolve_sca
 
 autoSound Sound_autoCorrelate (Sound me, enum kSounds_convolve_scaling scaling, enum kSounds_convolve_signalOutsideTimeDomain signalOutsideTimeDomain) {
 	try {
-		long numberOfChannels = my ny, n1 = my nx, n2 = n1 + n1 - 1, nfft = 1;
-		while (nfft < n2) nfft *= 2;
+		long numberOfChannels = my ny, n1 = my nx, n2 = n1 + n1 - 1, nfft = 2 * NUMfft_getGoodLength ((n2 + 1) / 2);   // even, as NUMrealft requires
 		autoNUMvector <double> data (1, nfft);
 		double my_xlast = my x1 + (n1 - 1) * my dx;
 		autoSound thee = Sound_create (numberOfChannels, my xmin - my xmax, my xmax - my xmin, n2, my dx, my x1 - my_xlast);
@@ -113,7 +113,9 @@ autoSound Sound_resample (Sound me, double samplingFrequency, long precision);
 /*
 	Method:
 		precision <= 1: linear interpolation.
-		precision >= 2: sinx/x interpolation with maximum depth equal to 'precision'.
+		precision >= 2: sinx/x interpolation with maximum depth equal to 'precision';
+			if the ratio of the sampling frequencies is a ratio of small enough integers,
+			by a polyphase filter bank (see Sound_resample.h), otherwise sample by sample.
 */
 
 autoSound Sounds_append (Sound me, double silenceDuration, Sound thee);
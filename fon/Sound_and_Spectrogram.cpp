@@ -34,15 +34,93 @@
 
 #include "Sound_and_Spectrogram.h"
 #include "NUM2.h"
+#include "MelderThread.h"
 
 #include "enums_getText.h"
 #include "Sound_and_Spectrogram_enums.h"
 #include "enums_getValue.h"
 #include "Sound_and_Spectrogram_enums.h"
 
-autoSpectrogram Sound_to_Spectrogram (Sound me, double effectiveAnalysisWidth, double fmax,
+/*
+	Computes the power spectrum of one frame into spec [1..half_nsampFFT + 1], averaged over the channels,
+	and bins it into column `iframe` of the spectrogram.
+	T is double, or float for the single-precision variant.
+*/
+template <typename T, typename Table>
+static void Sound_into_SpectrogramFrame (Sound me, Spectrogram thee, long iframe,
+	long nsamp_window, long halfnsamp_window, long nsampFFT, long numberOfFreqs, long binWidth_samples, double oneByBinWidth,
+	double *window, Table *fftTable, void (*fft) (Table *, T *), T *frame, T *spec)
+{
+	long half_nsampFFT = nsampFFT / 2;
+	double t = Sampled_indexToX (thee, iframe);
+	long leftSample = Sampled_xToLowIndex (me, t), rightSample = leftSample + 1;
+	long startSample = rightSample - halfnsamp_window;
+	long endSample = leftSample + halfnsamp_window;
+	Melder_assert (startSample >= 1);
+	Melder_assert (endSample <= my nx);
+	for (long i = 1; i <= half_nsampFFT; i ++) {
+		spec [i] = 0.0;
+	}
+	for (long channel = 1; channel <= my ny; channel ++) {
+		for (long j = 1, i = startSample; j <= nsamp_window; j ++) {
+			frame [j] = my z [channel] [i ++] * window [j];
+		}
+		for (long j = nsamp_window + 1; j <= nsampFFT; j ++) frame [j] = 0.0f;
+
+		/* Compute Fast Fourier Transform of the frame. */
+
+		fft (fftTable, frame);   // complex spectrum
+
+		/* Put power spectrum in frame [1..half_nsampFFT + 1]. */
+
+		spec [1] += frame [1] * frame [1];   // DC component
+		for (long i = 2; i <= half_nsampFFT; i ++)
+			spec [i] += frame [i + i - 2] * frame [i + i - 2] + frame [i + i - 1] * frame [i + i - 1];
+		spec [half_nsampFFT + 1] += frame [nsampFFT] * frame [nsampFFT];   // Nyquist frequency. Correct??
+	}
+	if (my ny > 1 ) for (long i = 1; i <= half_nsampFFT; i ++) {
+		spec [i] /= my ny;
+	}
+
+	/* Bin into frame [1..nBands]. */
+	for (long iband = 1; iband <= numberOfFreqs; iband ++) {
+		long leftsample = (iband - 1) * binWidth_samples + 1, rightsample = leftsample + binWidth_samples;
+		float power = 0.0f;
+		for (long i = leftsample; i < rightsample; i ++) power += spec [i];
+		thy z [iband] [iframe] = power * oneByBinWidth;
+	}
+}
+
+/*
+	Analyses all the frames, with one cached FFT table (CachedTable is autoNUMfft_CachedTable or autoNUMfft_CachedTable_f)
+	that all threads share, and a frame and a spectrum for every thread.
+*/
+template <typename T, typename CachedTable, typename Table>
+static void Sound_into_SpectrogramFrames (Sound me, Spectrogram thee,
+	long nsamp_window, long halfnsamp_window, long nsampFFT, long numberOfFreqs, long binWidth_samples, double oneByBinWidth,
+	double *window, void (*fft) (Table *, T *))
+{
+	long numberOfTimes = thy nx;
+	CachedTable fftTable (nsampFFT);
+	const int numberOfThreads = MelderThread_getNumberOfThreadsToUse (numberOfTimes, 10);
+	autoNUMmatrix <T> frames (0, numberOfThreads - 1, 1, nsampFFT), specs (0, numberOfThreads - 1, 1, nsampFFT);
+	MelderThread_forRange (numberOfTimes, numberOfThreads, 10,
+		[&] (long firstFrame, long lastFrame, int ithread) {
+			for (long iframe = firstFrame; iframe <= lastFrame; iframe ++)
+				Sound_into_SpectrogramFrame <T, Table> (me, thee, iframe,
+					nsamp_window, halfnsamp_window, nsampFFT, numberOfFreqs, binWidth_samples, oneByBinWidth,
+					window, fftTable.table, fft, frames [ithread], specs [ithread]);
+		},
+		[&] (double fractionDone) {
+			Melder_progress (fractionDone * numberOfTimes / (numberOfTimes + 1.0),
+				U"Sound to Spectrogram: analysis of frame ", (long) floor (fractionDone * numberOfTimes), U" out of ", numberOfTimes);
+		}
+	);
+}
+
+static autoSpectrogram Sound_to_Spectrogram_any (Sound me, double effectiveAnalysisWidth, double fmax,
 	double minimumTimeStep1, double minimumFreqStep1, enum kSound_to_Spectrogram_windowShape windowType,
-	double maximumTimeOversampling, double maximumFreqOversampling)
+	double maximumTimeOversampling, double maximumFreqOversampling, bool singlePrecision)
 {
 	try {
 		double nyquist = 0.5 / my dx;
@@ -81,7 +159,6 @@ autoSpectrogram Sound_to_Spectrogram (Sound me, double effectiveAnalysisWidth, d
 		long nsampFFT = 1;
 		while (nsampFFT < nsamp_window || nsampFFT < 2 * numberOfFreqs * (nyquist / fmax))
 			nsampFFT *= 2;
-		long half_nsampFFT = nsampFFT / 2;
 
 		/*
 		 * Compute the frequency sampling of the spectrogram.
@@ -96,11 +173,7 @@ autoSpectrogram Sound_to_Spectrogram (Sound me, double effectiveAnalysisWidth, d
 		autoSpectrogram thee = Spectrogram_create (my xmin, my xmax, numberOfTimes, timeStep, t1,
 				0.0, fmax, numberOfFreqs, freqStep, 0.5 * (freqStep - binWidth_hertz));
 
-		autoNUMvector <double> frame (1, nsampFFT);
-		autoNUMvector <double> spec (1, nsampFFT);
 		autoNUMvector <double> window (1, nsamp_window);
-		autoNUMfft_Table fftTable;
-		NUMfft_Table_init (& fftTable, nsampFFT);
 
 		autoMelderProgress progress (U"Sound to Spectrogram...");
 		for (long i = 1; i <= nsamp_window; i ++) {
@@ -133,54 +206,34 @@ autoSpectrogram Sound_to_Spectrogram (Sound me, double effectiveAnalysisWidth, d
 		}
 		double oneByBinWidth = 1.0 / windowssq / binWidth_samples;
 
-		for (long iframe = 1; iframe <= numberOfTimes; iframe ++) {
-			double t = Sampled_indexToX (thee.get(), iframe);
-			long leftSample = Sampled_xToLowIndex (me, t), rightSample = leftSample + 1;
-			long startSample = rightSample - halfnsamp_window;
-			long endSample = leftSample + halfnsamp_window;
-			Melder_assert (startSample >= 1);
-			Melder_assert (endSample <= my nx);
-			for (long i = 1; i <= half_nsampFFT; i ++) {
-				spec [i] = 0.0;
-			}
-			for (long channel = 1; channel <= my ny; channel ++) {
-				for (long j = 1, i = startSample; j <= nsamp_window; j ++) {
-					frame [j] = my z [channel] [i ++] * window [j];
-				}
-				for (long j = nsamp_window + 1; j <= nsampFFT; j ++) frame [j] = 0.0f;
-
-				Melder_progress (iframe / (numberOfTimes + 1.0),
-					U"Sound to Spectrogram: analysis of frame ", iframe, U" out of ", numberOfTimes);
-
-				/* Compute Fast Fourier Transform of the frame. */
-
-				NUMfft_forward (& fftTable, frame.peek());   // complex spectrum
-
-				/* Put power spectrum in frame [1..half_nsampFFT + 1]. */
-
-				spec [1] += frame [1] * frame [1];   // DC component
-				for (long i = 2; i <= half_nsampFFT; i ++)
-					spec [i] += frame [i + i - 2] * frame [i + i - 2] + frame [i + i - 1] * frame [i + i - 1];
-				spec [half_nsampFFT + 1] += frame [nsampFFT] * frame [nsampFFT];   // Nyquist frequency. Correct??
-			}
-			if (my ny > 1 ) for (long i = 1; i <= half_nsampFFT; i ++) {
-				spec [i] /= my ny;
-			}
-
-			/* Bin into frame [1..nBands]. */
-			for (long iband = 1; iband <= numberOfFreqs; iband ++) {
-				long leftsample = (iband - 1) * binWidth_samples + 1, rightsample = leftsample + binWidth_samples;
-				float power = 0.0f;
-				for (long i = leftsample; i < rightsample; i ++) power += spec [i];
-				thy z [iband] [iframe] = power * oneByBinWidth;
-			}
-		}
+		if (singlePrecision)
+			Sound_into_SpectrogramFrames <float, autoNUMfft_CachedTable_f> (me, thee.get(),
+				nsamp_window, halfnsamp_window, nsampFFT, numberOfFreqs, binWidth_samples, oneByBinWidth, window.peek(), NUMfft_forward_f);
+		else
+			Sound_into_SpectrogramFrames <double, autoNUMfft_CachedTable> (me, thee.get(),
+				nsamp_window, halfnsamp_window, nsampFFT, numberOfFreqs, binWidth_samples, oneByBinWidth, window.peek(), NUMfft_forward);
 		return thee;
 	} catch (MelderError) {
 		Melder_throw (me, U": spectrogram analysis not performed.");
 	}
 }
 
+autoSpectrogram Sound_to_Spectrogram (Sound me, double effectiveAnalysisWidth, double fmax,
+	double minimumTimeStep1, double minimumFreqStep1, enum kSound_to_Spectrogram_windowShape windowType,
+	double maximumTimeOversampling, double maximumFreqOversampling)
+{
+	return Sound_to_Spectrogram_any (me, effectiveAnalysisWidth, fmax, minimumTimeStep1, minimumFreqStep1, windowType,
+		maximumTimeOversampling, maximumFreqOversampling, false);
+}
+
+autoSpectrogram Sound_to_Spectrogram_singlePrecision (Sound me, double effectiveAnalysisWidth, double fmax,
+	double minimumTimeStep1, double minimumFreqStep1, enum kSound_to_Spectrogram_windowShape windowType,
+	double maximumTimeOversampling, double maximumFreqOversampling)
+{
+	return Sound_to_Spectrogram_any (me, effectiveAnalysisWidth, fmax, minimumTimeStep1, minimumFreqStep1, windowType,
+		maximumTimeOversampling, maximumFreqOversampling, true);
+}
+
 autoSound Spectrogram_to_Sound (Spectrogram me, double fsamp) {
 	try {
 		double dt = 1 / fsamp;
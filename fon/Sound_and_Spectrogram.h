@@ -27,6 +27,15 @@ autoSpectrogram Sound_to_Spectrogram (Sound me, double effectiveAnalysisWidth, d
 	double minimumTimeStep1, double minimumFreqStep1, enum kSound_to_Spectrogram_windowShape windowShape,
 	double maximumTimeOversampling, double maximumFreqOversampling);
 
+autoSpectrogram Sound_to_Spectrogram_singlePrecision (Sound me, double effectiveAnalysisWidth, double fmax,
+	double minimumTimeStep1, double minimumFreqStep1, enum kSound_to_Spectrogram_windowShape windowShape,
+	double maximumTimeOversampling, double maximumFreqOversampling);
+/*
+	As Sound_to_Spectrogram, but the frames are windowed, transformed and squared in 32-bit floating point,
+	so the resulting power values have float32 precision.
+	Use it where the dB values are all that matters.
+*/
+
 autoSound Spectrogram_to_Sound (Spectrogram me, double fsamp);
 
 /* End of Sound_and_Spectrogram.h */
@@ -42,12 +42,11 @@ autoSpectrum Sound_to_Spectrum (Sound me, int fast) {
 		}
 		long numberOfFrequencies = numberOfSamples / 2 + 1;   // 4 samples -> cos0 cos1 sin1 cos2; 5 samples -> cos0 cos1 sin1 cos2 sin2
 		autoNUMvector <double> data (1, numberOfSamples);
-		autoNUMfft_Table fourierTable;
-		NUMfft_Table_init (& fourierTable, numberOfSamples);
+		autoNUMfft_CachedTable fourierTable (numberOfSamples);
 
 		for (long i = 1; i <= my nx; i ++)
 			data [i] = my ny == 1 ? my z [1] [i] : 0.5 * (my z [1] [i] + my z [2] [i]);
-		NUMfft_forward (& fourierTable, data.peek());
+		NUMfft_forward (fourierTable.table, data.peek());
 		autoSpectrum thee = Spectrum_create (0.5 / my dx, numberOfFrequencies);
 		thy dx = 1.0 / (my dx * numberOfSamples);   // override
 		double *re = thy z [1];
@@ -0,0 +1,213 @@
+/* Sound_convolve.cpp
+ *
+ * Copyright (C) 2016 Paul Boersma
+ *
+ * This code is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this work. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Sound_convolve.h"
+#include "NUM2.h"
+#include "MelderThread.h"
+
+Thing_implement (SoundConvolver, Thing, 0);
+
+autoSoundConvolver SoundConvolver_create (Sound kernel, bool reverseKernel) {
+	try {
+		autoSoundConvolver me = Thing_new (SoundConvolver);
+		my kernelLength = kernel -> nx;
+		my numberOfKernelChannels = kernel -> ny;
+		/*
+			With an FFT length of at least four times the kernel length,
+			at least three quarters of every transform consists of useful output samples.
+		*/
+		long minimumLength = 4 * my kernelLength;
+		if (minimumLength < 8192) minimumLength = 8192;
+		my nfft = NUMfft_getGoodLength (minimumLength);
+		my blockLength = my nfft - my kernelLength + 1;
+		my kernelSpectra.reset (1, my numberOfKernelChannels, 1, my nfft);   // zeroed
+		autoNUMfft_CachedTable table (my nfft);
+		for (long channel = 1; channel <= my numberOfKernelChannels; channel ++) {
+			double *spectrum = my kernelSpectra [channel];
+			for (long i = 1; i <= my kernelLength; i ++)
+				spectrum [i] = kernel -> z [channel] [reverseKernel ? my kernelLength + 1 - i : i];
+			NUMfft_forward (table.table, spectrum);
+			double factor = 1.0 / my nfft;
+			for (long i = 1; i <= my nfft; i ++)
+				spectrum [i] *= factor;
+		}
+		return me;
+	} catch (MelderError) {
+		Melder_throw (kernel, U": cannot be used for convolution.");
+	}
+}
+
+void SoundConvolver_convolve (SoundConvolver me,
+	double **signal, int numberOfSignalChannels, long signalOffset, long firstSignalSample, long lastSignalSample,
+	double **result, long resultOffset, long firstResultSample, long lastResultSample)
+{
+	long numberOfResultSamples = lastResultSample - firstResultSample + 1;
+	if (numberOfResultSamples < 1) return;
+	int numberOfChannels = numberOfSignalChannels > my numberOfKernelChannels ? numberOfSignalChannels : my numberOfKernelChannels;
+	long numberOfBlocks = (numberOfResultSamples - 1) / my blockLength + 1;
+	long numberOfItems = numberOfChannels * numberOfBlocks;
+	int numberOfThreads = MelderThread_getNumberOfThreadsToUse (numberOfItems, 2);
+	autoNUMmatrix <double> buffers (0, numberOfThreads - 1, 1, my nfft);
+	autoNUMfft_CachedTable table (my nfft);
+	long nfft = my nfft, kernelLength = my kernelLength;
+	MelderThread_forRange (numberOfItems, numberOfThreads, 1,
+		[&] (long firstItem, long lastItem, int ithread) {
+			double *data = buffers [ithread];
+			for (long item = firstItem; item <= lastItem; item ++) {
+				int channel = (int) ((item - 1) / numberOfBlocks) + 1;
+				long firstOutput = firstResultSample + ((item - 1) % numberOfBlocks) * my blockLength;
+				long lastOutput = firstOutput + my blockLength - 1;
+				if (lastOutput > lastResultSample) lastOutput = lastResultSample;
+				/*
+					Overlap-save: data [p] is signal sample firstInput - 1 + p,
+					so that output sample k is data [k - firstOutput + kernelLength], free from wrap-around.
+				*/
+				long firstInput = firstOutput - kernelLength + 1;
+				long pmin = firstSignalSample - firstInput + 1, pmax = lastSignalSample - firstInput + 1;
+				if (pmin < 1) pmin = 1;
+				if (pmax > nfft) pmax = nfft;
+				const double *x = signal [numberOfSignalChannels == 1 ? 1 : channel] - signalOffset + firstInput - 1;
+				for (long p = 1; p <= nfft; p ++) data [p] = 0.0;
+				for (long p = pmin; p <= pmax; p ++) data [p] = x [p];
+				NUMfft_forward (table.table, data);
+				const double *h = my kernelSpectra [my numberOfKernelChannels == 1 ? 1 : channel];
+				data [1] *= h [1];
+				for (long k = 2; k < nfft; k += 2) {
+					double re = data [k] * h [k] - data [k + 1] * h [k + 1];
+					data [k + 1] = data [k] * h [k + 1] + data [k + 1] * h [k];
+					data [k] = re;
+				}
+				if (nfft % 2 == 0) data [nfft] *= h [nfft];
+				NUMfft_backward (table.table, data);
+				double *y = result [channel] - resultOffset;
+				for (long k = firstOutput; k <= lastOutput; k ++)
+					y [k] = data [k - firstOutput + kernelLength];
+			}
+		}
+	);
+}
+
+bool Sounds_convolve_preferPartitioned (long numberOfSamples1, long numberOfSamples2) {
+	long shorter = numberOfSamples1 < numberOfSamples2 ? numberOfSamples1 : numberOfSamples2;
+	long longer = numberOfSamples1 < numberOfSamples2 ? numberOfSamples2 : numberOfSamples1;
+	return longer >= 8 * shorter && longer > 65536;
+}
+
+void LongSound_Sound_convolveToAudioFile (LongSound me, Sound thee,
+	enum kSounds_convolve_scaling scaling, enum kSounds_convolve_signalOutsideTimeDomain signalOutsideTimeDomain,
+	MelderFile file, int audioFileType, int numberOfBitsPerSamplePoint)
+{
+	try {
+		if (my numberOfChannels > 1 && thy ny > 1 && my numberOfChannels != thy ny)
+			Melder_throw (U"The numbers of channels of the two sounds have to be equal or 1.");
+		if (fabs (my dx - thy dx) > 1e-9 * my dx)
+			Melder_throw (U"The sampling frequencies of the two sounds have to be equal.");
+		long n1 = my nx, n2 = thy nx, n3 = n1 + n2 - 1;
+		int numberOfChannels = my numberOfChannels > thy ny ? my numberOfChannels : thy ny;
+		autoSoundConvolver convolver = SoundConvolver_create (thee, false);
+		long numberOfBlocksPerPart = (1 << 20) / convolver -> blockLength;
+		if (numberOfBlocksPerPart < 1) numberOfBlocksPerPart = 1;
+		long partLength = numberOfBlocksPerPart * convolver -> blockLength;
+		autoNUMmatrix <double> input (1, my numberOfChannels, 1, partLength + n2 - 1);
+		autoNUMmatrix <double> output (1, numberOfChannels, 1, partLength);
+		long numberOfParts = (n3 - 1) / partLength + 1;
+
+		autoMelderProgress progress (U"Convolving...");
+		auto convolvePart = [&] (long ipart) -> long {
+			long firstOutput = 1 + (ipart - 1) * partLength;
+			long lastOutput = firstOutput + partLength - 1;
+			if (lastOutput > n3) lastOutput = n3;
+			long firstInput = firstOutput - n2 + 1, lastInput = lastOutput;
+			if (firstInput < 1) firstInput = 1;
+			if (lastInput > n1) lastInput = n1;
+			LongSound_readAudioToFloat (me, input.peek(), firstInput, lastInput - firstInput + 1);
+			SoundConvolver_convolve (convolver.get(), input.peek(), my numberOfChannels, firstInput - 1, firstInput, lastInput,
+				output.peek(), firstOutput - 1, firstOutput, lastOutput);
+			if (signalOutsideTimeDomain == kSounds_convolve_signalOutsideTimeDomain_SIMILAR) {
+				double edge = n1 < n2 ? n1 : n2;
+				for (long k = firstOutput; k <= lastOutput; k ++) {
+					long distanceToEdge = k < n3 + 1 - k ? k : n3 + 1 - k;
+					if (distanceToEdge < edge) {
+						for (int channel = 1; channel <= numberOfChannels; channel ++)
+							output [channel] [k - firstOutput + 1] *= edge / distanceToEdge;
+					}
+				}
+			} else if (signalOutsideTimeDomain != kSounds_convolve_signalOutsideTimeDomain_ZERO) {
+				Melder_fatal (U"LongSound_Sound_convolveToAudioFile: unimplemented outside-time-domain strategy ", signalOutsideTimeDomain);
+			}
+			return lastOutput - firstOutput + 1;
+		};
+
+		double factor = 1.0;
+		switch (scaling) {
+			case kSounds_convolve_scaling_INTEGRAL: {
+				factor = my dx;
+			} break;
+			case kSounds_convolve_scaling_SUM: {
+				factor = 1.0;
+			} break;
+			case kSounds_convolve_scaling_NORMALIZE: {
+				double sumOfSquares = 0.0;
+				for (long first = 1; first <= n1; first += partLength) {
+					long n = first + partLength - 1 > n1 ? n1 - first + 1 : partLength;
+					LongSound_readAudioToFloat (me, input.peek(), first, n);
+					for (int channel = 1; channel <= my numberOfChannels; channel ++)
+						for (long i = 1; i <= n; i ++)
+							sumOfSquares += input [channel] [i] * input [channel] [i];
+				}
+				double normalizationFactor = sqrt (sumOfSquares) * Matrix_getNorm (thee);
+				if (normalizationFactor != 0.0)
+					factor = 1.0 / normalizationFactor;
+			} break;
+			case kSounds_convolve_scaling_PEAK_099: {
+				double extremum = 0.0;
+				for (long ipart = 1; ipart <= numberOfParts; ipart ++) {
+					Melder_progress (0.5 * (ipart - 1) / numberOfParts, U"Finding the peak: part ", ipart, U" out of ", numberOfParts);
+					long n = convolvePart (ipart);
+					for (int channel = 1; channel <= numberOfChannels; channel ++)
+						for (long i = 1; i <= n; i ++)
+							if (fabs (output [channel] [i]) > extremum) extremum = fabs (output [channel] [i]);
+				}
+				if (extremum != 0.0)
+					factor = 0.99 / extremum;
+			} break;
+			default: Melder_fatal (U"LongSound_Sound_convolveToAudioFile: unimplemented scaling ", scaling);
+		}
+
+		autoMelderFile mfile = MelderFile_create (file);
+		long sampleRate = lround (my sampleRate);
+		MelderFile_writeAudioFileHeader (file, audioFileType, sampleRate, n3, numberOfChannels, numberOfBitsPerSamplePoint);
+		double progressOffset = scaling == kSounds_convolve_scaling_PEAK_099 ? 0.5 : 0.0;
+		for (long ipart = 1; ipart <= numberOfParts; ipart ++) {
+			Melder_progress (progressOffset + (1.0 - progressOffset) * (ipart - 1) / numberOfParts,
+				U"Convolving: part ", ipart, U" out of ", numberOfParts);
+			long n = convolvePart (ipart);
+			for (int channel = 1; channel <= numberOfChannels; channel ++)
+				for (long i = 1; i <= n; i ++)
+					output [channel] [i] *= factor;
+			MelderFile_writeFloatToAudio (file, numberOfChannels, Melder_defaultAudioFileEncoding (audioFileType, numberOfBitsPerSamplePoint),
+				output.peek(), n, true);
+		}
+		MelderFile_writeAudioFileTrailer (file, audioFileType, sampleRate, n3, numberOfChannels, numberOfBitsPerSamplePoint);
+		mfile.close ();
+	} catch (MelderError) {
+		Melder_throw (me, U" & ", thee, U": not convolved to audio file ", file, U".");
+	}
+}
+
+/* End of file Sound_convolve.cpp */
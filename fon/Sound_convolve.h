@@ -0,0 +1,65 @@
+#ifndef _Sound_convolve_h_
+#define _Sound_convolve_h_
+/* Sound_convolve.h
+ *
+ * Copyright (C) 2016 Paul Boersma
+ *
+ * This code is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this work. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "LongSound.h"
+
+/*
+	Partitioned convolution of a long signal with a short kernel (overlap-save).
+
+	The kernel is transformed once; the signal is cut into blocks of `blockLength` output samples,
+	each of which needs only `nfft` samples of memory, so that the memory does not grow with the signal,
+	and the blocks (and channels) are computed in parallel.
+*/
+Thing_define (SoundConvolver, Thing) {
+	long kernelLength, nfft, blockLength;
+	int numberOfKernelChannels;
+	autoNUMmatrix <double> kernelSpectra;   // [1..numberOfKernelChannels] [1..nfft], divided by nfft
+};
+
+autoSoundConvolver SoundConvolver_create (Sound kernel, bool reverseKernel);
+
+void SoundConvolver_convolve (SoundConvolver me,
+	double **signal, int numberOfSignalChannels, long signalOffset, long firstSignalSample, long lastSignalSample,
+	double **result, long resultOffset, long firstResultSample, long lastResultSample);
+/*
+	Computes the samples firstResultSample..lastResultSample of the convolution of the signal with the kernel,
+	for max (numberOfSignalChannels, numberOfKernelChannels) channels;
+	a mono signal or kernel is used for every channel.
+	Sample i of the signal is signal [channel] [i - signalOffset] if firstSignalSample <= i <= lastSignalSample, and zero otherwise.
+	Sample k of the convolution, i.e. sum (j = 1..kernelLength, kernel [j] * signal [k - j + 1]),
+	goes to result [channel] [k - resultOffset].
+*/
+
+bool Sounds_convolve_preferPartitioned (long numberOfSamples1, long numberOfSamples2);
+/*
+	Whether partitioned convolution pays off: if one sound is much shorter than the other, and the result is not small.
+*/
+
+void LongSound_Sound_convolveToAudioFile (LongSound me, Sound thee,
+	enum kSounds_convolve_scaling scaling, enum kSounds_convolve_signalOutsideTimeDomain signalOutsideTimeDomain,
+	MelderFile file, int audioFileType, int numberOfBitsPerSamplePoint);
+/*
+	Convolves the long sound with the sound and writes the result to an audio file, block by block,
+	so that neither the long sound nor the result ever has to be in memory as a whole.
+	With kSounds_convolve_scaling_PEAK_099, the convolution is computed twice: once to find the peak, once to write.
+*/
+
+/* End of file Sound_convolve.h */
+#endif
@@ -0,0 +1,232 @@
+/* Sound_resample.cpp
+ *
+ * Copyright (C) 2016 Paul Boersma
+ *
+ * This code is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this work. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Sound_resample.h"
+#include "MelderThread.h"
+
+Thing_implement (SoundResampler, Thing, 0);
+
+#define SoundResampler_MAXIMUM_FACTOR  1048576
+#define SoundResampler_MAXIMUM_FILTER_BANK_SIZE  4194304   /* weights, i.e. 32 megabytes */
+
+static long SoundResampler_getHalfWidth (long upfactor, long downfactor, long precision) {
+	return (long) ceil ((precision + 1) * (downfactor > upfactor ? (double) downfactor / upfactor : 1.0));
+}
+
+bool SoundResampler_getFactors (double inputSamplingFrequency, double outputSamplingFrequency, long precision,
+	long *upfactor, long *downfactor)
+{
+	double ratio = outputSamplingFrequency / inputSamplingFrequency;
+	if (! (ratio > 0.0)) return false;
+	/*
+		The convergents of the continued fraction of the ratio are its best rational approximations.
+	*/
+	double x = ratio;
+	double p = 1.0, previousP = 0.0, q = 0.0, previousQ = 1.0;
+	for (int iteration = 1; iteration <= 40; iteration ++) {
+		double a = floor (x);
+		double newP = a * p + previousP, newQ = a * q + previousQ;
+		if (newP > SoundResampler_MAXIMUM_FACTOR || newQ > SoundResampler_MAXIMUM_FACTOR) return false;
+		previousP = p, p = newP;
+		previousQ = q, q = newQ;
+		if (fabs (p / q - ratio) <= 1e-12 * ratio) {
+			long halfWidth = SoundResampler_getHalfWidth ((long) p, (long) q, precision);
+			if (p * (2.0 * halfWidth + 1.0) > SoundResampler_MAXIMUM_FILTER_BANK_SIZE) return false;
+			*upfactor = (long) p;
+			*downfactor = (long) q;
+			return true;
+		}
+		if (x == a) return false;
+		x = 1.0 / (x - a);
+	}
+	return false;
+}
+
+autoSoundResampler SoundResampler_create (long upfactor, long downfactor, double firstIndex, long precision) {
+	try {
+		autoSoundResampler me = Thing_new (SoundResampler);
+		my upfactor = upfactor;
+		my downfactor = downfactor;
+		my firstInputSample = (long) floor (firstIndex);
+		double firstFraction = firstIndex - my firstInputSample;   // 0 <= firstFraction < 1
+		/*
+			The output sample lies at a distance u (0 <= u < 2) to the right of the base input sample;
+			the filter weights are nonzero only within the half-width around that position.
+		*/
+		long halfWidth = SoundResampler_getHalfWidth (upfactor, downfactor, precision);
+		my firstTap = 1 - halfWidth;
+		my numberOfTaps = 2 * halfWidth + 1;
+		double cutoff = upfactor < downfactor ? (double) upfactor / downfactor : 1.0;   // relative to the input Nyquist frequency
+		double windowHalfWidth = (precision + 1) / cutoff;
+		my filters.reset (0, upfactor - 1, 1, my numberOfTaps);
+		for (long phase = 0; phase < upfactor; phase ++) {
+			double u = firstFraction + (double) phase / upfactor;
+			double *filter = my filters [phase], sum = 0.0;
+			for (long tap = 1; tap <= my numberOfTaps; tap ++) {
+				double distance = u - (my firstTap + tap - 1);
+				if (fabs (distance) >= windowHalfWidth) {
+					filter [tap] = 0.0;
+				} else {
+					double phi = NUMpi * cutoff * distance;
+					filter [tap] = ( phi == 0.0 ? cutoff : cutoff * sin (phi) / phi ) *
+						0.5 * (1.0 + cos (NUMpi * distance / windowHalfWidth));
+				}
+				sum += filter [tap];
+			}
+			/*
+				Normalize each phase to unit gain at zero frequency, so that a constant signal stays constant.
+			*/
+			if (sum != 0.0)
+				for (long tap = 1; tap <= my numberOfTaps; tap ++)
+					filter [tap] /= sum;
+		}
+		return me;
+	} catch (MelderError) {
+		Melder_throw (U"Resampler not created.");
+	}
+}
+
+static inline long SoundResampler_getBaseInputSample (SoundResampler me, long outputSample, long *phase) {
+	int64 position = (int64) (outputSample - 1) * my downfactor;
+	*phase = (long) (position % my upfactor);
+	return my firstInputSample + (long) (position / my upfactor);
+}
+
+long SoundResampler_getFirstInputSample (SoundResampler me, long outputSample) {
+	long phase;
+	return SoundResampler_getBaseInputSample (me, outputSample, & phase) + my firstTap;
+}
+
+long SoundResampler_getLastInputSample (SoundResampler me, long outputSample) {
+	long phase;
+	return SoundResampler_getBaseInputSample (me, outputSample, & phase) + my firstTap + my numberOfTaps - 1;
+}
+
+void SoundResampler_resample (SoundResampler me,
+	double **signal, int numberOfChannels, long signalOffset, long firstSignalSample, long lastSignalSample,
+	double **result, long resultOffset, long firstResultSample, long lastResultSample)
+{
+	long numberOfResultSamples = lastResultSample - firstResultSample + 1;
+	if (numberOfResultSamples < 1) return;
+	const long blockLength = 4096;
+	long numberOfBlocks = (numberOfResultSamples - 1) / blockLength + 1;
+	long numberOfItems = numberOfChannels * numberOfBlocks;
+	int numberOfThreads = MelderThread_getNumberOfThreadsToUse (numberOfItems, 1);
+	long numberOfTaps = my numberOfTaps;
+	MelderThread_forRange (numberOfItems, numberOfThreads, 1,
+		[&] (long firstItem, long lastItem, int /* ithread */) {
+			for (long item = firstItem; item <= lastItem; item ++) {
+				int channel = (int) ((item - 1) / numberOfBlocks) + 1;
+				long firstOutput = firstResultSample + ((item - 1) % numberOfBlocks) * blockLength;
+				long lastOutput = firstOutput + blockLength - 1;
+				if (lastOutput > lastResultSample) lastOutput = lastResultSample;
+				const double *x = signal [channel] - signalOffset;
+				double *y = result [channel] - resultOffset;
+				for (long k = firstOutput; k <= lastOutput; k ++) {
+					long phase;
+					long first = SoundResampler_getBaseInputSample (me, k, & phase) + my firstTap;
+					const double *h = & my filters [phase] [1];
+					if (first >= firstSignalSample && first + numberOfTaps - 1 <= lastSignalSample) {
+						/*
+							The inner product, with four independent sums, so that the additions can be pipelined.
+						*/
+						const double *xx = & x [first];
+						double sum0 = 0.0, sum1 = 0.0, sum2 = 0.0, sum3 = 0.0;
+						long tap = 0;
+						for (; tap + 3 < numberOfTaps; tap += 4) {
+							sum0 += h [tap] * xx [tap];
+							sum1 += h [tap + 1] * xx [tap + 1];
+							sum2 += h [tap + 2] * xx [tap + 2];
+							sum3 += h [tap + 3] * xx [tap + 3];
+						}
+						for (; tap < numberOfTaps; tap ++)
+							sum0 += h [tap] * xx [tap];
+						y [k] = (sum0 + sum1) + (sum2 + sum3);
+					} else {
+						long tapmin = firstSignalSample - first, tapmax = lastSignalSample - first;
+						if (tapmin < 0) tapmin = 0;
+						if (tapmax > numberOfTaps - 1) tapmax = numberOfTaps - 1;
+						double sum = 0.0;
+						for (long tap = tapmin; tap <= tapmax; tap ++)
+							sum += h [tap] * x [first + tap];
+						y [k] = sum;
+					}
+				}
+			}
+		}
+	);
+}
+
+void LongSound_resampleToAudioFile (LongSound me, double samplingFrequency, long precision,
+	MelderFile file, int audioFileType, int numberOfBitsPerSamplePoint)
+{
+	try {
+		long upfactor, downfactor;
+		if (! SoundResampler_getFactors (1.0 / my dx, samplingFrequency, precision, & upfactor, & downfactor))
+			Melder_throw (U"The ratio of the sampling frequencies (", samplingFrequency, U" Hz and ", 1.0 / my dx,
+				U" Hz) is not a ratio of small enough integers.");
+		long numberOfSamples = lround ((my xmax - my xmin) * samplingFrequency);
+		if (numberOfSamples < 1)
+			Melder_throw (U"The resampled sound would have no samples.");
+		double x1 = 0.5 * (my xmin + my xmax - (numberOfSamples - 1) / samplingFrequency);   // as in Sound_resample
+		autoSoundResampler resampler = SoundResampler_create (upfactor, downfactor, Sampled_xToIndex (me, x1), precision);
+
+		const long partLength = 1 << 20;
+		long numberOfParts = (numberOfSamples - 1) / partLength + 1;
+		/*
+			Depending on the phase at which it starts, a part can need one input sample more than the first part,
+			so the input buffer is sized for the longest part.
+		*/
+		long maximumInputLength = 1;
+		for (long ipart = 1; ipart <= numberOfParts; ipart ++) {
+			long firstOutput = 1 + (ipart - 1) * partLength, lastOutput = firstOutput + partLength - 1;
+			long inputLength = SoundResampler_getLastInputSample (resampler.get(), lastOutput) -
+				SoundResampler_getFirstInputSample (resampler.get(), firstOutput) + 1;
+			if (inputLength > maximumInputLength) maximumInputLength = inputLength;
+		}
+		autoNUMmatrix <double> input (1, my numberOfChannels, 1, maximumInputLength);
+		autoNUMmatrix <double> output (1, my numberOfChannels, 1, partLength);
+
+		autoMelderProgress progress (U"Resampling...");
+		autoMelderFile mfile = MelderFile_create (file);
+		long sampleRate = lround (samplingFrequency);
+		MelderFile_writeAudioFileHeader (file, audioFileType, sampleRate, numberOfSamples, my numberOfChannels, numberOfBitsPerSamplePoint);
+		for (long ipart = 1; ipart <= numberOfParts; ipart ++) {
+			Melder_progress ((double) (ipart - 1) / numberOfParts, U"Resampling: part ", ipart, U" out of ", numberOfParts);
+			long firstOutput = 1 + (ipart - 1) * partLength;
+			long lastOutput = firstOutput + partLength - 1;
+			if (lastOutput > numberOfSamples) lastOutput = numberOfSamples;
+			long firstInput = SoundResampler_getFirstInputSample (resampler.get(), firstOutput);
+			long lastInput = SoundResampler_getLastInputSample (resampler.get(), lastOutput);
+			if (firstInput < 1) firstInput = 1;
+			if (lastInput > my nx) lastInput = my nx;
+			if (lastInput >= firstInput)
+				LongSound_readAudioToFloat (me, input.peek(), firstInput, lastInput - firstInput + 1);
+			SoundResampler_resample (resampler.get(), input.peek(), my numberOfChannels, firstInput - 1, firstInput, lastInput,
+				output.peek(), firstOutput - 1, firstOutput, lastOutput);
+			MelderFile_writeFloatToAudio (file, my numberOfChannels, Melder_defaultAudioFileEncoding (audioFileType, numberOfBitsPerSamplePoint),
+				output.peek(), lastOutput - firstOutput + 1, true);
+		}
+		MelderFile_writeAudioFileTrailer (file, audioFileType, sampleRate, numberOfSamples, my numberOfChannels, numberOfBitsPerSamplePoint);
+		mfile.close ();
+	} catch (MelderError) {
+		Melder_throw (me, U": not resampled to audio file ", file, U".");
+	}
+}
+
+/* End of file Sound_resample.cpp */
@@ -0,0 +1,73 @@
+#ifndef _Sound_resample_h_
+#define _Sound_resample_h_
+/* Sound_resample.h
+ *
+ * Copyright (C) 2016 Paul Boersma
+ *
+ * This code is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this work. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "LongSound.h"
+
+/*
+	Polyphase resampling by a rational factor upfactor / downfactor.
+
+	Output sample i lies at the input index firstIndex + (i - 1) * downfactor / upfactor,
+	so that only `upfactor` different fractional positions occur; for each of these "phases"
+	the weights of a Hann-windowed sinc filter are computed once, and every output sample
+	is then a single inner product of a row of `filters` with the input.
+	The filter both interpolates and, when downsampling, removes the frequencies above the new Nyquist frequency;
+	its half-width is precision + 1 periods of the lower of the two sampling frequencies.
+*/
+Thing_define (SoundResampler, Thing) {
+	long upfactor, downfactor;
+	long firstInputSample;   // the floor of the input index of output sample 1
+	long firstTap, numberOfTaps;   // output sample i depends on the input samples base + firstTap .. base + firstTap + numberOfTaps - 1
+	autoNUMmatrix <double> filters;   // [0..upfactor-1] [1..numberOfTaps]
+};
+
+bool SoundResampler_getFactors (double inputSamplingFrequency, double outputSamplingFrequency, long precision,
+	long *upfactor, long *downfactor);
+/*
+	Finds the smallest upfactor / downfactor that equals the ratio of the sampling frequencies
+	to within rounding error. Returns false if there is no such ratio with a filter bank of reasonable size;
+	the caller should then interpolate in some other way.
+*/
+
+autoSoundResampler SoundResampler_create (long upfactor, long downfactor, double firstIndex, long precision);
+
+long SoundResampler_getFirstInputSample (SoundResampler me, long outputSample);
+long SoundResampler_getLastInputSample (SoundResampler me, long outputSample);
+/*
+	The range of input samples that output sample `outputSample` depends on.
+*/
+
+void SoundResampler_resample (SoundResampler me,
+	double **signal, int numberOfChannels, long signalOffset, long firstSignalSample, long lastSignalSample,
+	double **result, long resultOffset, long firstResultSample, long lastResultSample);
+/*
+	Computes the output samples firstResultSample..lastResultSample for each channel.
+	Sample i of the signal is signal [channel] [i - signalOffset] if firstSignalSample <= i <= lastSignalSample, and zero otherwise.
+	Output sample k goes to result [channel] [k - resultOffset].
+*/
+
+void LongSound_resampleToAudioFile (LongSound me, double samplingFrequency, long precision,
+	MelderFile file, int audioFileType, int numberOfBitsPerSamplePoint);
+/*
+	Does what Sound_resample would do, part by part,
+	so that neither the long sound nor the result ever has to be in memory as a whole.
+*/
+
+/* End of file Sound_resample.h */
+#endif
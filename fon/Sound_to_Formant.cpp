@@ -31,6 +31,7 @@
 #include "Sound_to_Formant.h"
 #include "NUM2.h"
 #include "Polynomial.h"
+#include "MelderThread.h"
 
 static void burg (double sample [], long nsamp_window, double cof [], int nPoles,
 	Formant_Frame frame, double nyquistFrequency, double safetyMargin)
@@ -48,11 +49,14 @@ static void burg (double sample [], long nsamp_window, double cof [], int nPoles
 
 	/*
 	 * Find the roots of the polynomial.
+	 * This runs on worker threads, so it should not issue messages;
+	 * if no roots can be found, the frame stays without formants.
 	 */
-	autoRoots roots = Polynomial_to_Roots (polynomial.get());
-	Roots_fixIntoUnitCircle (roots.get());
-
 	Melder_assert (frame -> nFormants == 0 && ! frame -> formant);
+	bool allRootsFound;
+	autoRoots roots = Polynomial_to_Roots_quiet (polynomial.get(), & allRootsFound);
+	if (! roots) return;
+	Roots_fixIntoUnitCircle (roots.get());
 
 	/*
 	 * First pass: count the formants.
@@ -93,16 +97,8 @@ static int findOneZero (int ijt, double vcx [], double a, double b, double *zero
 		fa = vcx [k] + a * fa;
 		fb = vcx [k] + b * fb;
 	}
-	if (fa * fb >= 0.0) {   // there should be a zero between a and b
-		Melder_casual (
-			U"There is no zero between ,", Melder_single (a),
-			U" and ", Melder_single (b),
-			U".\n    The function values are ", Melder_single (fa),
-			U" and ", Melder_single (fb),
-			U", respectively."
-		);
-		return 0;
-	}
+	if (fa * fb >= 0.0)   // there should be a zero between a and b
+		return 0;   // silently, because this runs in worker threads; the caller reports
 	do {
 		fx = 0.0;
 		/*x = fa == fb ? 0.5 * (a + b) : a + fa * (a - b) / (fb - fa);*/
@@ -138,13 +134,8 @@ static int findNewZeroes (int ijt, double ppORIG [], int degree,
 	/* Fill an array with the new zeroes, which lie between the old zeroes. */
 	newZeroes [0] = 1.0;
 	for (i = 1; i <= half_degree; i ++) {
-		if (! findOneZero (ijt, px, zeroes [i - 1], zeroes [i], & newZeroes [i])) {
-			Melder_casual (
-				U"Degree ", degree,
-				U" not completed."
-			);
-			return 0;
-		}
+		if (! findOneZero (ijt, px, zeroes [i - 1], zeroes [i], & newZeroes [i]))
+			return 0;   // degree not completed
 	}
 	newZeroes [half_degree + 1] = -1.0;
 	/* Grow older. */
@@ -264,6 +255,56 @@ void Formant_sort (Formant me) {
 	}
 }
 
+static inline double Sound_getMonoValueAtSample (Sound me, long isamp) {
+	if (my ny == 1) return my z [1] [isamp];
+	if (my ny == 2) return 0.5 * (my z [1] [isamp] + my z [2] [isamp]);
+	double sum = 0.0;
+	for (long channel = 1; channel <= my ny; channel ++)
+		sum += my z [channel] [isamp];
+	return sum / my ny;
+}
+
+/*
+	Returns false if the split-Levinson analysis could not find all the zeroes,
+	i.e. if the results for this frame will be wrong.
+*/
+static bool Sound_into_FormantFrame (Sound me, Formant thee, long iframe, int numberOfPoles,
+	long nsamp_window, long halfnsamp_window, int which, double safetyMargin,
+	double *window, double *frame, double *cof)
+{
+	double t = Sampled_indexToX (thee, iframe);
+	long leftSample = Sampled_xToLowIndex (me, t);
+	long rightSample = leftSample + 1;
+	long startSample = rightSample - halfnsamp_window;
+	long endSample = leftSample + halfnsamp_window;
+	double maximumIntensity = 0.0;
+	if (startSample < 1) startSample = 1;
+	if (endSample > my nx) endSample = my nx;
+	for (long i = startSample; i <= endSample; i ++) {
+		double value = Sound_getMonoValueAtSample (me, i);
+		if (value * value > maximumIntensity) {
+			maximumIntensity = value * value;
+		}
+	}
+	if (maximumIntensity == HUGE_VAL)
+		Melder_throw (U"Sound contains infinities.");
+	thy d_frames [iframe]. intensity = maximumIntensity;
+	if (maximumIntensity == 0.0) return true;   // Burg cannot stand all zeroes
+
+	/* Copy a pre-emphasized window to a frame (only the part that is analysed). */
+	long numberOfSamples = endSample - startSample + 1;
+	Melder_assert (numberOfSamples <= nsamp_window);
+	for (long j = 1, i = startSample; j <= numberOfSamples; j ++)
+		frame [j] = Sound_getMonoValueAtSample (me, i ++) * window [j];
+
+	if (which == 1) {
+		burg (frame, numberOfSamples, cof, numberOfPoles, & thy d_frames [iframe], 0.5 / my dx, safetyMargin);
+	} else if (which == 2) {
+		return splitLevinson (frame, numberOfSamples, numberOfPoles, & thy d_frames [iframe], 0.5 / my dx);
+	}
+	return true;
+}
+
 static autoFormant Sound_to_Formant_any_inline (Sound me, double dt_in, int numberOfPoles,
 	double halfdt_window, int which, double preemphasisFrequency, double safetyMargin)
 {
@@ -284,8 +325,15 @@ static autoFormant Sound_to_Formant_any_inline (Sound me, double dt_in, int numb
 	}
 	autoFormant thee = Formant_create (my xmin, my xmax, nFrames, dt, t1, (numberOfPoles + 1) / 2);   // e.g. 11 poles -> maximally 6 formants
 	autoNUMvector <double> window (1, nsamp_window);
-	autoNUMvector <double> frame (1, nsamp_window);
-	autoNUMvector <double> cof (1, numberOfPoles);   // superfluous if which==2, but nobody uses that anyway
+
+	/*
+	 * Every thread gets its own frame and coefficients;
+	 * apart from Formant_sort, the frames are independent.
+	 */
+	const int numberOfThreads = MelderThread_getNumberOfThreadsToUse (nFrames, 20);
+	autoNUMmatrix <double> frames (0, numberOfThreads - 1, 1, nsamp_window);
+	autoNUMmatrix <double> cofs (0, numberOfThreads - 1, 1, numberOfPoles);   // superfluous if which==2, but nobody uses that anyway
+	autoNUMvector <long> numberOfWrongFrames ((long) 0, numberOfThreads - 1);   // counted per thread, reported afterwards
 
 	autoMelderProgress progress (U"Formant analysis...");
 
@@ -298,42 +346,28 @@ static autoFormant Sound_to_Formant_any_inline (Sound me, double dt_in, int numb
 		window [i] = (exp (-48.0 * (i - imid) * (i - imid) / (nsamp_window + 1) / (nsamp_window + 1)) - edge) / (1.0 - edge);
 	}
 
-	for (long iframe = 1; iframe <= nFrames; iframe ++) {
-		double t = Sampled_indexToX (thee.get(), iframe);
-		long leftSample = Sampled_xToLowIndex (me, t);
-		long rightSample = leftSample + 1;
-		long startSample = rightSample - halfnsamp_window;
-		long endSample = leftSample + halfnsamp_window;
-		double maximumIntensity = 0.0;
-		if (startSample < 1) startSample = 1;
-		if (endSample > my nx) endSample = my nx;
-		for (long i = startSample; i <= endSample; i ++) {
-			double value = Sampled_getValueAtSample (me, i, Sound_LEVEL_MONO, 0);
-			if (value * value > maximumIntensity) {
-				maximumIntensity = value * value;
-			}
-		}
-		if (maximumIntensity == HUGE_VAL)
-			Melder_throw (U"Sound contains infinities.");
-		thy d_frames [iframe]. intensity = maximumIntensity;
-		if (maximumIntensity == 0.0) continue;   // Burg cannot stand all zeroes
-
-		/* Copy a pre-emphasized window to a frame. */
-		for (long j = 1, i = startSample; j <= nsamp_window; j ++)
-			frame [j] = Sampled_getValueAtSample (me, i ++, Sound_LEVEL_MONO, 0) * window [j];
-
-		if (which == 1) {
-			burg (frame.peek(), endSample - startSample + 1, cof.peek(), numberOfPoles, & thy d_frames [iframe], 0.5 / my dx, safetyMargin);
-		} else if (which == 2) {
-			if (! splitLevinson (frame.peek(), endSample - startSample + 1, numberOfPoles, & thy d_frames [iframe], 0.5 / my dx)) {
-				Melder_clearError ();
-				Melder_casual (U"(Sound_to_Formant:)"
-					U" Analysis results of frame ", iframe,
-					U" will be wrong."
-				);
-			}
+	MelderThread_forRange (nFrames, numberOfThreads, 10,
+		[&] (long firstFrame, long lastFrame, int ithread) {
+			for (long iframe = firstFrame; iframe <= lastFrame; iframe ++)
+				if (! Sound_into_FormantFrame (me, thee.get(), iframe, numberOfPoles, nsamp_window, halfnsamp_window,
+					which, safetyMargin, window.peek(), frames [ithread], cofs [ithread]))
+				{
+					numberOfWrongFrames [ithread] ++;
+				}
+		},
+		[&] (double fractionDone) {
+			Melder_progress (fractionDone, U"Formant analysis: frame ", (long) floor (fractionDone * nFrames));
 		}
-		Melder_progress ((double) iframe / (double) nFrames, U"Formant analysis: frame ", iframe);
+	);
+	long totalNumberOfWrongFrames = 0;
+	for (int ithread = 0; ithread < numberOfThreads; ithread ++)
+		totalNumberOfWrongFrames += numberOfWrongFrames [ithread];
+	if (totalNumberOfWrongFrames > 0) {
+		Melder_clearError ();
+		Melder_casual (U"(Sound_to_Formant:)"
+			U" Analysis results of ", totalNumberOfWrongFrames, U" out of ", nFrames,
+			U" frames will be wrong."
+		);
 	}
 	Formant_sort (thee.get());
 	return thee;
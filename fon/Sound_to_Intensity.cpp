@@ -32,6 +32,151 @@
  */
 
 #include "Sound_to_Intensity.h"
+#include "NUM2.h"
+#include "MelderThread.h"
+
+/*
+	The energy of the sound in the window around `midSample`, weighted by `window [- halfWindowSamples .. halfWindowSamples]`:
+	sumxw receives the weighted sum of the squared (possibly mean-subtracted) amplitudes of all channels, sumw the sum of the weights.
+*/
+static void Sound_getWindowedEnergy (Sound me, long midSample, long halfWindowSamples, const double window [], int subtractMeanPressure,
+	double *out_sumxw, double *out_sumw)
+{
+	long leftSample = midSample - halfWindowSamples, rightSample = midSample + halfWindowSamples;
+	double sumxw = 0.0, sumw = 0.0;
+	if (leftSample < 1) leftSample = 1;
+	if (rightSample > my nx) rightSample = my nx;
+	for (long channel = 1; channel <= my ny; channel ++) {
+		const double *amplitude = my z [channel];
+		double mean = 0.0;
+		if (subtractMeanPressure) {
+			double sum = 0.0;
+			for (long i = leftSample; i <= rightSample; i ++) {
+				sum += amplitude [i];
+			}
+			mean = sum / (rightSample - leftSample + 1);
+		}
+		for (long i = leftSample; i <= rightSample; i ++) {
+			double x = amplitude [i] - mean;
+			sumxw += x * x * window [i - midSample];
+			sumw += window [i - midSample];
+		}
+	}
+	*out_sumxw = sumxw;
+	*out_sumw = sumw;
+}
+
+/*
+	If the frames lie much closer together than the window is long, most of the work of Sound_getWindowedEnergy
+	is done for several frames over again. In that case we compute the windowed sums for all samples at once,
+	as convolutions of x^2 and x with the window, by FFT blocks (overlap-save), using
+		sum w (x - m)^2 = sum w x^2 - 2 m sum w x + m^2 sum w,
+	where m is the mean of x in the window. The results are those of Sound_getWindowedEnergy up to rounding,
+	except that a window whose samples are all zero (or all equal, if the mean is subtracted) gets an energy of exactly zero,
+	as it should in order to stay at -300 dB.
+	The rounding errors of the FFT are relative to the loudest sample in the block, so a frame that is more than 70 dB
+	softer than that is left undefined, for the caller to compute directly.
+	Only frames whose window lies entirely within the sound are handled here; on return, frameEnergy [iframe] = sumxw / sumw.
+*/
+static void Sound_into_energies_fft (Sound me, long numberOfFrames, const long midSample [], long halfWindowSamples,
+	const double window [], int subtractMeanPressure, double frameEnergy [])
+{
+	long nfft = 2;
+	while (nfft < 8 * halfWindowSamples) nfft *= 2;
+	long blockLength = nfft - 2 * halfWindowSamples;   // the number of window centres per FFT block
+	long firstCentre = halfWindowSamples + 1, lastCentre = my nx - halfWindowSamples;
+	if (lastCentre < firstCentre) return;
+	long numberOfBlocks = (lastCentre - firstCentre) / blockLength + 1;
+	/*
+		The frames whose window centres lie in each block.
+	*/
+	autoNUMvector <long> firstFrameOfBlock (1, numberOfBlocks + 1);
+	for (long iblock = 1, iframe = 1; iblock <= numberOfBlocks + 1; iblock ++) {
+		long blockStart = iblock <= numberOfBlocks ? firstCentre + (iblock - 1) * blockLength : lastCentre + 1;
+		while (iframe <= numberOfFrames && midSample [iframe] < blockStart) iframe ++;
+		firstFrameOfBlock [iblock] = iframe;
+	}
+	autoNUMfft_CachedTable fftTable (nfft);
+	/*
+		The spectrum of the window (which is symmetric), with sample 0 at the start and the negative samples wrapped around.
+	*/
+	double windowSum = 0.0;
+	for (long i = - halfWindowSamples; i <= halfWindowSamples; i ++) windowSum += window [i];
+	autoNUMvector <double> windowSpectrum (1, nfft);
+	for (long i = - halfWindowSamples; i <= halfWindowSamples; i ++)
+		windowSpectrum [(i + nfft) % nfft + 1] = window [i];
+	NUMfft_forward (fftTable.table, windowSpectrum.peek());
+
+	const int numberOfThreads = MelderThread_getNumberOfThreadsToUse (numberOfBlocks, 1);
+	autoNUMmatrix <double> squares (0, numberOfThreads - 1, 1, nfft);
+	autoNUMmatrix <double> amplitudes (0, numberOfThreads - 1, 1, nfft);
+	autoNUMmatrix <double> cumulativeSums (0, numberOfThreads - 1, 0, nfft);
+	autoNUMmatrix <long> cumulativeChanges (0, numberOfThreads - 1, 0, nfft);
+	auto convolveWithWindow = [&] (double *data) {
+		NUMfft_forward (fftTable.table, data);
+		data [1] *= windowSpectrum [1];
+		for (long k = 2; k < nfft; k += 2) {
+			double re = data [k] * windowSpectrum [k] - data [k + 1] * windowSpectrum [k + 1];
+			double im = data [k] * windowSpectrum [k + 1] + data [k + 1] * windowSpectrum [k];
+			data [k] = re;
+			data [k + 1] = im;
+		}
+		data [nfft] *= windowSpectrum [nfft];
+		NUMfft_backward (fftTable.table, data);
+	};
+	MelderThread_forRange (numberOfBlocks, numberOfThreads, 1,
+		[&] (long firstBlock, long lastBlock, int ithread) {
+			double *xx = squares [ithread], *x = amplitudes [ithread], *cumulativeSum = cumulativeSums [ithread];
+			long *cumulativeChange = cumulativeChanges [ithread];
+			for (long iblock = firstBlock; iblock <= lastBlock; iblock ++) {
+				long firstFrame = firstFrameOfBlock [iblock], lastFrame = firstFrameOfBlock [iblock + 1] - 1;
+				if (lastFrame < firstFrame) continue;
+				long blockStart = firstCentre + (iblock - 1) * blockLength;
+				long firstSample = blockStart - halfWindowSamples;   // sample t of the segment is my z [channel] [firstSample + t - 1]
+				for (long iframe = firstFrame; iframe <= lastFrame; iframe ++)
+					frameEnergy [iframe] = 0.0;
+				for (long channel = 1; channel <= my ny; channel ++) {
+					const double *amplitude = my z [channel];
+					cumulativeSum [0] = 0.0;
+					cumulativeChange [0] = 0;
+					double maximumSquare = 0.0;
+					for (long t = 1; t <= nfft; t ++) {
+						long isample = firstSample + t - 1;
+						double value = isample <= my nx ? amplitude [isample] : 0.0;
+						xx [t] = value * value;
+						if (xx [t] > maximumSquare) maximumSquare = xx [t];
+						x [t] = value;
+						cumulativeSum [t] = cumulativeSum [t - 1] + value;
+						bool change = subtractMeanPressure ? t > 1 && value != x [t - 1] : value != 0.0;
+						cumulativeChange [t] = cumulativeChange [t - 1] + change;
+					}
+					convolveWithWindow (xx);
+					if (subtractMeanPressure) convolveWithWindow (x);
+					double minimumReliableEnergy = 1e-7 * maximumSquare * windowSum;
+					for (long iframe = firstFrame; iframe <= lastFrame; iframe ++) {
+						if (! NUMdefined (frameEnergy [iframe])) continue;
+						long first = midSample [iframe] - halfWindowSamples - firstSample + 1, last = first + 2 * halfWindowSamples;
+						long centre = first + halfWindowSamples;
+						long numberOfChanges = cumulativeChange [last] - cumulativeChange [subtractMeanPressure ? first : first - 1];
+						if (numberOfChanges == 0) continue;   // silence, or (with mean subtraction) a constant
+						double energy = xx [centre] / nfft;
+						if (subtractMeanPressure) {
+							double mean = (cumulativeSum [last] - cumulativeSum [first - 1]) / (2 * halfWindowSamples + 1);
+							energy += mean * (mean * windowSum - 2.0 * x [centre] / nfft);
+						}
+						if (energy < minimumReliableEnergy)
+							frameEnergy [iframe] = NUMundefined;
+						else
+							frameEnergy [iframe] += energy;
+					}
+				}
+				for (long iframe = firstFrame; iframe <= lastFrame; iframe ++)
+					if (NUMdefined (frameEnergy [iframe]))
+						frameEnergy [iframe] /= my ny * windowSum;
+			}
+		}
+	);
+}
 
 static autoIntensity Sound_to_Intensity_ (Sound me, double minimumPitch, double timeStep, int subtractMeanPressure) {
 	try {
@@ -52,7 +197,6 @@ static autoIntensity Sound_to_Intensity_ (Sound me, double minimumPitch, double
 		Melder_assert (windowDuration > 0.0);
 		double halfWindowDuration = 0.5 * windowDuration;
 		long halfWindowSamples = (long) floor (halfWindowDuration / my dx);
-		autoNUMvector <double> amplitude (- halfWindowSamples, halfWindowSamples);
 		autoNUMvector <double> window (- halfWindowSamples, halfWindowSamples);
 
 		for (long i = - halfWindowSamples; i <= halfWindowSamples; i ++) {
@@ -69,35 +213,38 @@ static autoIntensity Sound_to_Intensity_ (Sound me, double minimumPitch, double
 				U"i.e. at least ", 6.4 / minimumPitch, U" s, instead of ", my xmax - my xmin, U" s.");
 		}
 		autoIntensity thee = Intensity_create (my xmin, my xmax, numberOfFrames, timeStep, thyFirstTime);
+		autoNUMvector <long> midSample (1, numberOfFrames);
+		autoNUMvector <double> energy (1, numberOfFrames);
 		for (long iframe = 1; iframe <= numberOfFrames; iframe ++) {
 			double midTime = Sampled_indexToX (thee.get(), iframe);
-			long midSample = Sampled_xToNearestIndex (me, midTime);
-			long leftSample = midSample - halfWindowSamples, rightSample = midSample + halfWindowSamples;
-			double sumxw = 0.0, sumw = 0.0, intensity;
-			if (leftSample < 1) leftSample = 1;
-			if (rightSample > my nx) rightSample = my nx;
-
-			for (long channel = 1; channel <= my ny; channel ++) {
-				for (long i = leftSample; i <= rightSample; i ++) {
-					amplitude [i - midSample] = my z [channel] [i];
-				}
-				if (subtractMeanPressure) {
-					double sum = 0.0;
-					for (long i = leftSample; i <= rightSample; i ++) {
-						sum += amplitude [i - midSample];
-					}
-					double mean = sum / (rightSample - leftSample + 1);
-					for (long i = leftSample; i <= rightSample; i ++) {
-						amplitude [i - midSample] -= mean;
+			midSample [iframe] = Sampled_xToNearestIndex (me, midTime);
+		}
+		/*
+			The direct sums take about 2 * halfWindowSamples + 1 steps per frame; the convolutions take
+			about 2 * log2 (nfft) equally expensive steps per sample (as measured), i.e. per timeStep / my dx samples per frame.
+		*/
+		double samplesPerFrame = timeStep / my dx;
+		bool useFFT = 2 * halfWindowSamples + 1 > samplesPerFrame * 2.0 * log2 (8.0 * halfWindowSamples + 1.0);
+		if (useFFT) {
+			Sound_into_energies_fft (me, numberOfFrames, midSample.peek(), halfWindowSamples, window.peek(), subtractMeanPressure, energy.peek());
+		}
+		const int numberOfThreads = MelderThread_getNumberOfThreadsToUse (numberOfFrames, 20);
+		MelderThread_forRange (numberOfFrames, numberOfThreads, 10,
+			[&] (long firstFrame, long lastFrame, int /* ithread */) {
+				for (long iframe = firstFrame; iframe <= lastFrame; iframe ++) {
+					if (useFFT && midSample [iframe] > halfWindowSamples && midSample [iframe] + halfWindowSamples <= my nx &&
+						NUMdefined (energy [iframe]))
+					{
+						continue;   // done by Sound_into_energies_fft
 					}
-				}
-				for (long i = leftSample; i <= rightSample; i ++) {
-					sumxw += amplitude [i - midSample] * amplitude [i - midSample] * window [i - midSample];
-					sumw += window [i - midSample];
+					double sumxw, sumw;
+					Sound_getWindowedEnergy (me, midSample [iframe], halfWindowSamples, window.peek(), subtractMeanPressure, & sumxw, & sumw);
+					energy [iframe] = sumxw / sumw;
 				}
 			}
-			intensity = sumxw / sumw;
-			intensity /= 4e-10;
+		);
+		for (long iframe = 1; iframe <= numberOfFrames; iframe ++) {
+			double intensity = energy [iframe] / 4e-10;
 			thy z [1] [iframe] = intensity < 1e-30 ? -300 : 10 * log10 (intensity);
 		}
 		return thee;
@@ -41,15 +41,16 @@
 #define FCC_NORMAL  2
 #define FCC_ACCURATE  3
 
-static void Sound_into_PitchFrame (Sound me, Pitch_Frame pitchFrame, double t,
-	double minimumPitch, int maxnCandidates, int method, double voicingThreshold, double octaveCost,
-	NUMfft_Table fftTable, double dt_window, long nsamp_window, long halfnsamp_window,
-	long maximumLag, long nsampFFT, long nsamp_period, long halfnsamp_period,
-	long brent_ixmax, long brent_depth, double globalPeak,
-	double **frame, double *ac, double *window, double *windowR,
-	double *r, long *imax, double *localMean)
+/*
+	The part of the analysis of a frame that Sound_into_PitchFrame and Sound_into_PitchFrame_refine share:
+	computes the local means, copies the (windowed) frames with their local mean subtracted,
+	zero-padded up to nsampFFT, and sets the intensity of the frame.
+	Returns the local peak.
+*/
+static double Sound_into_PitchFrame_window (Sound me, Pitch_Frame pitchFrame, double t, int method,
+	long nsamp_window, long halfnsamp_window, long nsampFFT, long nsamp_period, long halfnsamp_period,
+	double globalPeak, double *window, double **frame, double *localMean)
 {
-	double localPeak;
 	long leftSample = Sampled_xToLowIndex (me, t), rightSample = leftSample + 1;
 	long startSample, endSample;
 
@@ -89,7 +90,7 @@ static void Sound_into_PitchFrame (Sound me, Pitch_Frame pitchFrame, double t,
 	/*
 	 * Compute the local peak; look half a longest period to both sides.
 	 */
-	localPeak = 0.0;
+	double localPeak = 0.0;
 	if ((startSample = halfnsamp_window + 1 - halfnsamp_period) < 1) startSample = 1;
 	if ((endSample = halfnsamp_window + halfnsamp_period) > nsamp_window) endSample = nsamp_window;
 	for (long channel = 1; channel <= my ny; channel ++) {
@@ -99,6 +100,21 @@ static void Sound_into_PitchFrame (Sound me, Pitch_Frame pitchFrame, double t,
 		}
 	}
 	pitchFrame->intensity = localPeak > globalPeak ? 1.0 : localPeak / globalPeak;
+	return localPeak;
+}
+
+static void Sound_into_PitchFrame (Sound me, Pitch_Frame pitchFrame, double t,
+	double minimumPitch, int maxnCandidates, int method, double voicingThreshold, double octaveCost,
+	NUMfft_Table fftTable, double dt_window, long nsamp_window, long halfnsamp_window,
+	long maximumLag, long nsampFFT, long nsamp_period, long halfnsamp_period,
+	long brent_ixmax, long brent_depth, double globalPeak,
+	double **frame, double *ac, double *window, double *windowR,
+	double *xSpectrum, double *ySpectrum,
+	double *r, long *imax, double *localMean)
+{
+	double localPeak = Sound_into_PitchFrame_window (me, pitchFrame, t, method,
+		nsamp_window, halfnsamp_window, nsampFFT, nsamp_period, halfnsamp_period, globalPeak, window, frame, localMean);
+	long startSample;
 
 	/*
 	 * Compute the correlation into the array 'r'.
@@ -120,20 +136,61 @@ static void Sound_into_PitchFrame (Sound me, Pitch_Frame pitchFrame, double t,
 		}
 		double sumy2 = sumx2;   // at zero lag, these are still equal
 		r [0] = 1.0;
-		for (long i = 1; i <= localMaximumLag; i ++) {
-			double product = 0.0;
+		if (nsampFFT > 0) {
+			/*
+			 * Compute the products for all lags at once: they are the inverse transform of the cross spectrum
+			 * of the window (x) and the window extended with all lags (y).
+			 * With nsampFFT >= localSpan there is no wrap-around for nonnegative lags.
+			 */
+			for (long i = 1; i <= nsampFFT; i ++) {
+				ac [i] = 0.0;
+			}
 			for (long channel = 1; channel <= my ny; channel ++) {
 				double *amp = my z [channel] + offset;
-				double y0 = amp [i] - localMean [channel];
-				double yZ = amp [i + nsamp_window] - localMean [channel];
-				sumy2 += yZ * yZ - y0 * y0;
-				for (long j = 1; j <= nsamp_window; j ++) {
-					double x = amp [j] - localMean [channel];
-					double y = amp [i + j] - localMean [channel];
-					product += x * y;
+				for (long i = 1; i <= nsamp_window; i ++)
+					xSpectrum [i] = amp [i] - localMean [channel];
+				for (long i = nsamp_window + 1; i <= nsampFFT; i ++)
+					xSpectrum [i] = 0.0;
+				for (long i = 1; i <= localSpan; i ++)
+					ySpectrum [i] = amp [i] - localMean [channel];
+				for (long i = localSpan + 1; i <= nsampFFT; i ++)
+					ySpectrum [i] = 0.0;
+				NUMfft_forward (fftTable, xSpectrum);
+				NUMfft_forward (fftTable, ySpectrum);
+				ac [1] += xSpectrum [1] * ySpectrum [1];   // DC component
+				for (long i = 2; i < nsampFFT; i += 2) {   // conjugate of x times y
+					ac [i] += xSpectrum [i] * ySpectrum [i] + xSpectrum [i+1] * ySpectrum [i+1];
+					ac [i+1] += xSpectrum [i] * ySpectrum [i+1] - xSpectrum [i+1] * ySpectrum [i];
+				}
+				if (nsampFFT % 2 == 0)
+					ac [nsampFFT] += xSpectrum [nsampFFT] * ySpectrum [nsampFFT];   // Nyquist frequency
+			}
+			NUMfft_backward (fftTable, ac);   // cross-correlation, times nsampFFT
+			for (long i = 1; i <= localMaximumLag; i ++) {
+				for (long channel = 1; channel <= my ny; channel ++) {
+					double *amp = my z [channel] + offset;
+					double y0 = amp [i] - localMean [channel];
+					double yZ = amp [i + nsamp_window] - localMean [channel];
+					sumy2 += yZ * yZ - y0 * y0;
+				}
+				r [- i] = r [i] = ac [i + 1] / nsampFFT / sqrt (sumx2 * sumy2);
+			}
+		} else {
+			for (long i = 1; i <= localMaximumLag; i ++) {
+				double product = 0.0;
+				for (long channel = 1; channel <= my ny; channel ++) {
+					double *amp = my z [channel] + offset;
+					double y0 = amp [i] - localMean [channel];
+					double yZ = amp [i + nsamp_window] - localMean [channel];
+					sumy2 += yZ * yZ - y0 * y0;
+					for (long j = 1; j <= nsamp_window; j ++) {
+						double x = amp [j] - localMean [channel];
+						double y = amp [i + j] - localMean [channel];
+						product += x * y;
+					}
 				}
+				r [- i] = r [i] = product / sqrt (sumx2 * sumy2);
 			}
-			r [- i] = r [i] = product / sqrt (sumx2 * sumy2);
 		}
 	} else {
 
@@ -242,102 +299,287 @@ static void Sound_into_PitchFrame (Sound me, Pitch_Frame pitchFrame, double t,
 	}
 }
 
-Thing_define (Sound_into_Pitch_Args, Thing) { public:
-	Sound sound;
-	Pitch pitch;
-	long firstFrame, lastFrame;
-	double minimumPitch;
-	int maxnCandidates, method;
-	double voicingThreshold, octaveCost, dt_window;
-	long nsamp_window, halfnsamp_window, maximumLag, nsampFFT, nsamp_period, halfnsamp_period, brent_ixmax, brent_depth;
-	double globalPeak, *window, *windowR;
-	bool isMainThread;
-	volatile int *cancelled;
-};
+Thing_implement (Sound_to_Pitch_Setup, Thing, 0);
+
+/*
+	Everything that depends only on the sampling period and the settings;
+	'duration' is the duration of the signal (0.0 if not known in advance).
+*/
+static autoSound_to_Pitch_Setup Sound_to_Pitch_Setup_create (double samplingPeriod, double duration,
+	double dt, double minimumPitch, double periodsPerWindow, int maxnCandidates, int method, double ceiling)
+{
+	autoSound_to_Pitch_Setup setup = Thing_new (Sound_to_Pitch_Setup);
+	const double dx = samplingPeriod;
+	double dt_window;   // window length in seconds
+	long nsamp_window, halfnsamp_window;   // number of samples per window
+	long minimumLag, maximumLag;
+	long nsampFFT;
+	double interpolation_depth = 0.0;
+	long nsamp_period, halfnsamp_period;   // number of samples in longest period
+	long brent_ixmax, brent_depth = 0;
+
+	if (maxnCandidates < ceiling / minimumPitch) maxnCandidates = (long) floor (ceiling / minimumPitch);
+
+	if (dt <= 0.0) dt = periodsPerWindow / minimumPitch / 4.0;   // e.g. 3 periods, 75 Hz: 10 milliseconds
+
+	switch (method) {
+		case AC_HANNING:
+			brent_depth = NUM_PEAK_INTERPOLATE_SINC70;
+			interpolation_depth = 0.5;
+			break;
+		case AC_GAUSS:
+			periodsPerWindow *= 2;   // because Gaussian window is twice as long
+			brent_depth = NUM_PEAK_INTERPOLATE_SINC700;
+			interpolation_depth = 0.25;   // because Gaussian window is twice as long
+			break;
+		case FCC_NORMAL:
+			brent_depth = NUM_PEAK_INTERPOLATE_SINC70;
+			interpolation_depth = 1.0;
+			break;
+		case FCC_ACCURATE:
+			brent_depth = NUM_PEAK_INTERPOLATE_SINC700;
+			interpolation_depth = 1.0;
+			break;
+	}
+	if (duration > 0.0 && minimumPitch < periodsPerWindow / duration)
+		Melder_throw (U"To analyse this Sound, ", U_LEFT_DOUBLE_QUOTE, U"minimum pitch", U_RIGHT_DOUBLE_QUOTE, U" must not be less than ", periodsPerWindow / duration, U" Hz.");
+
+	/*
+	 * Determine the number of samples in the longest period.
+	 * We need this to compute the local mean of the sound (looking one period in both directions),
+	 * and to compute the local peak of the sound (looking half a period in both directions).
+	 */
+	nsamp_period = (long) floor (1 / dx / minimumPitch);
+	halfnsamp_period = nsamp_period / 2 + 1;
+
+	if (ceiling > 0.5 / dx) ceiling = 0.5 / dx;
+
+	/*
+	 * Determine window length in seconds and in samples.
+	 */
+	dt_window = periodsPerWindow / minimumPitch;
+	nsamp_window = (long) floor (dt_window / dx);
+	halfnsamp_window = nsamp_window / 2 - 1;
+	if (halfnsamp_window < 2)
+		Melder_throw (U"Analysis window too short.");
+	nsamp_window = halfnsamp_window * 2;
+
+	/*
+	 * Determine the minimum and maximum lags.
+	 */
+	minimumLag = (long) floor (1 / dx / ceiling);
+	if (minimumLag < 2) minimumLag = 2;
+	maximumLag = (long) floor (nsamp_window / periodsPerWindow) + 2;
+	if (maximumLag > nsamp_window) maximumLag = nsamp_window;
+
+	if (method >= FCC_NORMAL) {   /* For cross-correlation analysis. */
+
+		/*
+		 * The products for all lags can be computed directly, with nsamp_window * maximumLag multiplications,
+		 * or with three FFTs of a length that holds the window plus all lags.
+		 */
+		nsampFFT = NUMfft_getGoodLength (nsamp_window + maximumLag);
+		if (nsamp_window * maximumLag < 3 * nsampFFT * (long) ceil (NUMlog2 (nsampFFT)))
+			nsampFFT = 0;   // direct computation is cheaper
+		brent_ixmax = (long) floor (nsamp_window * interpolation_depth);
+
+	} else {   /* For autocorrelation analysis. */
+
+		/*
+		* Compute the number of samples needed for doing FFT.
+		* To avoid edge effects, we have to append zeroes to the window.
+		* The maximum lag considered for maxima is maximumLag.
+		* The maximum lag used in interpolation is nsamp_window * interpolation_depth.
+		*/
+		nsampFFT = 1; while (nsampFFT < nsamp_window * (1 + interpolation_depth)) nsampFFT *= 2;
+
+		/*
+		* Create buffers for autocorrelation analysis.
+		*/
+		autoNUMfft_Table fftTable;
+		setup -> windowR.reset (1, nsampFFT);
+		setup -> window.reset (1, nsamp_window);
+		double *window = setup -> window.peek(), *windowR = setup -> windowR.peek();
+		NUMfft_Table_init (& fftTable, nsampFFT);
+
+		/*
+		* A Gaussian or Hanning window is applied against phase effects.
+		* The Hanning window is 2 to 5 dB better for 3 periods/window.
+		* The Gaussian window is 25 to 29 dB better for 6 periods/window.
+		*/
+		if (method == AC_GAUSS) {   /* Gaussian window. */
+			double imid = 0.5 * (nsamp_window + 1), edge = exp (-12.0);
+			for (long i = 1; i <= nsamp_window; i ++)
+				window [i] = (exp (-48.0 * (i - imid) * (i - imid) /
+					(nsamp_window + 1) / (nsamp_window + 1)) - edge) / (1 - edge);
+		} else {   // Hanning window
+			for (long i = 1; i <= nsamp_window; i ++)
+				window [i] = 0.5 - 0.5 * cos (i * 2 * NUMpi / (nsamp_window + 1));
+		}
+
+		/*
+		* Compute the normalized autocorrelation of the window.
+		*/
+		for (long i = 1; i <= nsamp_window; i ++) windowR [i] = window [i];
+		NUMfft_forward (& fftTable, windowR);
+		windowR [1] *= windowR [1];   // DC component
+		for (long i = 2; i < nsampFFT; i += 2) {
+			windowR [i] = windowR [i] * windowR [i] + windowR [i+1] * windowR [i+1];
+			windowR [i + 1] = 0.0;   // power spectrum: square and zero
+		}
+		windowR [nsampFFT] *= windowR [nsampFFT];   // Nyquist frequency
+		NUMfft_backward (& fftTable, windowR);   // autocorrelation
+		for (long i = 2; i <= nsamp_window; i ++) windowR [i] /= windowR [1];   // normalize
+		windowR [1] = 1.0;   // normalize
+
+		brent_ixmax = (long) floor (nsamp_window * interpolation_depth);
+	}
+
+	setup -> dt = dt;
+	setup -> ceiling = ceiling;
+	setup -> maxnCandidates = maxnCandidates;
+	setup -> dt_window = dt_window;
+	setup -> nsamp_window = nsamp_window;
+	setup -> halfnsamp_window = halfnsamp_window;
+	setup -> minimumLag = minimumLag;
+	setup -> maximumLag = maximumLag;
+	setup -> nsampFFT = nsampFFT;
+	setup -> interpolation_depth = interpolation_depth;
+	setup -> nsamp_period = nsamp_period;
+	setup -> halfnsamp_period = halfnsamp_period;
+	setup -> brent_ixmax = brent_ixmax;
+	setup -> brent_depth = brent_depth;
+	return setup;
+}
+
+static autoSound_to_Pitch_Setup Sound_to_Pitch_Setup_createForSound (Sound me,
+	double dt, double minimumPitch, double periodsPerWindow, int maxnCandidates, int method, double ceiling)
+{
+	autoSound_to_Pitch_Setup setup = Sound_to_Pitch_Setup_create (my dx, my dx * my nx,
+		dt, minimumPitch, periodsPerWindow, maxnCandidates, method, ceiling);
+
+	/*
+	 * Determine the number of frames.
+	 * Fit as many frames as possible symmetrically in the total duration.
+	 * We do this even for the forward cross-correlation method,
+	 * because that allows us to compare the two methods.
+	 */
+	try {
+		Sampled_shortTermAnalysis (me, method >= FCC_NORMAL ? 1 / minimumPitch + setup -> dt_window : setup -> dt_window, setup -> dt, & setup -> nFrames, & setup -> t1);
+	} catch (MelderError) {
+		Melder_throw (U"The pitch analysis would give zero pitch frames.");
+	}
+
+	/*
+	 * Compute the global absolute peak for determination of silence threshold.
+	 */
+	double globalPeak = 0.0;
+	for (long channel = 1; channel <= my ny; channel ++) {
+		double mean = 0.0;
+		for (long i = 1; i <= my nx; i ++) {
+			mean += my z [channel] [i];
+		}
+		mean /= my nx;
+		for (long i = 1; i <= my nx; i ++) {
+			double value = fabs (my z [channel] [i] - mean);
+			if (value > globalPeak) globalPeak = value;
+		}
+	}
+	setup -> globalPeak = globalPeak;
+	return setup;
+}
 
 Thing_implement (Sound_into_Pitch_Args, Thing, 0);
 
-static autoSound_into_Pitch_Args Sound_into_Pitch_Args_create (Sound sound, Pitch pitch,
-	long firstFrame, long lastFrame, double minimumPitch, int maxnCandidates, int method,
-	double voicingThreshold, double octaveCost,
-	double dt_window, long nsamp_window, long halfnsamp_window, long maximumLag, long nsampFFT,
-	long nsamp_period, long halfnsamp_period, long brent_ixmax, long brent_depth,
-	double globalPeak, double *window, double *windowR,
-	bool isMainThread, volatile int *cancelled)
+static autoSound_into_Pitch_Args Sound_into_Pitch_Args_create (Sound sound, Pitch pitch, Sound_to_Pitch_Setup setup,
+	double minimumPitch, int method, double voicingThreshold, double octaveCost)
 {
 	autoSound_into_Pitch_Args me = Thing_new (Sound_into_Pitch_Args);
 	my sound = sound;
 	my pitch = pitch;
-	my firstFrame = firstFrame;
-	my lastFrame = lastFrame;
+	my setup = setup;
 	my minimumPitch = minimumPitch;
-	my maxnCandidates = maxnCandidates;
 	my method = method;
 	my voicingThreshold = voicingThreshold;
 	my octaveCost = octaveCost;
-	my dt_window = dt_window;
-	my nsamp_window = nsamp_window;
-	my halfnsamp_window = halfnsamp_window;
-	my maximumLag = maximumLag;
-	my nsampFFT = nsampFFT;
-	my nsamp_period = nsamp_period;
-	my halfnsamp_period = halfnsamp_period;
-	my brent_ixmax = brent_ixmax;
-	my brent_depth = brent_depth;
-	my globalPeak = globalPeak;
-	my window = window;
-	my windowR = windowR;
-	my isMainThread = isMainThread;
-	my cancelled = cancelled;
+	long nsampFFT = setup -> nsampFFT;
+	if (method >= FCC_NORMAL) {   // cross-correlation
+		my frame.reset (1, sound -> ny, 1, setup -> nsamp_window);
+		if (nsampFFT > 0) {
+			NUMfft_Table_init (& my fftTable, nsampFFT);
+			my ac.reset (1, nsampFFT);
+			my xSpectrum.reset (1, nsampFFT);
+			my ySpectrum.reset (1, nsampFFT);
+		}
+	} else {   // autocorrelation
+		NUMfft_Table_init (& my fftTable, nsampFFT);
+		my frame.reset (1, sound -> ny, 1, nsampFFT);
+		my ac.reset (1, nsampFFT);
+	}
+	my r.reset (- setup -> nsamp_window, setup -> nsamp_window);
+	my imax.reset (1, setup -> maxnCandidates);
+	my localMean.reset (1, sound -> ny);
 	return me;
 }
 
-MelderThread_MUTEX (mutex);
-bool mutex_inited;
+static void Sound_into_Pitch (Sound_into_Pitch_Args me, long firstFrame, long lastFrame) {
+	Sound_to_Pitch_Setup setup = my setup;
+	for (long iframe = firstFrame; iframe <= lastFrame; iframe ++) {
+		Pitch_Frame pitchFrame = & my pitch -> frame [iframe];
+		double t = Sampled_indexToX (my pitch, iframe);
+		Sound_into_PitchFrame (my sound, pitchFrame, t,
+			my minimumPitch, setup -> maxnCandidates, my method, my voicingThreshold, my octaveCost,
+			& my fftTable, setup -> dt_window, setup -> nsamp_window, setup -> halfnsamp_window,
+			setup -> maximumLag, setup -> nsampFFT, setup -> nsamp_period, setup -> halfnsamp_period,
+			setup -> brent_ixmax, setup -> brent_depth, setup -> globalPeak,
+			my frame.peek(), my ac.peek(), setup -> window.peek(), setup -> windowR.peek(),
+			my xSpectrum.peek(), my ySpectrum.peek(),
+			my r.peek(), my imax.peek(), my localMean.peek());
+	}
+}
 
-static MelderThread_RETURN_TYPE Sound_into_Pitch (Sound_into_Pitch_Args me)
+/*
+	Computes the candidates of all frames, without choosing a path.
+*/
+static autoPitch Sound_to_Pitch_findCandidates (Sound me, Sound_to_Pitch_Setup setup,
+	double minimumPitch, int method, double voicingThreshold, double octaveCost,
+	double progressStart, double progressEnd)
 {
-	autoNUMfft_Table fftTable;
-	autoNUMmatrix <double> frame;
-	autoNUMvector <double> ac, r, localMean;
-	autoNUMvector <long> imax;
-	{// scope
-		MelderThread_LOCK (mutex);
-		if (my method >= FCC_NORMAL) {   // cross-correlation
-			frame.reset (1, my sound -> ny, 1, my nsamp_window);
-		} else {   // autocorrelation
-			NUMfft_Table_init (& fftTable, my nsampFFT);
-			frame.reset (1, my sound -> ny, 1, my nsampFFT);
-			ac.reset (1, my nsampFFT);
-		}
-		r.reset (- my nsamp_window, my nsamp_window);
-		imax.reset (1, my maxnCandidates);
-		localMean.reset (1, my sound -> ny);
-		MelderThread_UNLOCK (mutex);
+	long nFrames = setup -> nFrames;
+
+	/*
+	 * Create the resulting pitch contour.
+	 */
+	autoPitch thee = Pitch_create (my xmin, my xmax, nFrames, setup -> dt, setup -> t1, setup -> ceiling, setup -> maxnCandidates);
+
+	/*
+	 * Create (too much) space for candidates.
+	 */
+	for (long iframe = 1; iframe <= nFrames; iframe ++) {
+		Pitch_Frame pitchFrame = & thy frame [iframe];
+		Pitch_Frame_init (pitchFrame, setup -> maxnCandidates);
 	}
-	for (long iframe = my firstFrame; iframe <= my lastFrame; iframe ++) {
-		Pitch_Frame pitchFrame = & my pitch -> frame [iframe];
-		double t = Sampled_indexToX (my pitch, iframe);
-		if (my isMainThread) {
-			try {
-				Melder_progress (0.1 + 0.8 * (iframe - my firstFrame) / (my lastFrame - my firstFrame),
-					U"Sound to Pitch: analysing ", my lastFrame, U" frames");
-			} catch (MelderError) {
-				*my cancelled = 1;
-				throw;
-			}
-		} else if (*my cancelled) {
-			MelderThread_RETURN;
+
+	if (setup -> globalPeak == 0.0) {
+		return thee;
+	}
+
+	const int numberOfThreads = MelderThread_getNumberOfThreadsToUse (nFrames, 20);
+	trace (numberOfThreads, U" threads");
+	std::vector <autoSound_into_Pitch_Args> args (numberOfThreads);
+	for (int ithread = 0; ithread < numberOfThreads; ithread ++) {
+		args [ithread] = Sound_into_Pitch_Args_create (me, thee.get(), setup,
+			minimumPitch, method, voicingThreshold, octaveCost);
+	}
+	MelderThread_forRange (nFrames, numberOfThreads, 5,
+		[&] (long firstFrame, long lastFrame, int ithread) {
+			Sound_into_Pitch (args [ithread].get(), firstFrame, lastFrame);
+		},
+		[&] (double fractionDone) {
+			Melder_progress (progressStart + (progressEnd - progressStart) * fractionDone, U"Sound to Pitch: analysing ", nFrames, U" frames");
 		}
-		Sound_into_PitchFrame (my sound, pitchFrame, t,
-			my minimumPitch, my maxnCandidates, my method, my voicingThreshold, my octaveCost,
-			& fftTable, my dt_window, my nsamp_window, my halfnsamp_window,
-			my maximumLag, my nsampFFT, my nsamp_period, my halfnsamp_period,
-			my brent_ixmax, my brent_depth, my globalPeak,
-			frame.peek(), ac.peek(), my window, my windowR,
-			r.peek(), imax.peek(), localMean.peek());
-	}
-	MelderThread_RETURN;
+	);
+	return thee;
 }
 
 autoPitch Sound_to_Pitch_any (Sound me,
@@ -347,209 +589,621 @@ autoPitch Sound_to_Pitch_any (Sound me,
 	double octaveCost, double octaveJumpCost, double voicedUnvoicedCost, double ceiling)
 {
 	try {
-		autoNUMfft_Table fftTable;
-		double duration, t1;
-		double dt_window;   // window length in seconds
-		long nsamp_window, halfnsamp_window;   // number of samples per window
-		long nFrames, minimumLag, maximumLag;
-		long nsampFFT;
-		double interpolation_depth;
-		long nsamp_period, halfnsamp_period;   // number of samples in longest period
-		long brent_ixmax, brent_depth;
-		double globalPeak;
-
 		Melder_assert (maxnCandidates >= 2);
 		Melder_assert (method >= AC_HANNING && method <= FCC_ACCURATE);
 
-		if (maxnCandidates < ceiling / minimumPitch) maxnCandidates = (long) floor (ceiling / minimumPitch);
-
-		if (dt <= 0.0) dt = periodsPerWindow / minimumPitch / 4.0;   // e.g. 3 periods, 75 Hz: 10 milliseconds
-
-		switch (method) {
-			case AC_HANNING:
-				brent_depth = NUM_PEAK_INTERPOLATE_SINC70;
-				interpolation_depth = 0.5;
-				break;
-			case AC_GAUSS:
-				periodsPerWindow *= 2;   // because Gaussian window is twice as long
-				brent_depth = NUM_PEAK_INTERPOLATE_SINC700;
-				interpolation_depth = 0.25;   // because Gaussian window is twice as long
-				break;
-			case FCC_NORMAL:
-				brent_depth = NUM_PEAK_INTERPOLATE_SINC70;
-				interpolation_depth = 1.0;
-				break;
-			case FCC_ACCURATE:
-				brent_depth = NUM_PEAK_INTERPOLATE_SINC700;
-				interpolation_depth = 1.0;
-				break;
-		}
-		duration = my dx * my nx;
-		if (minimumPitch < periodsPerWindow / duration)
-			Melder_throw (U"To analyse this Sound, ", U_LEFT_DOUBLE_QUOTE, U"minimum pitch", U_RIGHT_DOUBLE_QUOTE, U" must not be less than ", periodsPerWindow / duration, U" Hz.");
+		autoSound_to_Pitch_Setup setup = Sound_to_Pitch_Setup_createForSound (me, dt, minimumPitch, periodsPerWindow, maxnCandidates, method, ceiling);
 
-		/*
-		 * Determine the number of samples in the longest period.
-		 * We need this to compute the local mean of the sound (looking one period in both directions),
-		 * and to compute the local peak of the sound (looking half a period in both directions).
-		 */
-		nsamp_period = (long) floor (1 / my dx / minimumPitch);
-		halfnsamp_period = nsamp_period / 2 + 1;
+		autoMelderProgress progress (U"Sound to Pitch...");
 
-		if (ceiling > 0.5 / my dx) ceiling = 0.5 / my dx;
+		autoPitch thee = Sound_to_Pitch_findCandidates (me, setup.get(), minimumPitch, method, voicingThreshold, octaveCost, 0.1, 0.9);
+		if (setup -> globalPeak == 0.0) {
+			return thee;
+		}
 
-		/*
-		 * Determine window length in seconds and in samples.
-		 */
-		dt_window = periodsPerWindow / minimumPitch;
-		nsamp_window = (long) floor (dt_window / my dx);
-		halfnsamp_window = nsamp_window / 2 - 1;
-		if (halfnsamp_window < 2)
-			Melder_throw (U"Analysis window too short.");
-		nsamp_window = halfnsamp_window * 2;
+		Melder_progress (0.95, U"Sound to Pitch: path finder");
+		Pitch_pathFinder (thee.get(), silenceThreshold, voicingThreshold,
+			octaveCost, octaveJumpCost, voicedUnvoicedCost, setup -> ceiling, Melder_debug == 31 ? true : false);
 
-		/*
-		 * Determine the minimum and maximum lags.
-		 */
-		minimumLag = (long) floor (1 / my dx / ceiling);
-		if (minimumLag < 2) minimumLag = 2;
-		maximumLag = (long) floor (nsamp_window / periodsPerWindow) + 2;
-		if (maximumLag > nsamp_window) maximumLag = nsamp_window;
+		return thee;
+	} catch (MelderError) {
+		Melder_throw (me, U": pitch analysis not performed.");
+	}
+}
 
-		/*
-		 * Determine the number of frames.
-		 * Fit as many frames as possible symmetrically in the total duration.
-		 * We do this even for the forward cross-correlation method,
-		 * because that allows us to compare the two methods.
-		 */
-		try {
-			Sampled_shortTermAnalysis (me, method >= FCC_NORMAL ? 1 / minimumPitch + dt_window : dt_window, dt, & nFrames, & t1);
-		} catch (MelderError) {
-			Melder_throw (U"The pitch analysis would give zero pitch frames.");
-		}
+/*
+ * Multirate analysis: the candidates are found on a decimated copy of the sound,
+ * and each candidate is then refined with the correlation at the original sampling frequency,
+ * computed only at the few lags around it.
+ * At the original sampling frequency the correlation is so smooth that a parabola through the three lags
+ * around the maximum is more accurate than sinc interpolation, which would need some 70 lags to either side.
+ */
+#define MULTIRATE_REFINEMENT_HALF_RANGE  3   /* lags to either side of a decimated candidate */
 
-		/*
-		 * Create the resulting pitch contour.
-		 */
-		autoPitch thee = Pitch_create (my xmin, my xmax, nFrames, dt, t1, ceiling, maxnCandidates);
+static void Sound_into_PitchFrame_refine (Sound me, Pitch_Frame pitchFrame, double t,
+	double minimumPitch, int method, Sound_to_Pitch_Setup setup,
+	double **frame, double *r, double *localMean)
+{
+	long nsamp_window = setup -> nsamp_window, halfnsamp_window = setup -> halfnsamp_window;
+	long nsamp_period = setup -> nsamp_period, halfnsamp_period = setup -> halfnsamp_period;
+	long leftSample = Sampled_xToLowIndex (me, t), rightSample = leftSample + 1;
+	long startSample;
 
-		/*
-		 * Create (too much) space for candidates.
-		 */
-		for (long iframe = 1; iframe <= nFrames; iframe ++) {
-			Pitch_Frame pitchFrame = & thy frame [iframe];
-			Pitch_Frame_init (pitchFrame, maxnCandidates);
-		}
+	/*
+	 * Near the edges, the windows at the original sampling frequency may just not fit;
+	 * such a frame keeps its decimated candidates.
+	 */
+	if (rightSample - nsamp_period < 1 || leftSample + nsamp_period > my nx) return;
+	if (rightSample - halfnsamp_window < 1 || leftSample + halfnsamp_window > my nx) return;
 
-		/*
-		 * Compute the global absolute peak for determination of silence threshold.
-		 */
-		globalPeak = 0.0;
+	/*
+	 * The correlations below are computed lag by lag, so the frame needs no zero padding.
+	 */
+	double localPeak = Sound_into_PitchFrame_window (me, pitchFrame, t, method,
+		nsamp_window, halfnsamp_window, nsamp_window, nsamp_period, halfnsamp_period, setup -> globalPeak,
+		setup -> window.peek(), frame, localMean);
+	if (localPeak == 0.0) {
+		pitchFrame->nCandidates = 1;   // absolute silence is always voiceless
+		return;
+	}
+
+	/*
+	 * The correlation at a single lag, normalized as in Sound_into_PitchFrame.
+	 */
+	long offset = 0, localMaximumLag = setup -> brent_ixmax;
+	double sumx2 = 0.0;
+	if (method >= FCC_NORMAL) {
+		if ((startSample = Sampled_xToLowIndex (me, t - 0.5 * (1.0 / minimumPitch + setup -> dt_window))) < 1) startSample = 1;
+		long localSpan = setup -> maximumLag + nsamp_window;
+		if (localSpan > my nx + 1 - startSample) localSpan = my nx + 1 - startSample;
+		if (localSpan - nsamp_window < localMaximumLag) localMaximumLag = localSpan - nsamp_window;
+		offset = startSample - 1;
 		for (long channel = 1; channel <= my ny; channel ++) {
-			double mean = 0.0;
-			for (long i = 1; i <= my nx; i ++) {
-				mean += my z [channel] [i];
+			double *amp = my z [channel] + offset;
+			for (long j = 1; j <= nsamp_window; j ++) {
+				double x = amp [j] - localMean [channel];
+				sumx2 += x * x;
 			}
-			mean /= my nx;
-			for (long i = 1; i <= my nx; i ++) {
-				double value = fabs (my z [channel] [i] - mean);
-				if (value > globalPeak) globalPeak = value;
+		}
+	} else {
+		for (long channel = 1; channel <= my ny; channel ++)
+			for (long j = 1; j <= nsamp_window; j ++)
+				sumx2 += frame [channel] [j] * frame [channel] [j];
+	}
+	auto correlationAtLag = [&] (long lag) -> double {
+		double product = 0.0;
+		if (method >= FCC_NORMAL) {
+			double sumy2 = 0.0;
+			for (long channel = 1; channel <= my ny; channel ++) {
+				double *amp = my z [channel] + offset;
+				for (long j = 1; j <= nsamp_window; j ++) {
+					double x = amp [j] - localMean [channel];
+					double y = amp [lag + j] - localMean [channel];
+					product += x * y;
+					sumy2 += y * y;
+				}
 			}
+			return product / sqrt (sumx2 * sumy2);
 		}
-		if (globalPeak == 0.0) {
-			return thee;
+		for (long channel = 1; channel <= my ny; channel ++) {
+			double *f = frame [channel];
+			for (long j = 1; j <= nsamp_window - lag; j ++)
+				product += f [j] * f [j + lag];
 		}
+		return product / (sumx2 * setup -> windowR [lag + 1]);
+	};
 
-		autoNUMvector <double> window;
-		autoNUMvector <double> windowR;
-		if (method >= FCC_NORMAL) {   /* For cross-correlation analysis. */
+	for (long icand = 2; icand <= pitchFrame->nCandidates; icand ++) {
+		double lag = 1.0 / my dx / pitchFrame->candidate[icand].frequency;
+		long lagmin = lround (lag) - MULTIRATE_REFINEMENT_HALF_RANGE, lagmax = lround (lag) + MULTIRATE_REFINEMENT_HALF_RANGE;
+		if (lagmin < 1) lagmin = 1;
+		if (lagmax > localMaximumLag) lagmax = localMaximumLag;
+		if (lagmax - lagmin < 2) continue;
+		long imax = lagmin;
+		for (long i = lagmin; i <= lagmax; i ++) {
+			r [i] = correlationAtLag (i);
+			if (r [i] > r [imax]) imax = i;
+		}
+		double xmid, ymid;
+		long rOffset = lagmin - 1;
+		ymid = NUMimproveMaximum (& r [rOffset], lagmax - rOffset, imax - rOffset, NUM_PEAK_INTERPOLATE_PARABOLIC, & xmid);
+		xmid += rOffset;
+		pitchFrame->candidate[icand].frequency = 1.0 / my dx / xmid;
+		if (ymid > 1.0) ymid = 1.0 / ymid;
+		pitchFrame->candidate[icand].strength = ymid;
+	}
+}
 
-			nsampFFT = 0;
-			brent_ixmax = (long) floor (nsamp_window * interpolation_depth);
+static void Sound_into_Pitch_refine (Sound_into_Pitch_Args me, long firstFrame, long lastFrame) {
+	for (long iframe = firstFrame; iframe <= lastFrame; iframe ++) {
+		Pitch_Frame pitchFrame = & my pitch -> frame [iframe];
+		double t = Sampled_indexToX (my pitch, iframe);
+		Sound_into_PitchFrame_refine (my sound, pitchFrame, t, my minimumPitch, my method, my setup,
+			my frame.peek(), my r.peek(), my localMean.peek());
+	}
+}
 
-		} else {   /* For autocorrelation analysis. */
+long Sound_to_Pitch_getDecimationFactor (Sound me, double maximumPitch) {
+	double samplingFrequency = 1.0 / my dx;
+	if (maximumPitch > 0.5 * samplingFrequency) maximumPitch = 0.5 * samplingFrequency;
+	long factor = (long) floor (samplingFrequency / (8.0 * maximumPitch));
+	return factor < 2 ? 1 : factor;
+}
 
-			/*
-			* Compute the number of samples needed for doing FFT.
-			* To avoid edge effects, we have to append zeroes to the window.
-			* The maximum lag considered for maxima is maximumLag.
-			* The maximum lag used in interpolation is nsamp_window * interpolation_depth.
-			*/
-			nsampFFT = 1; while (nsampFFT < nsamp_window * (1 + interpolation_depth)) nsampFFT *= 2;
+autoPitch Sound_to_Pitch_any_multirate (Sound me,
+	double dt, double minimumPitch, double periodsPerWindow, int maxnCandidates,
+	int method,
+	double silenceThreshold, double voicingThreshold,
+	double octaveCost, double octaveJumpCost, double voicedUnvoicedCost, double ceiling)
+{
+	try {
+		Melder_assert (maxnCandidates >= 2);
+		Melder_assert (method >= AC_HANNING && method <= FCC_ACCURATE);
 
-			/*
-			* Create buffers for autocorrelation analysis.
-			*/
-			windowR.reset (1, nsampFFT);
-			window.reset (1, nsamp_window);
-			NUMfft_Table_init (& fftTable, nsampFFT);
+		long decimationFactor = Sound_to_Pitch_getDecimationFactor (me, ceiling);
+		if (decimationFactor == 1)
+			return Sound_to_Pitch_any (me, dt, minimumPitch, periodsPerWindow, maxnCandidates, method,
+				silenceThreshold, voicingThreshold, octaveCost, octaveJumpCost, voicedUnvoicedCost, ceiling);
 
-			/*
-			* A Gaussian or Hanning window is applied against phase effects.
-			* The Hanning window is 2 to 5 dB better for 3 periods/window.
-			* The Gaussian window is 25 to 29 dB better for 6 periods/window.
-			*/
-			if (method == AC_GAUSS) {   /* Gaussian window. */
-				double imid = 0.5 * (nsamp_window + 1), edge = exp (-12.0);
-				for (long i = 1; i <= nsamp_window; i ++)
-					window [i] = (exp (-48.0 * (i - imid) * (i - imid) /
-						(nsamp_window + 1) / (nsamp_window + 1)) - edge) / (1 - edge);
-			} else {   // Hanning window
-				for (long i = 1; i <= nsamp_window; i ++)
-					window [i] = 0.5 - 0.5 * cos (i * 2 * NUMpi / (nsamp_window + 1));
+		autoMelderProgress progress (U"Sound to Pitch...");
+		Melder_progress (0.0, U"Sound to Pitch: decimating");
+		autoSound decimated = Sound_resample (me, 1.0 / (my dx * decimationFactor), 20);
+		autoSound_to_Pitch_Setup coarseSetup = Sound_to_Pitch_Setup_createForSound (decimated.get(), dt, minimumPitch, periodsPerWindow, maxnCandidates, method, ceiling);
+		autoSound_to_Pitch_Setup setup = Sound_to_Pitch_Setup_createForSound (me, dt, minimumPitch, periodsPerWindow, maxnCandidates, method, ceiling);
+
+		autoPitch thee = Sound_to_Pitch_findCandidates (decimated.get(), coarseSetup.get(), minimumPitch, method, voicingThreshold, octaveCost, 0.1, 0.4);
+		if (coarseSetup -> globalPeak == 0.0) {
+			return thee;
+		}
+
+		long nFrames = thy nx;
+		const int numberOfThreads = MelderThread_getNumberOfThreadsToUse (nFrames, 20);
+		std::vector <autoSound_into_Pitch_Args> args (numberOfThreads);
+		for (int ithread = 0; ithread < numberOfThreads; ithread ++) {
+			args [ithread] = Sound_into_Pitch_Args_create (me, thee.get(), setup.get(),
+				minimumPitch, method, voicingThreshold, octaveCost);
+		}
+		MelderThread_forRange (nFrames, numberOfThreads, 5,
+			[&] (long firstFrame, long lastFrame, int ithread) {
+				Sound_into_Pitch_refine (args [ithread].get(), firstFrame, lastFrame);
+			},
+			[&] (double fractionDone) {
+				Melder_progress (0.4 + 0.5 * fractionDone, U"Sound to Pitch: refining ", nFrames, U" frames");
 			}
+		);
 
-			/*
-			* Compute the normalized autocorrelation of the window.
-			*/
-			for (long i = 1; i <= nsamp_window; i ++) windowR [i] = window [i];
-			NUMfft_forward (& fftTable, windowR.peek());
-			windowR [1] *= windowR [1];   // DC component
-			for (long i = 2; i < nsampFFT; i += 2) {
-				windowR [i] = windowR [i] * windowR [i] + windowR [i+1] * windowR [i+1];
-				windowR [i + 1] = 0.0;   // power spectrum: square and zero
+		Melder_progress (0.95, U"Sound to Pitch: path finder");
+		Pitch_pathFinder (thee.get(), silenceThreshold, voicingThreshold,
+			octaveCost, octaveJumpCost, voicedUnvoicedCost, setup -> ceiling, Melder_debug == 31 ? true : false);
+
+		return thee;
+	} catch (MelderError) {
+		Melder_throw (me, U": multirate pitch analysis not performed.");
+	}
+}
+
+void Sound_to_Pitch_any_validateMultirate (Sound me,
+	double dt, double minimumPitch, double periodsPerWindow, int maxnCandidates,
+	int method,
+	double silenceThreshold, double voicingThreshold,
+	double octaveCost, double octaveJumpCost, double voicedUnvoicedCost, double ceiling)
+{
+	double startTime = Melder_clock ();
+	autoPitch reference = Sound_to_Pitch_any (me, dt, minimumPitch, periodsPerWindow, maxnCandidates, method,
+		silenceThreshold, voicingThreshold, octaveCost, octaveJumpCost, voicedUnvoicedCost, ceiling);
+	double referenceTime = Melder_clock () - startTime;
+	startTime = Melder_clock ();
+	autoPitch multirate = Sound_to_Pitch_any_multirate (me, dt, minimumPitch, periodsPerWindow, maxnCandidates, method,
+		silenceThreshold, voicingThreshold, octaveCost, octaveJumpCost, voicedUnvoicedCost, ceiling);
+	double multirateTime = Melder_clock () - startTime;
+
+	long numberOfFrames = 0, numberOfVoicingDifferences = 0, numberOfVoicedFrames = 0, numberOfSemitoneDifferences = 0;
+	double sumOfDeviations = 0.0, maximumDeviation = 0.0, timeOfMaximumDeviation = 0.0, maximumStrengthDeviation = 0.0;
+	for (long iframe = 1; iframe <= reference -> nx; iframe ++) {
+		double t = Sampled_indexToX (reference.get(), iframe);
+		long jframe = Sampled_xToNearestIndex (multirate.get(), t);
+		if (jframe < 1 || jframe > multirate -> nx) continue;
+		numberOfFrames ++;
+		bool referenceIsVoiced = Pitch_isVoiced_i (reference.get(), iframe), multirateIsVoiced = Pitch_isVoiced_i (multirate.get(), jframe);
+		if (referenceIsVoiced != multirateIsVoiced) {
+			numberOfVoicingDifferences ++;
+		} else if (referenceIsVoiced) {
+			numberOfVoicedFrames ++;
+			double deviation = fabs (1200.0 * NUMlog2 (multirate -> frame [jframe]. candidate [1]. frequency /
+				reference -> frame [iframe]. candidate [1]. frequency));   // in cents
+			sumOfDeviations += deviation;
+			if (deviation > maximumDeviation) { maximumDeviation = deviation; timeOfMaximumDeviation = t; }
+			if (deviation > 100.0) numberOfSemitoneDifferences ++;
+			double strengthDeviation = fabs (multirate -> frame [jframe]. candidate [1]. strength - reference -> frame [iframe]. candidate [1]. strength);
+			if (strengthDeviation > maximumStrengthDeviation) maximumStrengthDeviation = strengthDeviation;
+		}
+	}
+	long decimationFactor = Sound_to_Pitch_getDecimationFactor (me, ceiling);
+	MelderInfo_open ();
+	MelderInfo_writeLine (U"Multirate pitch analysis of ", me);
+	MelderInfo_writeLine (U"Decimation factor: ", decimationFactor, U" (candidates at ", 1.0 / my dx / decimationFactor, U" Hz)");
+	MelderInfo_writeLine (U"Analysis time: ", Melder_fixed (referenceTime, 3), U" seconds (reference), ",
+		Melder_fixed (multirateTime, 3), U" seconds (multirate)");
+	MelderInfo_writeLine (U"Frames compared: ", numberOfFrames);
+	MelderInfo_writeLine (U"Frames with different voicing decisions: ", numberOfVoicingDifferences);
+	MelderInfo_writeLine (U"Frames voiced in both: ", numberOfVoicedFrames);
+	MelderInfo_writeLine (U"   mean pitch deviation: ", Melder_fixed (numberOfVoicedFrames > 0 ? sumOfDeviations / numberOfVoicedFrames : 0.0, 3), U" cents");
+	MelderInfo_writeLine (U"   maximum pitch deviation: ", Melder_fixed (maximumDeviation, 3), U" cents (at ", Melder_fixed (timeOfMaximumDeviation, 6), U" seconds)");
+	MelderInfo_writeLine (U"   deviations greater than a semitone: ", numberOfSemitoneDifferences);
+	MelderInfo_writeLine (U"   maximum strength deviation: ", maximumStrengthDeviation);
+	MelderInfo_close ();
+}
+
+/*
+ * Streaming analysis.
+ */
+Thing_implement (PitchTracker, Thing, 0);
+
+void structPitchTracker :: v_destroy () noexcept {
+	if (our view) our view -> z = nullptr;   // the rows belong to the buffer, not to the view
+	PitchTracker_Parent :: v_destroy ();
+}
+
+#define PitchTracker_BATCH_SIZE  100   /* frames analysed in parallel */
+
+/*
+	The range of input samples that Sound_into_PitchFrame reads for the frame at time t.
+*/
+static void PitchTracker_getSampleRange (PitchTracker me, double t, long *firstSample, long *lastSample) {
+	Sound_to_Pitch_Setup setup = my setup.get();
+	long leftSample = Sampled_xToLowIndex (my view.get(), t), rightSample = leftSample + 1;
+	long halfSpan = setup -> nsamp_period > setup -> halfnsamp_window ? setup -> nsamp_period : setup -> halfnsamp_window;
+	*firstSample = rightSample - halfSpan;
+	*lastSample = leftSample + halfSpan;
+	if (my method >= FCC_NORMAL) {
+		long startSample = Sampled_xToLowIndex (my view.get(), t - 0.5 * (1.0 / my minimumPitch + setup -> dt_window));
+		if (startSample < 1) startSample = 1;
+		if (startSample < *firstSample) *firstSample = startSample;
+		long endSample = startSample + setup -> maximumLag + setup -> nsamp_window - 1;
+		if (endSample > *lastSample) *lastSample = endSample;
+	}
+}
+
+static double PitchTracker_getFrameTime (PitchTracker me, long iframe) {
+	return my setup -> t1 + (iframe - 1) * my setup -> dt;   // as Sampled_indexToX on the Pitch of Sound_to_Pitch_any
+}
+
+static bool PitchTracker_canAnalyseFrame (PitchTracker me, long iframe) {
+	if (iframe > my numberOfFrames) return false;
+	long firstSample, lastSample;
+	PitchTracker_getSampleRange (me, PitchTracker_getFrameTime (me, iframe), & firstSample, & lastSample);
+	if (lastSample > my totalNumberOfSamples)
+		lastSample = my totalNumberOfSamples;   // the cross-correlation is cut off at the end of the signal, as in Sound_to_Pitch_any
+	return lastSample <= my numberOfSamples;
+}
+
+autoPitchTracker PitchTracker_create (double x1, double dx, int numberOfChannels,
+	long totalNumberOfSamples, double globalPeak,
+	double dt, double minimumPitch, double periodsPerWindow, int maxnCandidates, int method,
+	double silenceThreshold, double voicingThreshold, double octaveCost,
+	double octaveJumpCost, double voicedUnvoicedCost, double ceiling, double lookahead)
+{
+	try {
+		Melder_assert (maxnCandidates >= 2);
+		Melder_assert (method >= AC_HANNING && method <= FCC_ACCURATE);
+		Melder_assert (totalNumberOfSamples >= 1);
+		autoPitchTracker me = Thing_new (PitchTracker);
+		my setup = Sound_to_Pitch_Setup_create (dx, totalNumberOfSamples * dx,
+			dt, minimumPitch, periodsPerWindow, maxnCandidates, method, ceiling);
+		Sound_to_Pitch_Setup setup = my setup.get();
+		my minimumPitch = minimumPitch;
+		my method = method;
+		my silenceThreshold = silenceThreshold;
+		my voicingThreshold = voicingThreshold;
+		my octaveCost = octaveCost;
+		my octaveJumpCost = octaveJumpCost * 0.01 / setup -> dt;   // the time step correction of Pitch_pathFinder
+		my voicedUnvoicedCost = voicedUnvoicedCost * 0.01 / setup -> dt;
+		my ceiling2 = Melder_debug == 31 ? 2.0 * setup -> ceiling : setup -> ceiling;
+		setup -> globalPeak = globalPeak;
+		my lookahead = (long) ceil (lookahead / setup -> dt);
+		if (my lookahead < 1) my lookahead = 1;
+
+		my view = Thing_new (Sound);
+		my view -> ny = numberOfChannels;
+		my view -> x1 = x1;
+		my view -> dx = dx;
+		my view -> xmin = x1 - 0.5 * dx;
+		my view -> xmax = my view -> xmin + totalNumberOfSamples * dx;
+		my view -> nx = totalNumberOfSamples;
+		my totalNumberOfSamples = totalNumberOfSamples;
+		/*
+			The frames of Sound_to_Pitch_any.
+		*/
+		try {
+			Sampled_shortTermAnalysis (my view.get(), method >= FCC_NORMAL ? 1.0 / minimumPitch + setup -> dt_window : setup -> dt_window,
+				setup -> dt, & setup -> nFrames, & setup -> t1);
+		} catch (MelderError) {
+			Melder_throw (U"The pitch analysis would give zero pitch frames.");
+		}
+		my numberOfFrames = setup -> nFrames;
+
+		long firstSample, lastSample;
+		PitchTracker_getSampleRange (me.get(), setup -> t1, & firstSample, & lastSample);
+		my bufferSize = 2 * (lastSample - firstSample + 1) + (long) ceil (PitchTracker_BATCH_SIZE * setup -> dt / dx);
+		my buffer.reset (1, numberOfChannels, 1, my bufferSize);
+		my firstBufferedSample = 1;
+		my rows.reset (1, numberOfChannels);
+		my view -> z = my rows.peek();
+
+		my ringSize = my lookahead + PitchTracker_BATCH_SIZE;
+		my ring = Pitch_create (0.0, 1.0, my ringSize, 1.0, 0.5, setup -> ceiling, setup -> maxnCandidates);
+		for (long islot = 1; islot <= my ringSize; islot ++)
+			Pitch_Frame_init (& my ring -> frame [islot], setup -> maxnCandidates);
+		my delta.reset (1, my ringSize, 1, setup -> maxnCandidates);
+		my psi.reset (1, my ringSize, 1, setup -> maxnCandidates);
+
+		int numberOfThreads = MelderThread_getNumberOfThreadsToUse (PitchTracker_BATCH_SIZE, 20);
+		my args.resize (numberOfThreads);
+		for (int ithread = 0; ithread < numberOfThreads; ithread ++)
+			my args [ithread] = Sound_into_Pitch_Args_create (my view.get(), my ring.get(), setup,
+				minimumPitch, method, voicingThreshold, octaveCost);
+		return me;
+	} catch (MelderError) {
+		Melder_throw (U"PitchTracker not created.");
+	}
+}
+
+static inline long PitchTracker_getSlot (PitchTracker me, long iframe) {
+	return (iframe - 1) % my ringSize + 1;
+}
+
+static void PitchTracker_updateView (PitchTracker me) {
+	for (long channel = 1; channel <= my view -> ny; channel ++)
+		my rows [channel] = my buffer [channel] + 1 - my firstBufferedSample;
+}
+
+/*
+	One step of the Viterbi algorithm of Pitch_pathFinder.
+*/
+static void PitchTracker_addFrameToPaths (PitchTracker me, long iframe) {
+	long slot = PitchTracker_getSlot (me, iframe);
+	Pitch_Frame curFrame = & my ring -> frame [slot];
+	double *curDelta = my delta [slot];
+	Pitch_Frame_getLocalStrengths (curFrame, my silenceThreshold, my voicingThreshold,
+		my octaveCost, my setup -> ceiling, my ceiling2, curDelta);
+	if (iframe == 1) return;
+	long previousSlot = PitchTracker_getSlot (me, iframe - 1);
+	Pitch_Frame prevFrame = & my ring -> frame [previousSlot];
+	double *prevDelta = my delta [previousSlot];
+	long *curPsi = my psi [slot];
+	for (long icand2 = 1; icand2 <= curFrame -> nCandidates; icand2 ++) {
+		double f2 = curFrame -> candidate [icand2]. frequency;
+		volatile double maximum = -1e30;
+		long place = 0;
+		for (long icand1 = 1; icand1 <= prevFrame -> nCandidates; icand1 ++) {
+			double f1 = prevFrame -> candidate [icand1]. frequency;
+			double transitionCost = Pitch_getTransitionCost (f1, f2, my octaveJumpCost, my voicedUnvoicedCost, my ceiling2);
+			volatile double value = prevDelta [icand1] - transitionCost + curDelta [icand2];
+			if (value > maximum) {
+				maximum = value;
+				place = icand1;
 			}
-			windowR [nsampFFT] *= windowR [nsampFFT];   // Nyquist frequency
-			NUMfft_backward (& fftTable, windowR.peek());   // autocorrelation
-			for (long i = 2; i <= nsamp_window; i ++) windowR [i] /= windowR [1];   // normalize
-			windowR [1] = 1.0;   // normalize
+		}
+		curDelta [icand2] = maximum;
+		curPsi [icand2] = place;
+	}
+}
 
-			brent_ixmax = (long) floor (nsamp_window * interpolation_depth);
+static long PitchTracker_getBestEnd (PitchTracker me, long iframe) {
+	long slot = PitchTracker_getSlot (me, iframe);
+	double *delta = my delta [slot];
+	long place = 1;
+	double maximum = delta [1];
+	for (long icand = 2; icand <= my ring -> frame [slot]. nCandidates; icand ++) {
+		if (delta [icand] > maximum) {
+			place = icand;
+			maximum = delta [place];
 		}
+	}
+	return place;
+}
 
-		autoMelderProgress progress (U"Sound to Pitch...");
+static void PitchTracker_decideFrame (PitchTracker me, long iframe, long place) {
+	Pitch_Frame frame = & my ring -> frame [PitchTracker_getSlot (me, iframe)];
+	structPitch_Candidate help = frame -> candidate [1];
+	frame -> candidate [1] = frame -> candidate [place];
+	frame -> candidate [place] = help;
+	if (my ceiling2 > my setup -> ceiling)
+		Pitch_Frame_pullFormants (frame, my setup -> ceiling, my ceiling2);
+	structPitchTracker_Decision decision;
+	decision. frameNumber = iframe;
+	decision. time = PitchTracker_getFrameTime (me, iframe);
+	decision. intensity = frame -> intensity;
+	decision. winner = frame -> candidate [1];
+	my decisions.push_back (decision);
+	my numberOfDecidedFrames = iframe;
+}
 
-		long numberOfFramesPerThread = 20;
-		int numberOfThreads = (nFrames - 1) / numberOfFramesPerThread + 1;
-		const int numberOfProcessors = MelderThread_getNumberOfProcessors ();
-		trace (numberOfProcessors, U" processors");
-		if (numberOfThreads > numberOfProcessors) numberOfThreads = numberOfProcessors;
-		if (numberOfThreads > 16) numberOfThreads = 16;
-		if (numberOfThreads < 1) numberOfThreads = 1;
-		numberOfFramesPerThread = (nFrames - 1) / numberOfThreads + 1;
-
-		if (! mutex_inited) { MelderThread_MUTEX_INIT (mutex); mutex_inited = true; }
-		autoSound_into_Pitch_Args args [16];
-		long firstFrame = 1, lastFrame = numberOfFramesPerThread;
-		volatile int cancelled = 0;
-		for (int ithread = 1; ithread <= numberOfThreads; ithread ++) {
-			if (ithread == numberOfThreads) lastFrame = nFrames;
-			args [ithread - 1] = Sound_into_Pitch_Args_create (me, thee.get(),
-				firstFrame, lastFrame, minimumPitch, maxnCandidates, method,
-				voicingThreshold, octaveCost,
-				dt_window, nsamp_window, halfnsamp_window, maximumLag,
-				nsampFFT, nsamp_period, halfnsamp_period, brent_ixmax, brent_depth,
-				globalPeak, window.peek(), windowR.peek(),
-				ithread == numberOfThreads, & cancelled);
-			firstFrame = lastFrame + 1;
-			lastFrame += numberOfFramesPerThread;
+static void PitchTracker_analyseFrames (PitchTracker me) {
+	Sound_to_Pitch_Setup setup = my setup.get();
+	for (;;) {
+		long firstFrame = my numberOfAnalysedFrames + 1, lastFrame = firstFrame - 1;
+		while (lastFrame < my numberOfDecidedFrames + my ringSize && PitchTracker_canAnalyseFrame (me, lastFrame + 1))
+			lastFrame ++;
+		long numberOfFramesToAnalyse = lastFrame - firstFrame + 1;
+		if (numberOfFramesToAnalyse < 1) return;
+		int numberOfThreads = MelderThread_getNumberOfThreadsToUse (numberOfFramesToAnalyse, 20);
+		if (numberOfThreads > (int) my args.size()) numberOfThreads = (int) my args.size();
+		MelderThread_forRange (numberOfFramesToAnalyse, numberOfThreads, 5,
+			[&] (long first, long last, int ithread) {
+				Sound_into_Pitch_Args args = my args [ithread].get();
+				for (long iframe = firstFrame - 1 + first; iframe <= firstFrame - 1 + last; iframe ++) {
+					Pitch_Frame pitchFrame = & my ring -> frame [PitchTracker_getSlot (me, iframe)];
+					if (setup -> globalPeak == 0.0) {   // a silent signal: only the voiceless candidate, as in Sound_to_Pitch_any
+						pitchFrame -> intensity = 0.0;
+						pitchFrame -> nCandidates = 1;
+						pitchFrame -> candidate [1]. frequency = 0.0;
+						pitchFrame -> candidate [1]. strength = 0.0;
+						continue;
+					}
+					Sound_into_PitchFrame (my view.get(), pitchFrame, PitchTracker_getFrameTime (me, iframe),
+						my minimumPitch, setup -> maxnCandidates, my method, my voicingThreshold, my octaveCost,
+						& args -> fftTable, setup -> dt_window, setup -> nsamp_window, setup -> halfnsamp_window,
+						setup -> maximumLag, setup -> nsampFFT, setup -> nsamp_period, setup -> halfnsamp_period,
+						setup -> brent_ixmax, setup -> brent_depth, setup -> globalPeak,
+						args -> frame.peek(), args -> ac.peek(), setup -> window.peek(), setup -> windowR.peek(),
+						args -> xSpectrum.peek(), args -> ySpectrum.peek(),
+						args -> r.peek(), args -> imax.peek(), args -> localMean.peek());
+				}
+			}
+		);
+		/*
+			Fixed-lag decoding: once a frame is in, the frame 'lookahead' frames earlier is decided
+			by tracing back from the best path so far.
+		*/
+		for (long iframe = firstFrame; iframe <= lastFrame; iframe ++) {
+			PitchTracker_addFrameToPaths (me, iframe);
+			my numberOfAnalysedFrames = iframe;
+			long frameToDecide = iframe - my lookahead;
+			if (frameToDecide >= 1) {
+				long place = PitchTracker_getBestEnd (me, iframe);
+				for (long jframe = iframe; jframe > frameToDecide; jframe --)
+					place = my psi [PitchTracker_getSlot (me, jframe)] [place];
+				PitchTracker_decideFrame (me, frameToDecide, place);
+			}
 		}
-		MelderThread_run (Sound_into_Pitch, args, numberOfThreads);
+	}
+}
 
-		Melder_progress (0.95, U"Sound to Pitch: path finder");
-		Pitch_pathFinder (thee.get(), silenceThreshold, voicingThreshold,
-			octaveCost, octaveJumpCost, voicedUnvoicedCost, ceiling, Melder_debug == 31 ? true : false);
+void PitchTracker_push (PitchTracker me, double **samples, long numberOfSamples) {
+	if (my numberOfSamples + numberOfSamples > my totalNumberOfSamples)
+		numberOfSamples = my totalNumberOfSamples - my numberOfSamples;
+	if (numberOfSamples < 1) return;
+	if (my numberOfPoppedDecisions > 0) {
+		my decisions.erase (my decisions.begin(), my decisions.begin() + my numberOfPoppedDecisions);
+		my numberOfPoppedDecisions = 0;
+	}
+	int numberOfChannels = my view -> ny;
+	/*
+		Forget the samples that no frame needs any longer.
+	*/
+	long firstNeededSample = my numberOfSamples + 1;
+	if (my numberOfAnalysedFrames < my numberOfFrames) {
+		long lastSample;
+		PitchTracker_getSampleRange (me, PitchTracker_getFrameTime (me, my numberOfAnalysedFrames + 1), & firstNeededSample, & lastSample);
+		if (firstNeededSample < 1) firstNeededSample = 1;
+		if (firstNeededSample > my numberOfSamples + 1) firstNeededSample = my numberOfSamples + 1;
+	}
+	if (firstNeededSample > my firstBufferedSample) {
+		long numberOfKeptSamples = my numberOfSamples - firstNeededSample + 1;
+		if (numberOfKeptSamples > 0)
+			for (long channel = 1; channel <= numberOfChannels; channel ++)
+				memmove (& my buffer [channel] [1], & my buffer [channel] [firstNeededSample - my firstBufferedSample + 1],
+					numberOfKeptSamples * sizeof (double));
+		my firstBufferedSample = firstNeededSample;
+	}
+	/*
+		Append the new samples.
+	*/
+	long numberOfBufferedSamples = my numberOfSamples - my firstBufferedSample + 1;
+	if (numberOfBufferedSamples + numberOfSamples > my bufferSize) {
+		long newBufferSize = 2 * (numberOfBufferedSamples + numberOfSamples);
+		autoNUMmatrix <double> keep (1, numberOfChannels, 1, numberOfBufferedSamples > 0 ? numberOfBufferedSamples : 1);
+		for (long channel = 1; channel <= numberOfChannels; channel ++)
+			for (long i = 1; i <= numberOfBufferedSamples; i ++)
+				keep [channel] [i] = my buffer [channel] [i];
+		my buffer.reset (1, numberOfChannels, 1, newBufferSize);
+		my bufferSize = newBufferSize;
+		for (long channel = 1; channel <= numberOfChannels; channel ++)
+			for (long i = 1; i <= numberOfBufferedSamples; i ++)
+				my buffer [channel] [i] = keep [channel] [i];
+	}
+	for (long channel = 1; channel <= numberOfChannels; channel ++) {
+		double *to = my buffer [channel] + numberOfBufferedSamples;
+		for (long i = 1; i <= numberOfSamples; i ++)
+			to [i] = samples [channel] [i];
+	}
+	my numberOfSamples += numberOfSamples;
+	PitchTracker_updateView (me);
+	PitchTracker_analyseFrames (me);
+}
+
+void PitchTracker_finish (PitchTracker me) {
+	PitchTracker_analyseFrames (me);
+	long lastFrame = my numberOfAnalysedFrames, firstFrame = my numberOfDecidedFrames + 1;
+	if (lastFrame < firstFrame) return;
+	/*
+		Trace the best path back from the last frame, as Pitch_pathFinder does.
+	*/
+	autoNUMvector <long> places (firstFrame, lastFrame);
+	long place = PitchTracker_getBestEnd (me, lastFrame);
+	for (long iframe = lastFrame; iframe >= firstFrame; iframe --) {
+		places [iframe] = place;
+		place = my psi [PitchTracker_getSlot (me, iframe)] [place];
+	}
+	for (long iframe = firstFrame; iframe <= lastFrame; iframe ++)
+		PitchTracker_decideFrame (me, iframe, places [iframe]);
+}
+
+bool PitchTracker_popDecision (PitchTracker me, PitchTracker_Decision decision) {
+	if (my numberOfPoppedDecisions >= (long) my decisions.size()) return false;
+	*decision = my decisions [my numberOfPoppedDecisions ++];
+	return true;
+}
+
+autoPitch LongSound_to_Pitch_any (LongSound me,
+	double dt, double minimumPitch, double periodsPerWindow, int maxnCandidates, int method,
+	double silenceThreshold, double voicingThreshold, double octaveCost,
+	double octaveJumpCost, double voicedUnvoicedCost, double ceiling, double lookahead)
+{
+	try {
+		const long partLength = 1 << 18;
+		autoNUMmatrix <double> part (1, my numberOfChannels, 1, partLength);
+		long numberOfParts = (my nx - 1) / partLength + 1;
+		autoMelderProgress progress (U"LongSound to Pitch...");
 
+		/*
+			The global peak, as in Sound_to_Pitch_Setup_createForSound: the largest distance between a sample and the mean of its channel.
+		*/
+		autoNUMvector <double> sum (1, my numberOfChannels), minimum (1, my numberOfChannels), maximum (1, my numberOfChannels);
+		for (long ipart = 1; ipart <= numberOfParts; ipart ++) {
+			Melder_progress (0.1 * (ipart - 1) / numberOfParts, U"LongSound to Pitch: finding the peak");
+			long first = 1 + (ipart - 1) * partLength, n = first + partLength - 1 > my nx ? my nx - first + 1 : partLength;
+			LongSound_readAudioToFloat (me, part.peek(), first, n);
+			for (long channel = 1; channel <= my numberOfChannels; channel ++) {
+				if (ipart == 1) minimum [channel] = maximum [channel] = part [channel] [1];
+				for (long i = 1; i <= n; i ++) {
+					double value = part [channel] [i];
+					sum [channel] += value;
+					if (value < minimum [channel]) minimum [channel] = value;
+					if (value > maximum [channel]) maximum [channel] = value;
+				}
+			}
+		}
+		double globalPeak = 0.0;
+		for (long channel = 1; channel <= my numberOfChannels; channel ++) {
+			double mean = sum [channel] / my nx;
+			if (maximum [channel] - mean > globalPeak) globalPeak = maximum [channel] - mean;
+			if (mean - minimum [channel] > globalPeak) globalPeak = mean - minimum [channel];
+		}
+
+		autoPitchTracker tracker = PitchTracker_create (my x1, my dx, my numberOfChannels, my nx, globalPeak,
+			dt, minimumPitch, periodsPerWindow, maxnCandidates, method,
+			silenceThreshold, voicingThreshold, octaveCost, octaveJumpCost, voicedUnvoicedCost, ceiling, lookahead);
+		Sound_to_Pitch_Setup setup = tracker -> setup.get();
+		autoPitch thee = Pitch_create (my xmin, my xmax, setup -> nFrames, setup -> dt, setup -> t1, setup -> ceiling, setup -> maxnCandidates);
+		auto collectDecisions = [&] () {
+			structPitchTracker_Decision decision;
+			while (PitchTracker_popDecision (tracker.get(), & decision)) {
+				Pitch_Frame frame = & thy frame [decision. frameNumber];
+				frame -> intensity = decision. intensity;
+				frame -> candidate [1] = decision. winner;
+			}
+		};
+		for (long ipart = 1; ipart <= numberOfParts; ipart ++) {
+			Melder_progress (0.1 + 0.9 * (ipart - 1) / numberOfParts, U"LongSound to Pitch: part ", ipart, U" out of ", numberOfParts);
+			long first = 1 + (ipart - 1) * partLength, n = first + partLength - 1 > my nx ? my nx - first + 1 : partLength;
+			LongSound_readAudioToFloat (me, part.peek(), first, n);
+			PitchTracker_push (tracker.get(), part.peek(), n);
+			collectDecisions ();
+		}
+		PitchTracker_finish (tracker.get());
+		collectDecisions ();
 		return thee;
 	} catch (MelderError) {
 		Melder_throw (me, U": pitch analysis not performed.");
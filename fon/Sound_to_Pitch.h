@@ -16,8 +16,10 @@
  * along with this work. If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include "Sound.h"
+#include "LongSound.h"
 #include "Pitch.h"
+#include "NUM2.h"
+#include <vector>
 
 autoPitch Sound_to_Pitch (Sound me, double timeStep,
 	double minimumPitch, double maximumPitch);
@@ -84,4 +86,162 @@ autoPitch Sound_to_Pitch_any (Sound me,
 		pitches above a certain value "voiceless".
 */
 
+autoPitch Sound_to_Pitch_any_multirate (Sound me,
+	double dt, double minimumPitch, double periodsPerWindow, int maxnCandidates, int method,
+	double silenceThreshold, double voicingThreshold, double octaveCost,
+	double octaveJumpCost, double voicedUnvoicedCost, double maximumPitch);
+/*
+	Like Sound_to_Pitch_any, but faster for sounds whose sampling frequency is much higher than needed for 'maximumPitch':
+	the candidates are found on a copy of the sound that is decimated by Sound_to_Pitch_getDecimationFactor,
+	and each candidate is then refined with the correlation at the original sampling frequency,
+	computed at a few lags around the candidate only.
+	Candidates above four times 'maximumPitch' are not found (they would be voiceless anyway).
+	Near the edges of the sound, some frames may keep their decimated candidates.
+*/
+
+long Sound_to_Pitch_getDecimationFactor (Sound me, double maximumPitch);
+/*
+	The largest factor that keeps the decimated sampling frequency at least eight times 'maximumPitch';
+	1 if the sound cannot be decimated.
+*/
+
+void Sound_to_Pitch_any_validateMultirate (Sound me,
+	double dt, double minimumPitch, double periodsPerWindow, int maxnCandidates, int method,
+	double silenceThreshold, double voicingThreshold, double octaveCost,
+	double octaveJumpCost, double voicedUnvoicedCost, double maximumPitch);
+/*
+	Performs both Sound_to_Pitch_any and Sound_to_Pitch_any_multirate,
+	and writes to the Info window how far the multirate path deviates from the reference path.
+*/
+
+/*
+	The analysis parameters that follow from the sampling frequency and the settings.
+*/
+Thing_define (Sound_to_Pitch_Setup, Thing) { public:
+	double dt, t1, ceiling;
+	int maxnCandidates;
+	double dt_window;   // window length in seconds
+	long nsamp_window, halfnsamp_window;   // number of samples per window
+	long nFrames, minimumLag, maximumLag;
+	long nsampFFT;
+	double interpolation_depth;
+	long nsamp_period, halfnsamp_period;   // number of samples in longest period
+	long brent_ixmax, brent_depth;
+	double globalPeak;
+	autoNUMvector <double> window, windowR;
+};
+
+/*
+	The workspace of one analysis thread.
+*/
+Thing_define (Sound_into_Pitch_Args, Thing) { public:
+	Sound sound;
+	Pitch pitch;
+	Sound_to_Pitch_Setup setup;
+	double minimumPitch;
+	int method;
+	double voicingThreshold, octaveCost;
+	autoNUMfft_Table fftTable;
+	autoNUMmatrix <double> frame;
+	autoNUMvector <double> ac, xSpectrum, ySpectrum, r, localMean;
+	autoNUMvector <long> imax;
+};
+
+/*
+	Streaming analysis.
+
+	A PitchTracker performs the analysis of Sound_to_Pitch_any on a signal that comes in block by block.
+	Each frame is analysed as soon as all the samples in its window have come in,
+	and the path finder decides on the winning candidate of a frame
+	as soon as the frames in the next 'lookahead' seconds have been analysed ("fixed-lag" Viterbi).
+	Only those frames and the samples of the frames that have not been analysed yet are kept,
+	so that the memory use does not grow with the duration of the signal.
+	If the lookahead spans the whole signal, the decisions are those of Sound_to_Pitch_any;
+	with a lookahead of a few tenths of a second, the best paths have almost always merged.
+*/
+typedef struct structPitchTracker_Decision {
+	long frameNumber;
+	double time, intensity;
+	structPitch_Candidate winner;   // frequency 0.0 = voiceless
+} *PitchTracker_Decision;
+
+Thing_define (PitchTracker, Thing) { public:
+	autoSound_to_Pitch_Setup setup;
+	double minimumPitch;
+	int method;
+	double silenceThreshold, voicingThreshold, octaveCost, octaveJumpCost, voicedUnvoicedCost;
+	double ceiling2;   // twice the ceiling if formants are pulled
+	long lookahead;   // in frames
+
+	/*
+		The input: a window onto the samples that are still needed.
+		Input sample i (i >= firstBufferedSample) is buffer [channel] [i - firstBufferedSample + 1];
+		'view' is a Sound whose sample numbers are those of the input.
+	*/
+	long totalNumberOfSamples;
+	long numberOfSamples;   // the number of samples that have come in so far
+	long firstBufferedSample, bufferSize;
+	autoNUMmatrix <double> buffer;
+	autoNUMvector <double *> rows;
+	autoSound view;
+
+	/*
+		The frames that have been analysed but not decided yet,
+		in a circular buffer with the partial path scores ('delta') and the back pointers ('psi').
+	*/
+	long numberOfFrames;
+	long numberOfAnalysedFrames, numberOfDecidedFrames;
+	long ringSize;
+	autoPitch ring;
+	autoNUMmatrix <double> delta;
+	autoNUMmatrix <long> psi;
+	std::vector <autoSound_into_Pitch_Args> args;
+
+	std::vector <structPitchTracker_Decision> decisions;
+	long numberOfPoppedDecisions;
+
+	void v_destroy () noexcept
+		override;
+};
+
+autoPitchTracker PitchTracker_create (double x1, double dx, int numberOfChannels,
+	long totalNumberOfSamples, double globalPeak,
+	double dt, double minimumPitch, double periodsPerWindow, int maxnCandidates, int method,
+	double silenceThreshold, double voicingThreshold, double octaveCost,
+	double octaveJumpCost, double voicedUnvoicedCost, double maximumPitch, double lookahead);
+/*
+	Sample 1 of the input will lie at time x1; the sampling period is dx.
+	The number of samples has to be known in advance (as for a LongSound),
+	so that the frames are those that Sound_to_Pitch_any would give.
+	'globalPeak' is the largest absolute deviation from the mean in the whole signal, as Sound_to_Pitch_any uses it.
+*/
+
+void PitchTracker_push (PitchTracker me, double **samples, long numberOfSamples);
+/*
+	Feeds the next samples (samples [channel] [1..numberOfSamples]) to the tracker.
+	A frame is decided as soon as the 'lookahead' frames after it have been analysed,
+	and then becomes available to PitchTracker_popDecision. The decision is final,
+	even if the frames that come in later would have given the best path a different route through it.
+*/
+
+void PitchTracker_finish (PitchTracker me);
+/*
+	Tells the tracker that the input has stopped, so that the remaining frames can be decided.
+*/
+
+bool PitchTracker_popDecision (PitchTracker me, PitchTracker_Decision decision);
+/*
+	Takes the earliest decided frame that has not been taken before; returns false if there is none.
+*/
+
+autoPitch LongSound_to_Pitch_any (LongSound me,
+	double dt, double minimumPitch, double periodsPerWindow, int maxnCandidates, int method,
+	double silenceThreshold, double voicingThreshold, double octaveCost,
+	double octaveJumpCost, double voicedUnvoicedCost, double maximumPitch, double lookahead);
+/*
+	Does what Sound_to_Pitch_any would do on the whole sound, with a PitchTracker,
+	so that the long sound never has to be in memory as a whole.
+	Every frame of the resulting Pitch contains only the winning candidate.
+*/
+
 /* End of file Sound_to_Pitch.h */
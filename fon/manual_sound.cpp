@@ -956,7 +956,7 @@ NORMAL (U"where \\De%t is the sampling period of the sound. Every sample %x__%i_
 FORMULA (U"%x__%i_ = %x__%i_ - %\\al %x__%i-1_")
 MAN_END
 
-MAN_BEGIN (U"Sound: Resample...", U"ppgb", 20040330)
+MAN_BEGIN (U"Sound: Resample...", U"ppgb", 20161018)
 INTRO (U"A command that creates new @Sound objects from the selected Sounds.")
 ENTRY (U"Purpose")
 NORMAL (U"High-precision resampling from any sampling frequency to any other sampling frequency.")
@@ -974,6 +974,14 @@ NORMAL (U"If #Precision is greater than 1, the method is sin(%x)/%x (\"%sinc\")
 	"For higher #Precision, the algorithm is slower but more accurate.")
 NORMAL (U"If ##Sampling frequency# is less than the sampling frequency of the selected sound, "
 	"an anti-aliasing low-pass filtering is performed prior to resampling.")
+NORMAL (U"If the two sampling frequencies have a simple ratio, such as 44100 and 16000 Hz (441 to 160), "
+	"the interpolation and the anti-aliasing filter are combined into a single Hann-windowed sinc filter "
+	"whose weights are computed in advance for each of the few possible positions of the new samples "
+	"between the old samples. This is much faster. "
+	"The filter then extends over #Precision + 1 periods of the lower of the two sampling frequencies on either side, "
+	"so that a higher #Precision gives a steeper anti-aliasing filter. "
+	"A LongSound can be resampled in this way as well, with ##Resample to WAV file...#; "
+	"the result is the same as when the sound is read into memory and resampled.")
 ENTRY (U"Behaviour")
 NORMAL (U"A new Sound will appear in the list of objects, "
 	"bearing the same name as the original Sound, followed by the sampling frequency. "
@@ -1315,6 +1323,28 @@ NORMAL (U"The computation makes use of the fact that convolution in the time dom
 	"the result will again have a duration of (%t__2_ - %t__1_) + (%t__4_ - %t__3_).")
 MAN_END
 
+MAN_BEGIN (U"LongSound & Sound: Convolve to WAV file...", U"ppgb", 20161018)
+INTRO (U"A command available when you select a @LongSound object and a @Sound object. "
+	"It convolves the two in the same way as @@Sounds: Convolve...@ would do if the LongSound were a Sound, "
+	"and writes the result to a 16-bit WAV file.")
+NORMAL (U"The LongSound is read, and the result is written, part by part, so neither has to fit into memory. "
+	"This makes the command suitable for filtering a long recording with an impulse response, "
+	"for instance to add the reverberation of a room.")
+ENTRY (U"Settings")
+TAG (U"##Audio file")
+DEFINITION (U"the path of the WAV file to create.")
+TAG (U"##Amplitude scaling")
+TAG (U"##Signal outside time domain is...")
+DEFINITION (U"as in @@Sounds: Convolve...@. "
+	"With ##peak 0.99#, the convolution is computed twice: once to find its peak, and once more to write it, "
+	"so this takes twice as long as the other options.")
+NORMAL (U"With #integral, #sum, or #normalize, sample values outside the range from -1 to +1 are clipped in the file, "
+	"because a WAV file cannot contain them; you will get a warning if this happens.")
+ENTRY (U"Requirements")
+NORMAL (U"The two sounds should have the same sampling frequency. "
+	"Their numbers of channels should be equal, or one of them should be mono.")
+MAN_END
+
 MAN_BEGIN (U"Sounds: Cross-correlate...", U"djmw & ppgb", 20100404)
 INTRO (U"A command available in the #Combine menu when you select two @Sound objects. "
 	"This command cross-correlates two selected @Sound objects with each other. "
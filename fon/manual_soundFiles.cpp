@@ -340,7 +340,7 @@ LIST_ITEM (U"• @@Save as NIST file...@ (little-endian)")
 LIST_ITEM (U"• @@Save as FLAC file...@")
 MAN_END
 
-MAN_BEGIN (U"LongSound", U"ppgb", 20110131)
+MAN_BEGIN (U"LongSound", U"ppgb", 20161018)
 INTRO (U"One of the @@types of objects@ in Praat. See the @@Sound files@ tutorial.")
 NORMAL (U"A LongSound object gives you the ability to view and label "
 	"a sound file that resides on disk. You will want to use it for sounds "
@@ -351,7 +351,9 @@ ENTRY (U"What you can do with a LongSound object")
 NORMAL (U"You can save a LongSound object to a new sound file, "
 	"perhaps in a different format (AIFF, AIFC, WAV, NeXT/Sun, NIST, FLAC) "
 	"with the commands in the Save menu. You can also concatenate several "
-	"LongSound objects in this way. See @@How to concatenate sound files@.")
+	"LongSound objects in this way. See @@How to concatenate sound files@. "
+	"You can also filter a LongSound with a Sound, writing the result to a new file, "
+	"with @@LongSound & Sound: Convolve to WAV file...@.")
 ENTRY (U"How to view and edit a LongSound object")
 NORMAL (U"You can view a LongSound object in a @LongSoundEditor by choosing @@LongSound: View@. "
 	"This also allows you to extract parts of the LongSound as @Sound objects, "
@@ -363,11 +365,32 @@ LIST_ITEM (U"1. Select the LongSound object.")
 LIST_ITEM (U"2. Choose @@LongSound: To TextGrid...@ and specify your tiers.")
 LIST_ITEM (U"3. Select the resulting @TextGrid object together with the LongSound object, and click ##View & Edit#.")
 NORMAL (U"A @TextGridEditor will appear on the screen, with a copy of the LongSound object in it.")
+ENTRY (U"How to analyse a LongSound object")
+NORMAL (U"You can compute the pitch contour of a whole LongSound object with @@LongSound: To Pitch...@, "
+	"which reads the file part by part. For other analyses, extract the part you are interested in as a @Sound object.")
 ENTRY (U"Limitations")
 NORMAL (U"The length of the sound file is limited to 2 gigabytes, which is 3 hours of CD-quality stereo, "
 	"or 12 hours 16-bit mono sampled at 22050 Hz.")
 MAN_END
 
+MAN_BEGIN (U"LongSound: To Pitch...", U"ppgb", 20161018)
+INTRO (U"A command that creates a @Pitch object from every selected @LongSound object, "
+	"without reading the whole sound into memory.")
+ENTRY (U"Settings")
+NORMAL (U"The settings are those of @@Sound: To Pitch (ac)...@ or @@Sound: To Pitch (cc)...@, depending on the #Method, "
+	"plus one:")
+TAG (U"##Lookahead (s)")
+DEFINITION (U"how far the path finder looks ahead before it decides on the pitch of a frame. "
+	"The path finder of @@Sound: To Pitch (ac)...@ looks at the whole sound before it decides on any frame; "
+	"this command decides on every frame as soon as the next half second (by default) has been analysed, "
+	"so that it needs to keep only half a second of analysis in memory. "
+	"This almost always gives the same path.")
+ENTRY (U"Algorithm")
+NORMAL (U"The sound is read in parts. Each frame is analysed as soon as the part that contains its window has been read, "
+	"and the best path is traced back from the last analysed frame to the frame that is a lookahead earlier.")
+NORMAL (U"Every frame of the resulting Pitch contains only the winning candidate, so that the Pitch object is small as well.")
+MAN_END
+
 MAN_BEGIN (U"LongSound: To TextGrid...", U"ppgb", 19980730)
 INTRO (U"A command to create a @TextGrid without any labels, copying the time domain from the selected @LongSound.")
 NORMAL (U"See @@Sound: To TextGrid...@ for the settings.")
@@ -390,6 +390,21 @@ CODE (U"Write to console")
 CODE (U"! peak at 999.99921 Hz, 3 dB bw 5.786 Hz, 20 dB bw 12 Hz, zero bw 15 Hz, sidelobe -21 dB")
 MAN_END
 
+MAN_BEGIN (U"Sound: To Spectrogram (single precision)...", U"ppgb", 20161018)
+INTRO (U"A command that creates a @Spectrogram from every selected @Sound object, "
+	"exactly as @@Sound: To Spectrogram...@, except that each analysis frame is windowed, "
+	"Fourier-transformed and squared in 32-bit (single-precision) instead of 64-bit floating point.")
+ENTRY (U"Settings")
+NORMAL (U"The settings are the same as those of @@Sound: To Spectrogram...@.")
+ENTRY (U"Precision")
+NORMAL (U"The power values have a relative precision of about 10^^-6^ of the strongest component in the frame, "
+	"which is far more than you need if you look at the spectrogram in dB: "
+	"the difference with @@Sound: To Spectrogram...@ is then below 0.001 dB wherever the power "
+	"is less than 60 dB below the peak of the frame. "
+	"Use the ordinary command if you need weak parts of the spectrum to be precise, "
+	"or if you want results that are identical on all computers.")
+MAN_END
+
 MAN_BEGIN (U"Sound: To Ltas (pitch-corrected)...", U"ppgb", 20061203)
 INTRO (U"A command available in the #Spectrum menu if you select one or more @Sound objects. "
 	"It tries to compute an @Ltas of the spectral envelope of the voiced parts, "
@@ -405,7 +420,9 @@ INTRO (U"A command that appears in the #Spectrum menu if you select one or more
 ENTRY (U"Setting")
 TAG (U"##Fast")
 DEFINITION (U"determines whether zeroes are appended to the sound such that the number of samples is a power of two. "
-	"This can appreciably speed up the Fourier transform.")
+	"This can speed up the Fourier transform somewhat, but it can almost double the memory that it needs. "
+	"If you switch this off, the spectrum is computed for the exact number of samples of the sound; "
+	"this is still fast for any number of samples, even a large prime number.")
 ENTRY (U"Mathematical procedure")
 NORMAL (U"For the Fourier transform, the Praat-defined @@time domain@ of the @Sound is ignored. "
 	"Instead, its time domain is considered to run from %t=0 to %t=%T, "
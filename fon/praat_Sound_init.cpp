@@ -20,6 +20,8 @@
 
 #include "Ltas.h"
 #include "LongSound.h"
+#include "Sound_convolve.h"
+#include "Sound_resample.h"
 #include "Manipulation.h"
 #include "ParamCurve.h"
 #include "Sound_and_Spectrogram.h"
@@ -154,6 +156,55 @@ DO
 	}
 END2 }
 	
+FORM3 (SAVE_LongSound_resampleToWavFile, U"LongSound: Resample to WAV file", nullptr) {
+	LABEL (U"", U"Audio file:")
+	TEXTFIELD (U"Audio file", U"")
+	POSITIVE (U"New sampling frequency (Hz)", U"16000.0")
+	NATURAL (U"Precision (samples)", U"50")
+	OK2
+DO
+	LOOP {
+		iam (LongSound);
+		structMelderFile file = { 0 };
+		Melder_relativePathToFile (GET_STRING (U"Audio file"), & file);
+		LongSound_resampleToAudioFile (me, GET_REAL (U"New sampling frequency"), GET_INTEGER (U"Precision"), & file, Melder_WAV, 16);
+	}
+END2 }
+
+FORM3 (NEW_LongSound_to_Pitch, U"LongSound: To Pitch", U"LongSound: To Pitch...") {
+	LABEL (U"", U"Finding the candidates")
+	REAL (U"Time step (s)", U"0.0 (= auto)")
+	POSITIVE (U"Pitch floor (Hz)", U"75.0")
+	NATURAL (U"Max. number of candidates", U"15")
+	OPTIONMENU (U"Method", 1)
+		OPTION (U"autocorrelation")
+		OPTION (U"cross-correlation")
+	BOOLEAN (U"Very accurate", false)
+	LABEL (U"", U"Finding a path")
+	REAL (U"Silence threshold", U"0.03")
+	REAL (U"Voicing threshold", U"0.45")
+	REAL (U"Octave cost", U"0.01")
+	REAL (U"Octave-jump cost", U"0.35")
+	REAL (U"Voiced / unvoiced cost", U"0.14")
+	POSITIVE (U"Pitch ceiling (Hz)", U"600.0")
+	POSITIVE (U"Lookahead (s)", U"0.5")
+	OK2
+DO
+	long maxnCandidates = GET_INTEGER (U"Max. number of candidates");
+	if (maxnCandidates <= 1) Melder_throw (U"Maximum number of candidates must be greater than 1.");
+	bool crossCorrelation = GET_INTEGER (U"Method") == 2;
+	LOOP {
+		iam (LongSound);
+		autoPitch thee = LongSound_to_Pitch_any (me, GET_REAL (U"Time step"),
+			GET_REAL (U"Pitch floor"), crossCorrelation ? 1.0 : 3.0, maxnCandidates,
+			(crossCorrelation ? 2 : 0) + GET_INTEGER (U"Very accurate"),
+			GET_REAL (U"Silence threshold"), GET_REAL (U"Voicing threshold"),
+			GET_REAL (U"Octave cost"), GET_REAL (U"Octave-jump cost"),
+			GET_REAL (U"Voiced / unvoiced cost"), GET_REAL (U"Pitch ceiling"), GET_REAL (U"Lookahead"));
+		praat_new (thee.move(), my name);
+	}
+END2 }
+
 FORM3 (NEW_LongSound_to_TextGrid, U"LongSound: To TextGrid...", U"LongSound: To TextGrid...") {
 	SENTENCE (U"Tier names", U"Mary John bell")
 	SENTENCE (U"Point tiers", U"bell")
@@ -383,6 +434,28 @@ FORM_WRITE3 (SAVE_LongSound_Sound_saveAsWavFile, U"Save as WAV file", nullptr, U
 	LongSound_concatenate (list.get(), file, Melder_WAV, 16);
 END2 }
 
+FORM3 (SAVE_LongSound_Sound_convolveToWavFile, U"LongSound & Sound: Convolve to WAV file", U"LongSound & Sound: Convolve to WAV file...") {
+	LABEL (U"", U"Audio file:")
+	TEXTFIELD (U"Audio file", U"")
+	RADIO_ENUM (U"Amplitude scaling", kSounds_convolve_scaling, DEFAULT)
+	RADIO_ENUM (U"Signal outside time domain is...", kSounds_convolve_signalOutsideTimeDomain, DEFAULT)
+	OK2
+DO
+	LongSound longSound = nullptr;
+	Sound sound = nullptr;
+	LOOP {
+		if (CLASS == classLongSound) longSound = (LongSound) OBJECT;
+		if (CLASS == classSound) sound = (Sound) OBJECT;
+	}
+	Melder_assert (longSound && sound);
+	structMelderFile file = { 0 };
+	Melder_relativePathToFile (GET_STRING (U"Audio file"), & file);
+	LongSound_Sound_convolveToAudioFile (longSound, sound,
+		GET_ENUM (kSounds_convolve_scaling, U"Amplitude scaling"),
+		GET_ENUM (kSounds_convolve_signalOutsideTimeDomain, U"Signal outside time domain is..."),
+		& file, Melder_WAV, 16);
+END2 }
+
 /********** SOUND **********/
 
 FORM3 (MODIFY_Sound_add, U"Sound: Add", nullptr) {
@@ -1984,6 +2057,71 @@ DO
 	}
 END2 }
 
+FORM3 (NEW_Sound_to_Pitch_multirate, U"Sound: To Pitch (multirate)", nullptr) {
+	LABEL (U"", U"Finding the candidates")
+	REAL (U"Time step (s)", U"0.0 (= auto)")
+	POSITIVE (U"Pitch floor (Hz)", U"75.0")
+	NATURAL (U"Max. number of candidates", U"15")
+	OPTIONMENU (U"Method", 1)
+		OPTION (U"autocorrelation")
+		OPTION (U"cross-correlation")
+	BOOLEAN (U"Very accurate", false)
+	LABEL (U"", U"Finding a path")
+	REAL (U"Silence threshold", U"0.03")
+	REAL (U"Voicing threshold", U"0.45")
+	REAL (U"Octave cost", U"0.01")
+	REAL (U"Octave-jump cost", U"0.35")
+	REAL (U"Voiced / unvoiced cost", U"0.14")
+	POSITIVE (U"Pitch ceiling (Hz)", U"600.0")
+	OK2
+DO
+	long maxnCandidates = GET_INTEGER (U"Max. number of candidates");
+	if (maxnCandidates <= 1) Melder_throw (U"Maximum number of candidates must be greater than 1.");
+	bool crossCorrelation = GET_INTEGER (U"Method") == 2;
+	LOOP {
+		iam (Sound);
+		autoPitch thee = Sound_to_Pitch_any_multirate (me, GET_REAL (U"Time step"),
+			GET_REAL (U"Pitch floor"), crossCorrelation ? 1.0 : 3.0, maxnCandidates,
+			(crossCorrelation ? 2 : 0) + GET_INTEGER (U"Very accurate"),
+			GET_REAL (U"Silence threshold"), GET_REAL (U"Voicing threshold"),
+			GET_REAL (U"Octave cost"), GET_REAL (U"Octave-jump cost"),
+			GET_REAL (U"Voiced / unvoiced cost"), GET_REAL (U"Pitch ceiling"));
+		praat_new (thee.move(), my name);
+	}
+END2 }
+
+FORM3 (INFO_Sound_validateMultiratePitch, U"Sound: Validate multirate pitch", nullptr) {
+	LABEL (U"", U"Finding the candidates")
+	REAL (U"Time step (s)", U"0.0 (= auto)")
+	POSITIVE (U"Pitch floor (Hz)", U"75.0")
+	NATURAL (U"Max. number of candidates", U"15")
+	OPTIONMENU (U"Method", 1)
+		OPTION (U"autocorrelation")
+		OPTION (U"cross-correlation")
+	BOOLEAN (U"Very accurate", false)
+	LABEL (U"", U"Finding a path")
+	REAL (U"Silence threshold", U"0.03")
+	REAL (U"Voicing threshold", U"0.45")
+	REAL (U"Octave cost", U"0.01")
+	REAL (U"Octave-jump cost", U"0.35")
+	REAL (U"Voiced / unvoiced cost", U"0.14")
+	POSITIVE (U"Pitch ceiling (Hz)", U"600.0")
+	OK2
+DO
+	long maxnCandidates = GET_INTEGER (U"Max. number of candidates");
+	if (maxnCandidates <= 1) Melder_throw (U"Maximum number of candidates must be greater than 1.");
+	bool crossCorrelation = GET_INTEGER (U"Method") == 2;
+	LOOP {
+		iam (Sound);
+		Sound_to_Pitch_any_validateMultirate (me, GET_REAL (U"Time step"),
+			GET_REAL (U"Pitch floor"), crossCorrelation ? 1.0 : 3.0, maxnCandidates,
+			(crossCorrelation ? 2 : 0) + GET_INTEGER (U"Very accurate"),
+			GET_REAL (U"Silence threshold"), GET_REAL (U"Voicing threshold"),
+			GET_REAL (U"Octave cost"), GET_REAL (U"Octave-jump cost"),
+			GET_REAL (U"Voiced / unvoiced cost"), GET_REAL (U"Pitch ceiling"));
+	}
+END2 }
+
 FORM3 (NEW_Sound_to_PointProcess_extrema, U"Sound: To PointProcess (extrema)", nullptr) {
 	CHANNEL (U"Channel (number, Left, or Right)", U"1")
 	BOOLEAN (U"Include maxima", true)
@@ -2066,6 +2204,23 @@ DO
 	}
 END2 }
 
+FORM3 (NEW_Sound_to_Spectrogram_singlePrecision, U"Sound: To Spectrogram (single precision)", U"Sound: To Spectrogram (single precision)...") {
+	POSITIVE (U"Window length (s)", U"0.005")
+	POSITIVE (U"Maximum frequency (Hz)", U"5000.0")
+	POSITIVE (U"Time step (s)", U"0.002")
+	POSITIVE (U"Frequency step (Hz)", U"20.0")
+	RADIO_ENUM (U"Window shape", kSound_to_Spectrogram_windowShape, DEFAULT)
+	OK2
+DO
+	LOOP {
+		iam (Sound);
+		autoSpectrogram thee = Sound_to_Spectrogram_singlePrecision (me, GET_REAL (U"Window length"),
+			GET_REAL (U"Maximum frequency"), GET_REAL (U"Time step"),
+			GET_REAL (U"Frequency step"), GET_ENUM (kSound_to_Spectrogram_windowShape, U"Window shape"), 8.0, 8.0);
+		praat_new (thee.move(), my name);
+	}
+END2 }
+
 FORM3 (NEW_Sound_to_Spectrum, U"Sound: To Spectrum", U"Sound: To Spectrum...") {
 	BOOLEAN (U"Fast", true)
 	OK2
@@ -2529,6 +2684,8 @@ void praat_uvafon_Sound_init () {
 		praat_addAction1 (classLongSound, 0, U"Annotation tutorial", nullptr, 1, HELP_AnnotationTutorial);
 		praat_addAction1 (classLongSound, 0, U"-- to text grid --", nullptr, 1, nullptr);
 		praat_addAction1 (classLongSound, 0, U"To TextGrid...", nullptr, 1, NEW_LongSound_to_TextGrid);
+	praat_addAction1 (classLongSound, 0, U"Analyse -", nullptr, 0, nullptr);
+		praat_addAction1 (classLongSound, 0, U"To Pitch...", nullptr, 1, NEW_LongSound_to_Pitch);
 	praat_addAction1 (classLongSound, 0, U"Convert to Sound", nullptr, 0, nullptr);
 	praat_addAction1 (classLongSound, 0, U"Extract part...", nullptr, 0, NEW_LongSound_extractPart);
 	praat_addAction1 (classLongSound, 0, U"Concatenate?", nullptr, 0, INFO_LongSound_concatenate);
@@ -2570,6 +2727,7 @@ void praat_uvafon_Sound_init () {
 	praat_addAction1 (classLongSound, 0,   U"Write right channel to FLAC file...", U"*Save right channel as FLAC file...", praat_DEPRECATED_2011, SAVE_LongSound_saveRightChannelAsFlacFile);
 	praat_addAction1 (classLongSound, 0, U"Save part as audio file...", nullptr, 0, SAVE_LongSound_savePartAsAudioFile);
 	praat_addAction1 (classLongSound, 0,   U"Write part to audio file...", U"*Save part as audio file...", praat_DEPRECATED_2011, SAVE_LongSound_savePartAsAudioFile);
+	praat_addAction1 (classLongSound, 0, U"Resample to WAV file...", nullptr, 0, SAVE_LongSound_resampleToWavFile);
 
 	praat_addAction1 (classSound, 0, U"Save as WAV file...", nullptr, 0, SAVE_Sound_saveAsWavFile);
 	praat_addAction1 (classSound, 0,   U"Write to WAV file...", U"*Save as WAV file...", praat_DEPRECATED_2011, SAVE_Sound_saveAsWavFile);
@@ -2688,6 +2846,8 @@ void praat_uvafon_Sound_init () {
 		praat_addAction1 (classSound, 0, U"To Pitch...", nullptr, 1, NEW_Sound_to_Pitch);
 		praat_addAction1 (classSound, 0, U"To Pitch (ac)...", nullptr, 1, NEW_Sound_to_Pitch_ac);
 		praat_addAction1 (classSound, 0, U"To Pitch (cc)...", nullptr, 1, NEW_Sound_to_Pitch_cc);
+		praat_addAction1 (classSound, 0, U"To Pitch (multirate)...", nullptr, 1, NEW_Sound_to_Pitch_multirate);
+		praat_addAction1 (classSound, 1, U"Validate multirate pitch...", nullptr, 1, INFO_Sound_validateMultiratePitch);
 		praat_addAction1 (classSound, 0, U"To PointProcess (periodic, cc)...", nullptr, 1, NEW_Sound_to_PointProcess_periodic_cc);
 		praat_addAction1 (classSound, 0, U"To PointProcess (periodic, peaks)...", nullptr, 1, NEW_Sound_to_PointProcess_periodic_peaks);
 		praat_addAction1 (classSound, 0, U"-- points --", nullptr, 1, nullptr);
@@ -2708,6 +2868,7 @@ void praat_uvafon_Sound_init () {
 		praat_addAction1 (classSound, 0, U"To Ltas (pitch-corrected)...", nullptr, 1, NEW_Sound_to_Ltas_pitchCorrected);
 		praat_addAction1 (classSound, 0, U"-- spectrotemporal --", nullptr, 1, nullptr);
 		praat_addAction1 (classSound, 0, U"To Spectrogram...", nullptr, 1, NEW_Sound_to_Spectrogram);
+		praat_addAction1 (classSound, 0, U"To Spectrogram (single precision)...", nullptr, 1, NEW_Sound_to_Spectrogram_singlePrecision);
 		praat_addAction1 (classSound, 0, U"To Cochleagram...", nullptr, 1, NEW_Sound_to_Cochleagram);
 		praat_addAction1 (classSound, 0, U"To Cochleagram (edb)...", nullptr, praat_DEPTH_1 | praat_HIDDEN, NEW_Sound_to_Cochleagram_edb);
 		praat_addAction1 (classSound, 0, U"-- formants --", nullptr, 1, nullptr);
@@ -2767,6 +2928,7 @@ void praat_uvafon_Sound_init () {
 	praat_addAction2 (classLongSound, 0, classSound, 0,   U"Write to NIST file...", U"*Save as NIST file...", praat_DEPRECATED_2011, SAVE_LongSound_Sound_saveAsNistFile);
 	praat_addAction2 (classLongSound, 0, classSound, 0, U"Save as FLAC file...", nullptr, 0, SAVE_LongSound_Sound_saveAsFlacFile);
 	praat_addAction2 (classLongSound, 0, classSound, 0,   U"Write to FLAC file...", U"*Save as FLAC file...", praat_DEPRECATED_2011, SAVE_LongSound_Sound_saveAsFlacFile);
+	praat_addAction2 (classLongSound, 1, classSound, 1, U"Convolve to WAV file...", nullptr, 0, SAVE_LongSound_Sound_convolveToWavFile);
 }
 
 /* End of file praat_Sound.cpp */
@@ -162,7 +162,7 @@ static double binomialQ (double p, void *binomial_void) {
 }
 
 double NUMinvBinomialP (double p, double k, double n) {
-	static struct binomial binomial;
+	struct binomial binomial;   // not static: can be called from several threads
 	if (p < 0 || p > 1 || n <= 0 || k < 0 || k > n) return NUMundefined;
 	if (k == n) return 1.0;
 	binomial. p = p;
@@ -172,7 +172,7 @@ double NUMinvBinomialP (double p, double k, double n) {
 }
 
 double NUMinvBinomialQ (double p, double k, double n) {
-	static struct binomial binomial;
+	struct binomial binomial;
 	if (p < 0 || p > 1 || n <= 0 || k < 0 || k > n) return NUMundefined;
 	if (k == 0) return 0.0;
 	binomial. p = p;
@@ -18,8 +18,9 @@
 
 #include "NUM.h"
 #include "melder.h"
+#include <atomic>
 
-static long theTotalNumberOfArrays;
+static std::atomic <long> theTotalNumberOfArrays;   // arrays may be created in worker threads
 
 long NUM_getTotalNumberOfArrays () { return theTotalNumberOfArrays; }
 
@@ -198,6 +199,36 @@ bool NUMmatrix_equal (long elementSize, void *m1, void *m2, long row1, long row2
 
 /*** Typed I/O routines for vectors and matrices. ***/
 
+/*
+	A vector, or the cells of a matrix (which NUMmatrix allocates contiguously, row after row),
+	are read or written as a single stretch of consecutive elements.
+	Doubles go through the whole-array routines of abcio; the other types go element by element.
+*/
+#define STRETCH(type,storage)  \
+	static void binput##storage##_stretch (const type *x, long n, FILE *f) { \
+		for (long i = 0; i < n; i ++) \
+			binput##storage (x [i], f); \
+	} \
+	static void binget##storage##_stretch (type *x, long n, FILE *f) { \
+		for (long i = 0; i < n; i ++) \
+			x [i] = binget##storage (f); \
+	}
+
+STRETCH (signed char, i1)
+STRETCH (int, i2)
+STRETCH (long, i4)
+STRETCH (unsigned char, u1)
+STRETCH (unsigned int, u2)
+STRETCH (unsigned long, u4)
+STRETCH (double, r4)
+STRETCH (fcomplex, c8)
+STRETCH (dcomplex, c16)
+#undef STRETCH
+
+static void binputr8_stretch (const double *x, long n, FILE *f) { binputr8_array (x, n, f); }
+static void bingetr8_stretch (double *x, long n, FILE *f) { bingetr8_array (x, n, f); }
+
+
 #define FUNCTION(type,storage)  \
 	void NUMvector_writeText_##storage (const type *v, long lo, long hi, MelderFile file, const char32 *name) { \
 		texputintro (file, name, U" []: ", hi >= lo ? nullptr : U"(empty)", 0,0,0); \
@@ -207,8 +238,8 @@ bool NUMmatrix_equal (long elementSize, void *m1, void *m2, long row1, long row2
 		if (feof (file -> filePointer) || ferror (file -> filePointer)) Melder_throw (U"Write error."); \
 	} \
 	void NUMvector_writeBinary_##storage (const type *v, long lo, long hi, FILE *f) { \
-		for (long i = lo; i <= hi; i ++) \
-			binput##storage (v [i], f); \
+		if (hi >= lo) \
+			binput##storage##_stretch (& v [lo], hi - lo + 1, f); \
 		if (feof (f) || ferror (f)) Melder_throw (U"Write error."); \
 	} \
 	type * NUMvector_readText_##storage (long lo, long hi, MelderReadText text, const char *name) { \
@@ -232,9 +263,8 @@ bool NUMmatrix_equal (long elementSize, void *m1, void *m2, long row1, long row2
 		type *result = nullptr; \
 		try { \
 			result = NUMvector <type> (lo, hi); \
-			for (long i = lo; i <= hi; i ++) { \
-				result [i] = binget##storage (f); \
-			} \
+			if (hi >= lo) \
+				binget##storage##_stretch (& result [lo], hi - lo + 1, f); \
 			return result; \
 		} catch (MelderError) { \
 			NUMvector_free (result, lo); \
@@ -256,12 +286,8 @@ bool NUMmatrix_equal (long elementSize, void *m1, void *m2, long row1, long row2
 		if (feof (file -> filePointer) || ferror (file -> filePointer)) Melder_throw (U"Write error."); \
 	} \
 	void NUMmatrix_writeBinary_##storage (type **m, long row1, long row2, long col1, long col2, FILE *f) { \
-		if (row2 >= row1) { \
-			for (long irow = row1; irow <= row2; irow ++) { \
-				for (long icol = col1; icol <= col2; icol ++) \
-					binput##storage (m [irow] [icol], f); \
-			} \
-		} \
+		if (row2 >= row1 && col2 >= col1) \
+			binput##storage##_stretch (& m [row1] [col1], (row2 - row1 + 1) * (col2 - col1 + 1), f); \
 		if (feof (f) || ferror (f)) Melder_throw (U"Write error."); \
 	} \
 	type ** NUMmatrix_readText_##storage (long row1, long row2, long col1, long col2, MelderReadText text, const char *name) { \
@@ -285,8 +311,8 @@ bool NUMmatrix_equal (long elementSize, void *m1, void *m2, long row1, long row2
 		type **result = nullptr; \
 		try { \
 			result = NUMmatrix <type> (row1, row2, col1, col2); \
-			for (long irow = row1; irow <= row2; irow ++) for (long icol = col1; icol <= col2; icol ++) \
-				result [irow] [icol] = binget##storage (f); \
+			if (row2 >= row1 && col2 >= col1) \
+				binget##storage##_stretch (& result [row1] [col1], (row2 - row1 + 1) * (col2 - col1 + 1), f); \
 			return result; \
 		} catch (MelderError) { \
 			NUMmatrix_free (result, row1, col1); \
@@ -33,14 +33,13 @@
 #include "longchar.h"
 #include "UiPause.h"
 #include "DemoEditor.h"
+#include <vector>
 
 static Interpreter theInterpreter;
 static autoInterpreter theLocalInterpreter;
 static Daata theSource;
 static const char32 *theExpression;
-static int theLevel = 1;
-#define MAXIMUM_NUMBER_OF_LEVELS  20
-static int theExpressionType [1 + MAXIMUM_NUMBER_OF_LEVELS];
+static int theExpressionType;
 static bool theOptimize;
 
 static struct Formula_NumericVector theZeroNumericVector = { 0, nullptr };
@@ -662,19 +661,15 @@ static void Formula_lexan () {
 					U"(variables start with lower case; object names contain an underscore).");
 			} else if (str32nequ (token.string, U"Object_", 7)) {
 				long uniqueID = a32tol (token.string + 7);
-				int i = theCurrentPraatObjects -> n;
-				while (i > 0 && uniqueID != theCurrentPraatObjects -> list [i]. id)
-					i --;
+				int i = praat_iobjectFromId (uniqueID);
 				if (i == 0)
 					formulefout (U"No such object (note: variables start with lower case)", ikar);
 				nieuwtok (endsInDollarSign ? MATRIKSSTR_ : MATRIKS_)
 				tokmatriks ((Daata) theCurrentPraatObjects -> list [i]. object);
 			} else {
-				int i = theCurrentPraatObjects -> n;
 				*underscore = ' ';
 				if (endsInDollarSign) token.string [-- token.length] = '\0';
-				while (i > 0 && ! str32equ (token.string, theCurrentPraatObjects -> list [i]. name))
-					i --;
+				int i = praat_iobjectFromFullName (token.string);
 				if (i == 0)
 					formulefout (U"No such object (note: variables start with lower case)", ikar);
 				nieuwtok (endsInDollarSign ? MATRIKSSTR_ : MATRIKS_)
@@ -1909,6 +1904,64 @@ static void Formula_print (FormulaInstruction f) {
 	} while (symbol != END_);
 }
 
+/*
+	A program owns a copy of the instructions in "parse", so that it is not affected by the next compilation.
+*/
+
+Thing_implement (FormulaProgram, Thing, 0);
+
+static bool FormulaInstruction_hasString (int symbol) {
+	return symbol == STRING_ || symbol == VARIABLE_NAME_ || symbol == INDEXED_NUMERIC_VARIABLE_ || symbol == INDEXED_STRING_VARIABLE_ || symbol == CALL_;
+}
+
+static void FormulaProgram_freeStrings (FormulaProgram me) {
+	for (int i = 1; i <= my numberOfInstructions; i ++)
+		if (FormulaInstruction_hasString (my instructions [i]. symbol))
+			Melder_free (my instructions [i]. content.string);
+	my numberOfInstructions = 0;
+}
+
+void structFormulaProgram :: v_destroy () noexcept {
+	if (our instructions) {
+		FormulaProgram_freeStrings (this);
+		NUMvector_free (our instructions, 1);
+	}
+	FormulaProgram_Parent :: v_destroy ();
+}
+
+static void FormulaProgram_copyFromParse (FormulaProgram me) {
+	/*
+		The program that Formula_compile () compiles into is reused from call to call,
+		so that compiling a formula does not have to allocate a new program every time.
+	*/
+	FormulaProgram_freeStrings (me);
+	if (numberOfInstructions > my _capacity) {
+		NUMvector_free (my instructions, 1);
+		my instructions = nullptr;
+		my _capacity = 0;
+		my instructions = NUMvector <struct structFormulaInstruction> (1, numberOfInstructions);
+		my _capacity = numberOfInstructions;
+	}
+	for (int i = 1; i <= numberOfInstructions; i ++) {
+		my instructions [i] = parse [i];
+		if (FormulaInstruction_hasString (parse [i]. symbol)) {
+			my instructions [i]. content.string = nullptr;   // in case Melder_dup throws
+			my numberOfInstructions = i;
+			my instructions [i]. content.string = Melder_dup (parse [i]. content.string);
+		}
+	}
+	my numberOfInstructions = numberOfInstructions;
+	my expressionType = theExpressionType;
+	my optimize = theOptimize;
+	my source = theSource;
+	my interpreter = theInterpreter;
+}
+
+/*
+	The program that Formula_run () runs.
+*/
+static autoFormulaProgram theCompiledProgram;
+
 void Formula_compile (Interpreter interpreter, Daata data, const char32 *expression, int expressionType, bool optimize) {
 	theInterpreter = interpreter;
 	if (! theInterpreter) {
@@ -1924,7 +1977,7 @@ void Formula_compile (Interpreter interpreter, Daata data, const char32 *express
 	}
 	theSource = data;
 	theExpression = expression;
-	theExpressionType [theLevel] = expressionType;
+	theExpressionType = expressionType;
 	theOptimize = optimize;
 	if (! lexan) {
 		lexan = Melder_calloc_f (struct structFormulaInstruction, 3000);
@@ -1940,7 +1993,7 @@ void Formula_compile (Interpreter interpreter, Daata data, const char32 *express
 		ilexan = 1;
 		for (;;) {
 			int symbol = lexan [ilexan]. symbol;
-			if (symbol == STRING_ || symbol == VARIABLE_NAME_ || symbol == INDEXED_NUMERIC_VARIABLE_ || symbol == INDEXED_STRING_VARIABLE_ || symbol == CALL_) Melder_free (lexan [ilexan]. content.string);
+			if (FormulaInstruction_hasString (symbol)) Melder_free (lexan [ilexan]. content.string);
 			else if (symbol == END_) break;   /* Either the end of a formula, or the end of lexan. */
 			ilexan ++;
 		}
@@ -1959,13 +2012,29 @@ void Formula_compile (Interpreter interpreter, Daata data, const char32 *express
 	}
 	Formula_removeLabels ();
 	if (Melder_debug == 17) Formula_print (parse);
+	if (! theCompiledProgram)
+		theCompiledProgram = Thing_new (FormulaProgram);
+	FormulaProgram_copyFromParse (theCompiledProgram.get());
+}
+
+autoFormulaProgram Formula_compileProgram (Interpreter interpreter, Daata data, const char32 *expression, int expressionType, bool optimize) {
+	Formula_compile (interpreter, data, expression, expressionType, optimize);
+	return theCompiledProgram.move();
 }
 
 /*
  * Running.
  */
 
-static int programPointer;
+/*
+	The state of the program that is running in this thread.
+	A program can be run while another is already running in the same thread
+	(e.g. if a formula calls a script or a command that runs a formula);
+	FormulaProgram_run () then saves this state, lets the new program use the stack above the old program's part,
+	and restores the state when the new program has finished.
+*/
+static thread_local FormulaProgram theProgram;
+static thread_local int programPointer;
 
 static void Stackel_cleanUp (Stackel me) {
 	if (my which == Stackel_STRING) {
@@ -1978,8 +2047,10 @@ static void Stackel_cleanUp (Stackel me) {
 		my numericMatrix = theZeroNumericMatrix;
 	}
 }
-static Stackel theStack;
-static int w, wmax;   /* w = stack pointer; */
+#define Formula_STACK_SIZE  10000
+static thread_local std::vector <struct structStackel> theStackMemory;
+static thread_local Stackel theStack, theStackBottom;
+static thread_local int w, wmax;   /* w = stack pointer; */
 #define pop  & theStack [w --]
 static inline void pushNumber (double x) {
 	/* inline runs 10 to 20 percent faster on i386; here's the test script:
@@ -2456,7 +2527,7 @@ static void do_function_n_n (double (*f) (double)) {
 	if (x->which == Stackel_NUMBER) {
 		pushNumber (x->number == NUMundefined ? NUMundefined : f (x->number));
 	} else {
-		Melder_throw (U"The function ", Formula_instructionNames [parse [programPointer]. symbol],
+		Melder_throw (U"The function ", Formula_instructionNames [theProgram -> instructions [programPointer]. symbol],
 			U" requires a numeric argument, not ", Stackel_whichText (x), U".");
 	}
 }
@@ -2471,7 +2542,7 @@ static void do_functionvec_n_n (double (*f) (double)) {
 		}
 		pushNumericVector (nelm, result);
 	} else {
-		Melder_throw (U"The function ", Formula_instructionNames [parse [programPointer]. symbol],
+		Melder_throw (U"The function ", Formula_instructionNames [theProgram -> instructions [programPointer]. symbol],
 			U" requires a numeric vector argument, not ", Stackel_whichText (x), U".");
 	}
 	#else
@@ -2482,7 +2553,7 @@ static void do_functionvec_n_n (double (*f) (double)) {
 			x->numericVector.data [i] = f (x->numericVector.data [i]);
 		}
 	} else {
-		Melder_throw (U"The function ", Formula_instructionNames [parse [programPointer]. symbol],
+		Melder_throw (U"The function ", Formula_instructionNames [theProgram -> instructions [programPointer]. symbol],
 			U" requires a numeric vector argument, not ", Stackel_whichText (x), U".");
 	}
 	#endif
@@ -2509,7 +2580,7 @@ static void do_softmax () {
 			x->numericVector.data [i] /= sum;
 		}
 	} else {
-		Melder_throw (U"The function ", Formula_instructionNames [parse [programPointer]. symbol],
+		Melder_throw (U"The function ", Formula_instructionNames [theProgram -> instructions [programPointer]. symbol],
 			U" requires a numeric vector argument, not ", Stackel_whichText (x), U".");
 	}
 }
@@ -2782,7 +2853,7 @@ static void do_function_dd_d (double (*f) (double, double)) {
 		pushNumber (x->number == NUMundefined || y->number == NUMundefined ? NUMundefined :
 			f (x->number, y->number));
 	} else {
-		Melder_throw (U"The function ", Formula_instructionNames [parse [programPointer]. symbol],
+		Melder_throw (U"The function ", Formula_instructionNames [theProgram -> instructions [programPointer]. symbol],
 			U" requires two numeric arguments, not ",
 			Stackel_whichText (x), U" and ", Stackel_whichText (y), U".");
 	}
@@ -2791,7 +2862,7 @@ static void do_function_dd_d_numvec (double (*f) (double, double)) {
 	Stackel n = pop;
 	Melder_assert (n -> which == Stackel_NUMBER);
 	if (n -> number != 3)
-		Melder_throw (U"The function ", Formula_instructionNames [parse [programPointer]. symbol], U" requires three arguments.");
+		Melder_throw (U"The function ", Formula_instructionNames [theProgram -> instructions [programPointer]. symbol], U" requires three arguments.");
 	Stackel y = pop, x = pop, a = pop;
 	if (a->which == Stackel_NUMERIC_VECTOR && x->which == Stackel_NUMBER && y->which == Stackel_NUMBER) {
 		long numberOfElements = a->numericVector.numberOfElements;
@@ -2801,7 +2872,7 @@ static void do_function_dd_d_numvec (double (*f) (double, double)) {
 		}
 		pushNumericVector (numberOfElements, newData);
 	} else {
-		Melder_throw (U"The function ", Formula_instructionNames [parse [programPointer]. symbol],
+		Melder_throw (U"The function ", Formula_instructionNames [theProgram -> instructions [programPointer]. symbol],
 			U" requires one vector argument and two numeric arguments, not ",
 			Stackel_whichText (a), U", ", Stackel_whichText (x), U" and ", Stackel_whichText (y), U".");
 	}
@@ -2810,7 +2881,7 @@ static void do_function_dd_d_nummat (double (*f) (double, double)) {
 	Stackel n = pop;
 	Melder_assert (n -> which == Stackel_NUMBER);
 	if (n -> number != 3)
-		Melder_throw (U"The function ", Formula_instructionNames [parse [programPointer]. symbol], U" requires three arguments.");
+		Melder_throw (U"The function ", Formula_instructionNames [theProgram -> instructions [programPointer]. symbol], U" requires three arguments.");
 	Stackel y = pop, x = pop, a = pop;
 	if (a->which == Stackel_NUMERIC_MATRIX && x->which == Stackel_NUMBER && y->which == Stackel_NUMBER) {
 		long numberOfRows = a->numericMatrix.numberOfRows;
@@ -2823,7 +2894,7 @@ static void do_function_dd_d_nummat (double (*f) (double, double)) {
 		}
 		pushNumericMatrix (numberOfRows, numberOfColumns, newData);
 	} else {
-		Melder_throw (U"The function ", Formula_instructionNames [parse [programPointer]. symbol],
+		Melder_throw (U"The function ", Formula_instructionNames [theProgram -> instructions [programPointer]. symbol],
 			U" requires one matrix argument and two numeric arguments, not ",
 			Stackel_whichText (a), U", ", Stackel_whichText (x), U" and ", Stackel_whichText (y), U".");
 	}
@@ -2832,7 +2903,7 @@ static void do_function_ll_l_numvec (long (*f) (long, long)) {
 	Stackel n = pop;
 	Melder_assert (n -> which == Stackel_NUMBER);
 	if (n -> number != 3)
-		Melder_throw (U"The function ", Formula_instructionNames [parse [programPointer]. symbol], U" requires three arguments.");
+		Melder_throw (U"The function ", Formula_instructionNames [theProgram -> instructions [programPointer]. symbol], U" requires three arguments.");
 	Stackel y = pop, x = pop, a = pop;
 	if (a->which == Stackel_NUMERIC_VECTOR && x->which == Stackel_NUMBER) {
 		long numberOfElements = a->numericVector.numberOfElements;
@@ -2842,7 +2913,7 @@ static void do_function_ll_l_numvec (long (*f) (long, long)) {
 		}
 		pushNumericVector (numberOfElements, newData);
 	} else {
-		Melder_throw (U"The function ", Formula_instructionNames [parse [programPointer]. symbol],
+		Melder_throw (U"The function ", Formula_instructionNames [theProgram -> instructions [programPointer]. symbol],
 			U" requires one vector argument and two numeric arguments, not ",
 			Stackel_whichText (a), U", ", Stackel_whichText (x), U" and ", Stackel_whichText (y), U".");
 	}
@@ -2851,7 +2922,7 @@ static void do_function_ll_l_nummat (long (*f) (long, long)) {
 	Stackel n = pop;
 	Melder_assert (n -> which == Stackel_NUMBER);
 	if (n -> number != 3)
-		Melder_throw (U"The function ", Formula_instructionNames [parse [programPointer]. symbol], U" requires three arguments.");
+		Melder_throw (U"The function ", Formula_instructionNames [theProgram -> instructions [programPointer]. symbol], U" requires three arguments.");
 	Stackel y = pop, x = pop, a = pop;
 	if (a->which == Stackel_NUMERIC_MATRIX && x->which == Stackel_NUMBER && y->which == Stackel_NUMBER) {
 		long numberOfRows = a->numericMatrix.numberOfRows;
@@ -2864,7 +2935,7 @@ static void do_function_ll_l_nummat (long (*f) (long, long)) {
 		}
 		pushNumericMatrix (numberOfRows, numberOfColumns, newData);
 	} else {
-		Melder_throw (U"The function ", Formula_instructionNames [parse [programPointer]. symbol],
+		Melder_throw (U"The function ", Formula_instructionNames [theProgram -> instructions [programPointer]. symbol],
 			U" requires one matrix argument and two numeric arguments, not ",
 			Stackel_whichText (a), U", ", Stackel_whichText (x), U" and ", Stackel_whichText (y), U".");
 	}
@@ -2875,7 +2946,7 @@ static void do_function_dl_d (double (*f) (double, long)) {
 		pushNumber (x->number == NUMundefined || y->number == NUMundefined ? NUMundefined :
 			f (x->number, lround (y->number)));
 	} else {
-		Melder_throw (U"The function ", Formula_instructionNames [parse [programPointer]. symbol],
+		Melder_throw (U"The function ", Formula_instructionNames [theProgram -> instructions [programPointer]. symbol],
 			U" requires two numeric arguments, not ",
 			Stackel_whichText (x), U" and ", Stackel_whichText (y), U".");
 	}
@@ -2886,7 +2957,7 @@ static void do_function_ld_d (double (*f) (long, double)) {
 		pushNumber (x->number == NUMundefined || y->number == NUMundefined ? NUMundefined :
 			f (lround (x->number), y->number));
 	} else {
-		Melder_throw (U"The function ", Formula_instructionNames [parse [programPointer]. symbol],
+		Melder_throw (U"The function ", Formula_instructionNames [theProgram -> instructions [programPointer]. symbol],
 			U" requires two numeric arguments, not ",
 			Stackel_whichText (x), U" and ", Stackel_whichText (y), U".");
 	}
@@ -2897,7 +2968,7 @@ static void do_function_ll_l (long (*f) (long, long)) {
 		pushNumber (x->number == NUMundefined || y->number == NUMundefined ? NUMundefined :
 			f (lround (x->number), lround (y->number)));
 	} else {
-		Melder_throw (U"The function ", Formula_instructionNames [parse [programPointer]. symbol],
+		Melder_throw (U"The function ", Formula_instructionNames [theProgram -> instructions [programPointer]. symbol],
 			U" requires two numeric arguments, not ",
 			Stackel_whichText (x), U" and ", Stackel_whichText (y), U".");
 	}
@@ -2908,7 +2979,7 @@ static void do_function_dl_l (long (*f) (double, long)) {
 		pushNumber (x->number == NUMundefined || y->number == NUMundefined ? NUMundefined :
 			f (x->number, lround (y->number)));
 	} else {
-		Melder_throw (U"The function ", Formula_instructionNames [parse [programPointer]. symbol],
+		Melder_throw (U"The function ", Formula_instructionNames [theProgram -> instructions [programPointer]. symbol],
 			U" requires two numeric arguments, not ",
 			Stackel_whichText (x), U" and ", Stackel_whichText (y), U".");
 	}
@@ -2917,12 +2988,10 @@ static void do_objects_are_identical () {
 	Stackel y = pop, x = pop;
 	if (x->which == Stackel_NUMBER && y->which == Stackel_NUMBER) {
 		int id1 = lround (x->number), id2 = lround (y->number);
-		int i = theCurrentPraatObjects -> n;
-		while (i > 0 && id1 != theCurrentPraatObjects -> list [i]. id) i --;
+		int i = praat_iobjectFromId (id1);
 		if (i == 0) Melder_throw (U"Object #", id1, U" does not exist in function objectsAreIdentical.");
 		Daata object1 = (Daata) theCurrentPraatObjects -> list [i]. object;
-		i = theCurrentPraatObjects -> n;
-		while (i > 0 && id2 != theCurrentPraatObjects -> list [i]. id) i --;
+		i = praat_iobjectFromId (id2);
 		if (i == 0) Melder_throw (U"Object #", id2, U" does not exist in function objectsAreIdentical.");
 		Daata object2 = (Daata) theCurrentPraatObjects -> list [i]. object;
 		pushNumber (x->number == NUMundefined || y->number == NUMundefined ? NUMundefined : Data_equal (object1, object2));
@@ -2937,7 +3006,7 @@ static void do_function_ddd_d (double (*f) (double, double, double)) {
 		pushNumber (x->number == NUMundefined || y->number == NUMundefined || z->number == NUMundefined ? NUMundefined :
 			f (x->number, y->number, z->number));
 	} else {
-		Melder_throw (U"The function ", Formula_instructionNames [parse [programPointer]. symbol],
+		Melder_throw (U"The function ", Formula_instructionNames [theProgram -> instructions [programPointer]. symbol],
 			U" requires three numeric arguments, not ", Stackel_whichText (x), U", ",
 			Stackel_whichText (y), U", and ", Stackel_whichText (z), U".");
 	}
@@ -2948,7 +3017,7 @@ static void do_function_dll_d (double (*f) (double, long, long)) {
 		pushNumber (x->number == NUMundefined || y->number == NUMundefined || z->number == NUMundefined ? NUMundefined :
 			f (x->number, lround (y->number), lround (z->number)));
 	} else {
-		Melder_throw (U"The function ", Formula_instructionNames [parse [programPointer]. symbol],
+		Melder_throw (U"The function ", Formula_instructionNames [theProgram -> instructions [programPointer]. symbol],
 			U" requires three numeric arguments, not ", Stackel_whichText (x), U", ",
 			Stackel_whichText (y), U", and ", Stackel_whichText (z), U".");
 	}
@@ -2973,7 +3042,7 @@ static void do_do () {
 		MelderString_appendCharacter (& valueString, 1);   // TODO: check whether this is needed at all, or is just MelderString_empty enough?
 		autoMelderDivertInfo divert (& valueString);
 		autostring32 command2 = Melder_dup (command);   // allow the menu command to reuse the stack (?)
-		Editor_doMenuCommand (praatP. editor, command2.peek(), numberOfArguments, & stack [0], nullptr, theInterpreter);
+		Editor_doMenuCommand (praatP. editor, command2.peek(), numberOfArguments, & stack [0], nullptr, theProgram -> interpreter);
 		pushNumber (Melder_atof (valueString.string));
 		return;
 	} else if (theCurrentPraatObjects != & theForegroundPraatObjects &&
@@ -2985,8 +3054,8 @@ static void do_do () {
 		MelderString_appendCharacter (& valueString, 1);   // a semaphor to check whether praat_doAction or praat_doMenuCommand wrote anything with MelderInfo
 		autoMelderDivertInfo divert (& valueString);
 		autostring32 command2 = Melder_dup (command);   // allow the menu command to reuse the stack (?)
-		if (! praat_doAction (command2.peek(), numberOfArguments, & stack [0], theInterpreter) &&
-		    ! praat_doMenuCommand (command2.peek(), numberOfArguments, & stack [0], theInterpreter))
+		if (! praat_doAction (command2.peek(), numberOfArguments, & stack [0], theProgram -> interpreter) &&
+		    ! praat_doMenuCommand (command2.peek(), numberOfArguments, & stack [0], theProgram -> interpreter))
 		{
 			Melder_throw (U"Command \"", command, U"\" not available for current selection.");
 		}
@@ -3027,7 +3096,7 @@ static void do_doStr () {
 		MelderString_empty (& info);
 		autoMelderDivertInfo divert (& info);
 		autostring32 command2 = Melder_dup (command);
-		Editor_doMenuCommand (praatP. editor, command2.peek(), numberOfArguments, & stack [0], nullptr, theInterpreter);
+		Editor_doMenuCommand (praatP. editor, command2.peek(), numberOfArguments, & stack [0], nullptr, theProgram -> interpreter);
 		pushString (Melder_dup (info.string));
 		return;
 	} else if (theCurrentPraatObjects != & theForegroundPraatObjects &&
@@ -3039,8 +3108,8 @@ static void do_doStr () {
 		MelderString_empty (& info);
 		autoMelderDivertInfo divert (& info);
 		autostring32 command2 = Melder_dup (command);
-		if (! praat_doAction (command2.peek(), numberOfArguments, & stack [0], theInterpreter) &&
-		    ! praat_doMenuCommand (command2.peek(), numberOfArguments, & stack [0], theInterpreter))
+		if (! praat_doAction (command2.peek(), numberOfArguments, & stack [0], theProgram -> interpreter) &&
+		    ! praat_doMenuCommand (command2.peek(), numberOfArguments, & stack [0], theProgram -> interpreter))
 		{
 			Melder_throw (U"Command \"", command, U"\" not available for current selection.");
 		}
@@ -3231,9 +3300,9 @@ static void do_pauseScript () {
 		else if (arg->which == Stackel_STRING)
 			MelderString_append (& buffer, arg->string);
 	}
-	UiPause_begin (theCurrentPraatApplication -> topShell, U"stop or continue", theInterpreter);
+	UiPause_begin (theCurrentPraatApplication -> topShell, U"stop or continue", theProgram -> interpreter);
 	UiPause_comment (numberOfArguments == 0 ? U"..." : buffer.string);
-	UiPause_end (1, 1, 0, U"Continue", nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, theInterpreter);
+	UiPause_end (1, 1, 0, U"Continue", nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, theProgram -> interpreter);
 	pushNumber (1);
 }
 static void do_exitScript () {
@@ -3261,14 +3330,7 @@ static void do_runScript () {
 	Stackel fileName = & theStack [w + 1];
 	if (fileName->which != Stackel_STRING)
 		Melder_throw (U"The first argument to \"runScript\" has to be a string (the file name), not ", Stackel_whichText (fileName));
-	theLevel += 1;
-	try {
-		praat_executeScriptFromFileName (fileName->string, numberOfArguments - 1, & theStack [w + 1]);
-		theLevel -= 1;
-	} catch (MelderError) {
-		theLevel -= 1;
-		throw;
-	}
+	praat_executeScriptFromFileName (fileName->string, numberOfArguments - 1, & theStack [w + 1]);
 	pushNumber (1);
 }
 static void do_runSystem () {
@@ -3517,7 +3579,7 @@ static void do_numberOfRows () {
 	if (array->which == Stackel_NUMERIC_MATRIX) {
 		pushNumber (array->numericMatrix.numberOfRows);
 	} else {
-		Melder_throw (U"The function ", Formula_instructionNames [parse [programPointer]. symbol],
+		Melder_throw (U"The function ", Formula_instructionNames [theProgram -> instructions [programPointer]. symbol],
 			U" requires a matrix argument, not ", Stackel_whichText (array), U".");
 	}
 }
@@ -3530,7 +3592,7 @@ static void do_numberOfColumns () {
 	if (array->which == Stackel_NUMERIC_MATRIX) {
 		pushNumber (array->numericMatrix.numberOfColumns);
 	} else {
-		Melder_throw (U"The function ", Formula_instructionNames [parse [programPointer]. symbol],
+		Melder_throw (U"The function ", Formula_instructionNames [theProgram -> instructions [programPointer]. symbol],
 			U" requires a matrix argument, not ", Stackel_whichText (array), U".");
 	}
 }
@@ -3538,8 +3600,8 @@ static void do_editor () {
 	Stackel n = pop;
 	Melder_assert (n->which == Stackel_NUMBER);
 	if (n->number == 0) {
-		if (theInterpreter && theInterpreter -> editorClass) {
-			praatP. editor = praat_findEditorFromString (theInterpreter -> environmentName);
+		if (theProgram -> interpreter && theProgram -> interpreter -> editorClass) {
+			praatP. editor = praat_findEditorFromString (theProgram -> interpreter -> environmentName);
 		} else {
 			Melder_throw (U"The function \"editor\" requires an argument when called from outside an editor.");
 		}
@@ -3575,7 +3637,7 @@ static void do_hash () {
 }
 
 static void do_numericVectorElement () {
-	InterpreterVariable vector = parse [programPointer]. content.variable;
+	InterpreterVariable vector = theProgram -> instructions [programPointer]. content.variable;
 	long element = 1;   // default
 	Stackel r = pop;
 	if (r -> which != Stackel_NUMBER)
@@ -3590,7 +3652,7 @@ static void do_numericVectorElement () {
 	pushNumber (vector -> numericVectorValue. data [element]);
 }
 static void do_numericMatrixElement () {
-	InterpreterVariable matrix = parse [programPointer]. content.variable;
+	InterpreterVariable matrix = theProgram -> instructions [programPointer]. content.variable;
 	long row = 1, column = 1;   // default
 	Stackel c = pop;
 	if (c -> which != Stackel_NUMBER)
@@ -3620,7 +3682,7 @@ static void do_indexedNumericVariable () {
 	int nindex = lround (n -> number);
 	if (nindex < 1)
 		Melder_throw (U"Indexed variables require at least one index.");
-	char32 *indexedVariableName = parse [programPointer]. content.string;
+	char32 *indexedVariableName = theProgram -> instructions [programPointer]. content.string;
 	static MelderString totalVariableName { 0 };
 	MelderString_copy (& totalVariableName, indexedVariableName, U"[");
 	w -= nindex;
@@ -3634,7 +3696,7 @@ static void do_indexedNumericVariable () {
 			Melder_throw (U"In indexed variables, the index has to be a number or a string, not ", Stackel_whichText (index), U".");
 		}
 	}
-	InterpreterVariable var = Interpreter_hasVariable (theInterpreter, totalVariableName.string);
+	InterpreterVariable var = Interpreter_hasVariable (theProgram -> interpreter, totalVariableName.string);
 	if (! var)
 		Melder_throw (U"Undefined indexed variable " U_LEFT_GUILLEMET, totalVariableName.string, U_RIGHT_GUILLEMET U".");
 	pushNumber (var -> numericValue);
@@ -3645,7 +3707,7 @@ static void do_indexedStringVariable () {
 	int nindex = lround (n -> number);
 	if (nindex < 1)
 		Melder_throw (U"Indexed variables require at least one index.");
-	char32 *indexedVariableName = parse [programPointer]. content.string;
+	char32 *indexedVariableName = theProgram -> instructions [programPointer]. content.string;
 	static MelderString totalVariableName { 0 };
 	MelderString_copy (& totalVariableName, indexedVariableName, U"[");
 	w -= nindex;
@@ -3659,7 +3721,7 @@ static void do_indexedStringVariable () {
 			Melder_throw (U"In indexed variables, the index has to be a number or a string, not ", Stackel_whichText (index), U".");
 		}
 	}
-	InterpreterVariable var = Interpreter_hasVariable (theInterpreter, totalVariableName.string);
+	InterpreterVariable var = Interpreter_hasVariable (theProgram -> interpreter, totalVariableName.string);
 	if (! var)
 		Melder_throw (U"Undefined indexed variable " U_LEFT_GUILLEMET, totalVariableName.string, U_RIGHT_GUILLEMET U".");
 	autostring32 result = Melder_dup (var -> stringValue);
@@ -3847,7 +3909,7 @@ static void do_stringMatchesCriterion (int criterion) {
 		int result = Melder_stringMatchesCriterion (s->string, criterion, t->string);
 		pushNumber (result);
 	} else {
-		Melder_throw (U"The function \"", Formula_instructionNames [parse [programPointer]. symbol],
+		Melder_throw (U"The function \"", Formula_instructionNames [theProgram -> instructions [programPointer]. symbol],
 			U"\" requires two strings, not ", Stackel_whichText (s), U" and ", Stackel_whichText (t), U".");
 	}
 }
@@ -3868,7 +3930,7 @@ static void do_index_regex (int backward) {
 			}
 		}
 	} else {
-		Melder_throw (U"The function \"", Formula_instructionNames [parse [programPointer]. symbol],
+		Melder_throw (U"The function \"", Formula_instructionNames [theProgram -> instructions [programPointer]. symbol],
 			U"\" requires two strings, not ", Stackel_whichText (s), U" and ", Stackel_whichText (t), U".");
 	}
 }
@@ -3937,7 +3999,7 @@ static void do_extractNumber () {
 			}
 		}
 	} else {
-		Melder_throw (U"The function \"", Formula_instructionNames [parse [programPointer]. symbol],
+		Melder_throw (U"The function \"", Formula_instructionNames [theProgram -> instructions [programPointer]. symbol],
 			U"\" requires two strings, not ", Stackel_whichText (s), U" and ", Stackel_whichText (t), U".");
 	}
 }
@@ -3971,7 +4033,7 @@ static void do_extractTextStr (bool singleWord) {
 		}
 		pushString (result.transfer());
 	} else {
-		Melder_throw (U"The function \"", Formula_instructionNames [parse [programPointer]. symbol],
+		Melder_throw (U"The function \"", Formula_instructionNames [theProgram -> instructions [programPointer]. symbol],
 			U"\" requires two strings, not ", Stackel_whichText (s), U" and ", Stackel_whichText (t), U".");
 	}
 }
@@ -4048,10 +4110,10 @@ static void do_numberOfSelected () {
 	pushNumber (result);
 }
 static int praat_findObjectById (int id) {
-	int IOBJECT;
-	WHERE_DOWN (ID == id)
-		return IOBJECT;
-	Melder_throw (U"No object with number ", id, U".");
+	int IOBJECT = praat_iobjectFromId (id);
+	if (IOBJECT == 0)
+		Melder_throw (U"No object with number ", id, U".");
+	return IOBJECT;
 }
 static int praat_findObjectFromString (const char32 *name) {
 	int IOBJECT;
@@ -4066,6 +4128,9 @@ static int praat_findObjectFromString (const char32 *name) {
 			Melder_throw (U"Missing space in object name \"", name, U"\".");
 		*space = U'\0';
 		char32 *className = & buffer.string [0], *givenName = space + 1;
+		IOBJECT = praat_iobjectFromFullName (name);   // the usual case
+		if (IOBJECT != 0 && str32equ (givenName, OBJECT -> name))
+			return IOBJECT;
 		WHERE_DOWN (1) {
 			Daata object = OBJECT;
 			if (str32equ (className, Thing_className (OBJECT)) && str32equ (givenName, object -> name))
@@ -4209,7 +4274,7 @@ static void do_createDirectory () {
 static void do_variableExists () {
 	Stackel f = pop;
 	if (f->which == Stackel_STRING) {
-		bool result = Interpreter_hasVariable (theInterpreter, f->string) != nullptr;
+		bool result = Interpreter_hasVariable (theProgram -> interpreter, f->string) != nullptr;
 		pushNumber (result);
 	} else {
 		Melder_throw (U"The function \"variableExists\" requires a string, not ", Stackel_whichText (f), U".");
@@ -4355,7 +4420,7 @@ static void do_beginPauseForm () {
 	if (n->number == 1) {
 		Stackel title = pop;
 		if (title->which == Stackel_STRING) {
-			UiPause_begin (theCurrentPraatApplication -> topShell, title->string, theInterpreter);
+			UiPause_begin (theCurrentPraatApplication -> topShell, title->string, theProgram -> interpreter);
 		} else {
 			Melder_throw (U"The function \"beginPauseForm\" requires a string (the title), not ", Stackel_whichText (title), U".");
 		}
@@ -4649,7 +4714,7 @@ static void do_endPauseForm () {
 		! co [5] ? nullptr : co[5]->string, ! co [6] ? nullptr : co[6]->string,
 		! co [7] ? nullptr : co[7]->string, ! co [8] ? nullptr : co[8]->string,
 		! co [9] ? nullptr : co[9]->string, ! co [10] ? nullptr : co[10]->string,
-		theInterpreter);
+		theProgram -> interpreter);
 	//Melder_casual (U"Button ", buttonClicked);
 	pushNumber (buttonClicked);
 }
@@ -4733,7 +4798,7 @@ static void do_demoWaitForInput () {
 	Stackel n = pop;
 	if (n->number != 0)
 		Melder_throw (U"The function \"demoWaitForInput\" requires 0 arguments, not ", n->number, U".");
-	Demo_waitForInput (theInterpreter);
+	Demo_waitForInput (theProgram -> interpreter);
 	pushNumber (1);
 }
 static void do_demoInput () {
@@ -4860,7 +4925,7 @@ static long Stackel_getColumnNumber (Stackel column, Daata thee) {
 	return result;
 }
 static void do_self0 (long irow, long icol) {
-	Daata me = theSource;
+	Daata me = theProgram -> source;
 	if (! me) Melder_throw (U"The name \"self\" is restricted to formulas for objects.");
 	if (my v_hasGetCell ()) {
 		pushNumber (my v_getCell ());
@@ -4892,7 +4957,7 @@ static void do_self0 (long irow, long icol) {
 	}
 }
 static void do_selfStr0 (long irow, long icol) {
-	Daata me = theSource;
+	Daata me = theProgram -> source;
 	if (! me) Melder_throw (U"The name \"self$\" is restricted to formulas for objects.");
 	if (my v_hasGetCellStr ()) {
 		autostring32 result = Melder_dup (my v_getCellStr ());
@@ -4929,17 +4994,14 @@ static void do_selfStr0 (long irow, long icol) {
 static Daata getObjectFromUniqueID (Stackel object) {
 	Daata thee = nullptr;
 	if (object->which == Stackel_NUMBER) {
-		int i = theCurrentPraatObjects -> n;
-		while (i > 0 && object->number != theCurrentPraatObjects -> list [i]. id)
-			i --;
+		long id = lround (object->number);
+		int i = id == object->number ? praat_iobjectFromId (id) : 0;
 		if (i == 0) {
 			Melder_throw (U"No such object: ", object->number);
 		}
 		thee = (Daata) theCurrentPraatObjects -> list [i]. object;
 	} else if (object->which == Stackel_STRING) {
-		int i = theCurrentPraatObjects -> n;
-		while (i > 0 && ! Melder_equ (object->string, theCurrentPraatObjects -> list [i]. name))
-			i --;
+		int i = praat_iobjectFromFullName (object->string);
 		if (i == 0) {
 			Melder_throw (U"No such object: ", object->string);
 		}
@@ -4980,7 +5042,7 @@ static void do_objectCell0 (long irow, long icol) {
 	}
 }
 static void do_matriks0 (long irow, long icol) {
-	Daata thee = parse [programPointer]. content.object;
+	Daata thee = theProgram -> instructions [programPointer]. content.object;
 	if (thy v_hasGetCell ()) {
 		pushNumber (thy v_getCell ());
 	} else if (thy v_hasGetVector ()) {
@@ -5010,7 +5072,7 @@ static void do_matriks0 (long irow, long icol) {
 	}
 }
 static void do_selfMatriks1 (long irow) {
-	Daata me = theSource;
+	Daata me = theProgram -> source;
 	Stackel column = pop;
 	if (! me) Melder_throw (U"The name \"self\" is restricted to formulas for objects.");
 	long icol = Stackel_getColumnNumber (column, me);
@@ -5029,7 +5091,7 @@ static void do_selfMatriks1 (long irow) {
 	}
 }
 static void do_selfMatriksStr1 (long irow) {
-	Daata me = theSource;
+	Daata me = theProgram -> source;
 	Stackel column = pop;
 	if (! me) Melder_throw (U"The name \"self$\" is restricted to formulas for objects.");
 	long icol = Stackel_getColumnNumber (column, me);
@@ -5068,7 +5130,7 @@ static void do_objectCell1 (long irow) {
 	}
 }
 static void do_matriks1 (long irow) {
-	Daata thee = parse [programPointer]. content.object;
+	Daata thee = theProgram -> instructions [programPointer]. content.object;
 	Stackel column = pop;
 	long icol = Stackel_getColumnNumber (column, thee);
 	if (thy v_hasGetVector ()) {
@@ -5106,7 +5168,7 @@ static void do_objectCellStr1 (long irow) {
 	}
 }
 static void do_matrixStr1 (long irow) {
-	Daata thee = parse [programPointer]. content.object;
+	Daata thee = theProgram -> instructions [programPointer]. content.object;
 	Stackel column = pop;
 	long icol = Stackel_getColumnNumber (column, thee);
 	if (thy v_hasGetVectorStr ()) {
@@ -5126,7 +5188,7 @@ static void do_matrixStr1 (long irow) {
 	}
 }
 static void do_selfMatriks2 () {
-	Daata me = theSource;
+	Daata me = theProgram -> source;
 	Stackel column = pop, row = pop;
 	if (! me) Melder_throw (U"The name \"self\" is restricted to formulas for objects.");
 	long irow = Stackel_getRowNumber (row, me);
@@ -5136,7 +5198,7 @@ static void do_selfMatriks2 () {
 	pushNumber (my v_getMatrix (irow, icol));
 }
 static void do_selfMatriksStr2 () {
-	Daata me = theSource;
+	Daata me = theProgram -> source;
 	Stackel column = pop, row = pop;
 	if (! me) Melder_throw (U"The name \"self$\" is restricted to formulas for objects.");
 	long irow = Stackel_getRowNumber (row, me);
@@ -5156,7 +5218,7 @@ static void do_objectCell2 () {
 	pushNumber (thy v_getMatrix (irow, icol));
 }
 static void do_matriks2 () {
-	Daata thee = parse [programPointer]. content.object;
+	Daata thee = theProgram -> instructions [programPointer]. content.object;
 	Stackel column = pop, row = pop;
 	long irow = Stackel_getRowNumber (row, thee);
 	long icol = Stackel_getColumnNumber (column, thee);
@@ -5175,7 +5237,7 @@ static void do_objectCellStr2 () {
 	pushString (result.transfer());
 }
 static void do_matriksStr2 () {
-	Daata thee = parse [programPointer]. content.object;
+	Daata thee = theProgram -> instructions [programPointer]. content.object;
 	Stackel column = pop, row = pop;
 	long irow = Stackel_getRowNumber (row, thee);
 	long icol = Stackel_getColumnNumber (column, thee);
@@ -5189,7 +5251,7 @@ static void do_objectLocation0 (long irow, long icol) {
 	if (thy v_hasGetFunction0 ()) {
 		pushNumber (thy v_getFunction0 ());
 	} else if (thy v_hasGetFunction1 ()) {
-		Daata me = theSource;
+		Daata me = theProgram -> source;
 		if (! me)
 			Melder_throw (U"No current object (we are not in a Formula command),\n"
 				U"hence no implicit x value for this ", Thing_className (thee), U" object.\n"
@@ -5202,7 +5264,7 @@ static void do_objectLocation0 (long irow, long icol) {
 		double x = my v_getX (icol);
 		pushNumber (thy v_getFunction1 (irow, x));
 	} else if (thy v_hasGetFunction2 ()) {
-		Daata me = theSource;
+		Daata me = theProgram -> source;
 		if (! me)
 			Melder_throw (U"No current object (we are not in a Formula command),\n"
 				U"hence no implicit x or y values for this ", Thing_className (thee), U" object.\n"
@@ -5223,11 +5285,11 @@ static void do_objectLocation0 (long irow, long icol) {
 	}
 }
 static void do_funktie0 (long irow, long icol) {
-	Daata thee = parse [programPointer]. content.object;
+	Daata thee = theProgram -> instructions [programPointer]. content.object;
 	if (thy v_hasGetFunction0 ()) {
 		pushNumber (thy v_getFunction0 ());
 	} else if (thy v_hasGetFunction1 ()) {
-		Daata me = theSource;
+		Daata me = theProgram -> source;
 		if (!me)
 			Melder_throw (U"No current object (we are not in a Formula command),\n"
 				U"hence no implicit x value for this ", Thing_className (thee), U" object.\n"
@@ -5240,7 +5302,7 @@ static void do_funktie0 (long irow, long icol) {
 		double x = my v_getX (icol);
 		pushNumber (thy v_getFunction1 (irow, x));
 	} else if (thy v_hasGetFunction2 ()) {
-		Daata me = theSource;
+		Daata me = theProgram -> source;
 		if (! me)
 			Melder_throw (U"No current object (we are not in a Formula command),\n"
 				U"hence no implicit x or y values for this ", Thing_className (thee), U" object.\n"
@@ -5261,7 +5323,7 @@ static void do_funktie0 (long irow, long icol) {
 	}
 }
 static void do_selfFunktie1 (long irow) {
-	Daata me = theSource;
+	Daata me = theProgram -> source;
 	Stackel x = pop;
 	if (x->which == Stackel_NUMBER) {
 		if (! me) Melder_throw (U"The name \"self\" is restricted to formulas for objects.");
@@ -5287,7 +5349,7 @@ static void do_objectLocation1 (long irow) {
 		if (thy v_hasGetFunction1 ()) {
 			pushNumber (thy v_getFunction1 (irow, x->number));
 		} else if (thy v_hasGetFunction2 ()) {
-			Daata me = theSource;
+			Daata me = theProgram -> source;
 			if (! me)
 				Melder_throw (U"No current object (we are not in a Formula command),\n"
 					U"hence no implicit y value for this ", Thing_className (thee), U" object.\n"
@@ -5306,13 +5368,13 @@ static void do_objectLocation1 (long irow) {
 	}
 }
 static void do_funktie1 (long irow) {
-	Daata thee = parse [programPointer]. content.object;
+	Daata thee = theProgram -> instructions [programPointer]. content.object;
 	Stackel x = pop;
 	if (x->which == Stackel_NUMBER) {
 		if (thy v_hasGetFunction1 ()) {
 			pushNumber (thy v_getFunction1 (irow, x->number));
 		} else if (thy v_hasGetFunction2 ()) {
-			Daata me = theSource;
+			Daata me = theProgram -> source;
 			if (! me)
 				Melder_throw (U"No current object (we are not in a Formula command),\n"
 					U"hence no implicit y value for this ", Thing_className (thee), U" object.\n"
@@ -5331,7 +5393,7 @@ static void do_funktie1 (long irow) {
 	}
 }
 static void do_selfFunktie2 () {
-	Daata me = theSource;
+	Daata me = theProgram -> source;
 	Stackel y = pop, x = pop;
 	if (x->which == Stackel_NUMBER && y->which == Stackel_NUMBER) {
 		if (! me) Melder_throw (U"The name \"self\" is restricted to formulas for objects.");
@@ -5354,7 +5416,7 @@ static void do_objectLocation2 () {
 	}
 }
 static void do_funktie2 () {
-	Daata thee = parse [programPointer]. content.object;
+	Daata thee = theProgram -> instructions [programPointer]. content.object;
 	Stackel y = pop, x = pop;
 	if (x->which == Stackel_NUMBER && y->which == Stackel_NUMBER) {
 		if (! thy v_hasGetFunction2 ())
@@ -5365,7 +5427,7 @@ static void do_funktie2 () {
 	}
 }
 static void do_rowStr () {
-	Daata thee = parse [programPointer]. content.object;
+	Daata thee = theProgram -> instructions [programPointer]. content.object;
 	Stackel row = pop;
 	long irow = Stackel_getRowNumber (row, thee);
 	autostring32 result = Melder_dup (thy v_getRowStr (irow));
@@ -5374,7 +5436,7 @@ static void do_rowStr () {
 	pushString (result.transfer());
 }
 static void do_colStr () {
-	Daata thee = parse [programPointer]. content.object;
+	Daata thee = theProgram -> instructions [programPointer]. content.object;
 	Stackel col = pop;
 	long icol = Stackel_getColumnNumber (col, thee);
 	autostring32 result = Melder_dup (thy v_getColStr (icol));
@@ -5396,15 +5458,12 @@ static double NUMerf (double x) {
 	return 1.0 - NUMerfcc (x);
 }
 
-void Formula_run (long row, long col, struct Formula_Result *result) {
-	FormulaInstruction f = parse;
+static void Formula_runProgram (long row, long col, struct Formula_Result *result) {
+	FormulaInstruction f = theProgram -> instructions;
 	programPointer = 1;   // first symbol of the program
-	if (! theStack) theStack = Melder_calloc_f (struct structStackel, 10000);
-	if (! theStack)
-		Melder_throw (U"Out of memory during formula computation.");
 	w = 0, wmax = 0;   // start new stack
 	try {
-		while (programPointer <= numberOfInstructions) {
+		while (programPointer <= theProgram -> numberOfInstructions) {
 			int symbol;
 				switch (symbol = f [programPointer]. symbol) {
 
@@ -5413,11 +5472,11 @@ case NUMBER_: { pushNumber (f [programPointer]. content.number);
 } break; case ROW_: { pushNumber (row);
 } break; case COL_: { pushNumber (col);
 } break; case X_: {
-	Daata me = theSource;
+	Daata me = theProgram -> source;
 	if (! my v_hasGetX ()) Melder_throw (U"No values for \"x\" for this object.");
 	pushNumber (my v_getX (col));
 } break; case Y_: {
-	Daata me = theSource;
+	Daata me = theProgram -> source;
 	if (! my v_hasGetY ()) Melder_throw (U"No values for \"y\" for this object.");
 	pushNumber (my v_getY (row));
 } break; case NOT_: { do_not ();
@@ -5638,7 +5697,7 @@ case NUMBER_: { pushNumber (f [programPointer]. content.number);
 		if (condition->number != 0.0) {
 /* Possible compiler BUG: some compilers cannot handle the following assignment. */
 /* Those compilers will have trouble with praat's AND and OR. */
-			programPointer = f [programPointer]. content.label - theOptimize;
+			programPointer = f [programPointer]. content.label - theProgram -> optimize;
 		}
 	} else {
 		Melder_throw (U"A condition between \"if\" and \"then\" has to be a number, not ", Stackel_whichText (condition), U".");
@@ -5647,13 +5706,13 @@ case NUMBER_: { pushNumber (f [programPointer]. content.number);
 	Stackel condition = pop;
 	if (condition->which == Stackel_NUMBER) {
 		if (condition->number == 0.0) {
-			programPointer = f [programPointer]. content.label - theOptimize;
+			programPointer = f [programPointer]. content.label - theProgram -> optimize;
 		}
 	} else {
 		Melder_throw (U"A condition between \"if\" and \"then\" has to be a number, not ", Stackel_whichText (condition), U".");
 	}
 } break; case GOTO_: {
-	programPointer = f [programPointer]. content.label - theOptimize;
+	programPointer = f [programPointer]. content.label - theProgram -> optimize;
 } break; case LABEL_: {
 	;
 } break; case DECREMENT_AND_ASSIGN_: {
@@ -5673,7 +5732,7 @@ case NUMBER_: { pushNumber (f [programPointer]. content.number);
 	//Melder_casual (U"loop variable ", var -> numericValue);
 	//Melder_casual (U"end value ", e->number);
 	if (var -> numericValue > e->number) {
-		programPointer = f [programPointer]. content.label - theOptimize;
+		programPointer = f [programPointer]. content.label - theProgram -> optimize;
 	}
 } break; case ADD_3DOWN_: {
 	Stackel x = pop, s = & theStack [w - 2];
@@ -5739,18 +5798,18 @@ case NUMBER_: { pushNumber (f [programPointer]. content.number);
 	InterpreterVariable var = f [programPointer]. content.variable;
 	autostring32 string = Melder_dup (var -> stringValue);
 	pushString (string.transfer());
-} break; default: Melder_throw (U"Symbol \"", Formula_instructionNames [parse [programPointer]. symbol], U"\" without action.");
+} break; default: Melder_throw (U"Symbol \"", Formula_instructionNames [theProgram -> instructions [programPointer]. symbol], U"\" without action.");
 			} // endswitch
 			programPointer ++;
 		} // endwhile
 		if (w != 1) Melder_fatal (U"Formula: stackpointer ends at ", w, U" instead of 1.");
-		if (theExpressionType [theLevel] == kFormula_EXPRESSION_TYPE_NUMERIC) {
+		if (theProgram -> expressionType == kFormula_EXPRESSION_TYPE_NUMERIC) {
 			if (theStack [1]. which == Stackel_STRING) Melder_throw (U"Found a string expression instead of a numeric expression.");
 			if (theStack [1]. which == Stackel_NUMERIC_VECTOR) Melder_throw (U"Found a vector expression instead of a numeric expression.");
 			if (theStack [1]. which == Stackel_NUMERIC_MATRIX) Melder_throw (U"Found a matrix expression instead of a numeric expression.");
 			result -> expressionType = kFormula_EXPRESSION_TYPE_NUMERIC;
 			result -> result.numericResult = theStack [1]. number;
-		} else if (theExpressionType [theLevel] == kFormula_EXPRESSION_TYPE_STRING) {
+		} else if (theProgram -> expressionType == kFormula_EXPRESSION_TYPE_STRING) {
 			if (theStack [1]. which == Stackel_NUMBER)
 				Melder_throw (U"Found a numeric expression (value ", theStack [1]. number, U") instead of a string expression.");
 			if (theStack [1]. which == Stackel_NUMERIC_VECTOR) Melder_throw (U"Found a vector expression instead of a string expression.");
@@ -5758,14 +5817,14 @@ case NUMBER_: { pushNumber (f [programPointer]. content.number);
 			result -> expressionType = kFormula_EXPRESSION_TYPE_STRING;
 			result -> result.stringResult = theStack [1]. string;   // dangle...
 			theStack [1]. string = nullptr;   // ...undangle (and disown)
-		} else if (theExpressionType [theLevel] == kFormula_EXPRESSION_TYPE_NUMERIC_VECTOR) {
+		} else if (theProgram -> expressionType == kFormula_EXPRESSION_TYPE_NUMERIC_VECTOR) {
 			if (theStack [1]. which == Stackel_NUMBER) Melder_throw (U"Found a numeric expression instead of a vector expression.");
 			if (theStack [1]. which == Stackel_STRING) Melder_throw (U"Found a string expression instead of a vector expression.");
 			if (theStack [1]. which == Stackel_NUMERIC_MATRIX) Melder_throw (U"Found a matrix expression instead of a vector expression.");
 			result -> expressionType = kFormula_EXPRESSION_TYPE_NUMERIC_VECTOR;
 			result -> result.numericVectorResult = theStack [1]. numericVector;   // dangle
 			theStack [1]. numericVector = theZeroNumericVector;   // ...undangle (and disown)
-		} else if (theExpressionType [theLevel] == kFormula_EXPRESSION_TYPE_NUMERIC_MATRIX) {
+		} else if (theProgram -> expressionType == kFormula_EXPRESSION_TYPE_NUMERIC_MATRIX) {
 			if (theStack [1]. which == Stackel_NUMBER) Melder_throw (U"Found a numeric expression instead of a matrix expression.");
 			if (theStack [1]. which == Stackel_STRING) Melder_throw (U"Found a string expression instead of a matrix expression.");
 			if (theStack [1]. which == Stackel_NUMERIC_VECTOR) Melder_throw (U"Found a vector expression instead of a matrix expression.");
@@ -5773,7 +5832,7 @@ case NUMBER_: { pushNumber (f [programPointer]. content.number);
 			result -> result.numericMatrixResult = theStack [1]. numericMatrix;   // dangle
 			theStack [1]. numericMatrix = theZeroNumericMatrix;   // ...undangle (and disown)
 		} else {
-			Melder_assert (theExpressionType [theLevel] == kFormula_EXPRESSION_TYPE_UNKNOWN);
+			Melder_assert (theProgram -> expressionType == kFormula_EXPRESSION_TYPE_UNKNOWN);
 			if (theStack [1]. which == Stackel_NUMBER) {
 				result -> expressionType = kFormula_EXPRESSION_TYPE_NUMERIC;
 				result -> result.numericResult = theStack [1]. number;
@@ -5807,4 +5866,388 @@ case NUMBER_: { pushNumber (f [programPointer]. content.number);
 	}
 }
 
+void FormulaProgram_run (FormulaProgram me, long row, long col, struct Formula_Result *result) {
+	if (! theStackBottom) {
+		theStackMemory.resize (1 + Formula_STACK_SIZE);   // zeroed, i.e. all numbers
+		theStackBottom = & theStackMemory [0];
+	}
+	FormulaProgram savedProgram = theProgram;
+	Stackel savedStack = theStack;
+	int savedProgramPointer = programPointer, savedW = w, savedWmax = wmax;
+	Stackel stack = savedProgram ? savedStack + savedWmax : theStackBottom;
+	if (stack - theStackBottom > Formula_STACK_SIZE / 2)
+		Melder_throw (U"Formulas nested too deeply.");
+	theProgram = me;
+	theStack = stack;
+	try {
+		Formula_runProgram (row, col, result);
+	} catch (MelderError) {
+		theProgram = savedProgram, theStack = savedStack, programPointer = savedProgramPointer, w = savedW, wmax = savedWmax;
+		throw;
+	}
+	theProgram = savedProgram, theStack = savedStack, programPointer = savedProgramPointer, w = savedW, wmax = savedWmax;
+}
+
+void Formula_run (long row, long col, struct Formula_Result *result) {
+	/*
+		While the program runs, it could compile another formula (e.g. with "do" or "runScript");
+		we keep the program alive during that time, and make it the current program again afterwards.
+	*/
+	autoFormulaProgram program = theCompiledProgram.move();
+	try {
+		FormulaProgram_run (program.get(), row, col, result);
+	} catch (MelderError) {
+		theCompiledProgram = program.move();
+		throw;
+	}
+	theCompiledProgram = program.move();
+}
+
+bool FormulaProgram_isThreadSafe (FormulaProgram me) {
+	if (my expressionType != kFormula_EXPRESSION_TYPE_NUMERIC) return false;
+	for (int i = 1; i <= my numberOfInstructions; i ++) {
+		int symbol = my instructions [i]. symbol;
+		switch (symbol) {
+			case NUMBER_: case ROW_: case COL_: case X_: case Y_: case SELF0_: case NUMERIC_VARIABLE_:
+			case NOT_: case EQ_: case NE_: case LE_: case LT_: case GE_: case GT_:
+			case ADD_: case SUB_: case MUL_: case RDIV_: case IDIV_: case MOD_: case MINUS_: case POWER_: case SQR_:
+			case ABS_: case ROUND_: case FLOOR_: case CEILING_: case RECTIFY_:
+			case SQRT_: case SIN_: case COS_: case TAN_: case ARCSIN_: case ARCCOS_: case ARCTAN_: case SINC_: case SINCPI_:
+			case EXP_: case SINH_: case COSH_: case TANH_: case ARCSINH_: case ARCCOSH_: case ARCTANH_:
+			case SIGMOID_: case INV_SIGMOID_: case ERF_: case ERFC_: case GAUSS_P_: case GAUSS_Q_: case INV_GAUSS_Q_:
+			case LOG2_: case LN_: case LOG10_: case LN_GAMMA_:
+			case HERTZ_TO_BARK_: case BARK_TO_HERTZ_: case PHON_TO_DIFFERENCE_LIMENS_: case DIFFERENCE_LIMENS_TO_PHON_:
+			case HERTZ_TO_MEL_: case MEL_TO_HERTZ_: case HERTZ_TO_SEMITONES_: case SEMITONES_TO_HERTZ_:
+			case ERB_: case HERTZ_TO_ERB_: case ERB_TO_HERTZ_:
+			case ARCTAN2_: case CHI_SQUARE_P_: case CHI_SQUARE_Q_: case INCOMPLETE_GAMMAP_:
+			case STUDENT_P_: case STUDENT_Q_: case BETA_: case BETA2_: case BESSEL_I_: case BESSEL_K_:
+			case LN_BETA_: case SOUND_PRESSURE_TO_PHON_:
+			case FISHER_P_: case FISHER_Q_: case BINOMIAL_P_: case BINOMIAL_Q_:
+			case INCOMPLETE_BETA_:
+			case MIN_: case MAX_: case IMIN_: case IMAX_:
+			case TRUE_: case FALSE_: case IFTRUE_: case IFFALSE_: case GOTO_: case LABEL_: case END_:
+				break;
+			/*
+				Not the inverses invChiSquareQ, invStudentQ, invFisherQ and invBinomialP/Q:
+				they search with NUMridders, which can call Melder_warning.
+			*/
+			default:
+				return false;
+		}
+	}
+	return true;
+}
+
+/*
+	Running a program on a stretch of a row.
+	Instead of going through the whole program for every cell, we go through it once for a block of cells,
+	and perform every instruction on all the cells of the block.
+	An element of this "row stack" is either a single number (constants, variables, row, y)
+	or a block of numbers (col, x, self, and everything computed from them);
+	each element owns a buffer for a block, so that the result of an instruction can replace its first argument.
+	The arithmetic is exactly that of the corresponding do_ functions above, including the treatment of undefined values.
+*/
+#define Formula_ROW_BLOCK_SIZE  256
+
+struct RowStackel {
+	bool isBlock;
+	double number;
+	double *block;   // Formula_ROW_BLOCK_SIZE numbers
+};
+
+static thread_local std::vector <double> theRowStackMemory;
+static thread_local std::vector <struct RowStackel> theRowStack;
+
+typedef double (*Formula_function1) (double);
+typedef double (*Formula_function2) (double, double);
+typedef double (*Formula_function3) (double, double, double);
+
+static Formula_function1 FormulaInstruction_function1 (int symbol) {
+	switch (symbol) {
+		case SINC_: return NUMsinc;
+		case SINCPI_: return NUMsincpi;
+		case ARCSINH_: return NUMarcsinh;
+		case ARCCOSH_: return NUMarccosh;
+		case ARCTANH_: return NUMarctanh;
+		case SIGMOID_: return NUMsigmoid;
+		case INV_SIGMOID_: return NUMinvSigmoid;
+		case ERF_: return NUMerf;
+		case ERFC_: return NUMerfcc;
+		case GAUSS_P_: return NUMgaussP;
+		case GAUSS_Q_: return NUMgaussQ;
+		case INV_GAUSS_Q_: return NUMinvGaussQ;
+		case LN_GAMMA_: return NUMlnGamma;
+		case HERTZ_TO_BARK_: return NUMhertzToBark;
+		case BARK_TO_HERTZ_: return NUMbarkToHertz;
+		case PHON_TO_DIFFERENCE_LIMENS_: return NUMphonToDifferenceLimens;
+		case DIFFERENCE_LIMENS_TO_PHON_: return NUMdifferenceLimensToPhon;
+		case HERTZ_TO_MEL_: return NUMhertzToMel;
+		case MEL_TO_HERTZ_: return NUMmelToHertz;
+		case HERTZ_TO_SEMITONES_: return NUMhertzToSemitones;
+		case SEMITONES_TO_HERTZ_: return NUMsemitonesToHertz;
+		case ERB_: return NUMerb;
+		case HERTZ_TO_ERB_: return NUMhertzToErb;
+		case ERB_TO_HERTZ_: return NUMerbToHertz;
+		default: return nullptr;
+	}
+}
+
+static Formula_function2 FormulaInstruction_function2 (int symbol) {
+	switch (symbol) {
+		case ARCTAN2_: return atan2;
+		case CHI_SQUARE_P_: return NUMchiSquareP;
+		case CHI_SQUARE_Q_: return NUMchiSquareQ;
+		case INCOMPLETE_GAMMAP_: return NUMincompleteGammaP;
+		case INV_CHI_SQUARE_Q_: return NUMinvChiSquareQ;
+		case STUDENT_P_: return NUMstudentP;
+		case STUDENT_Q_: return NUMstudentQ;
+		case INV_STUDENT_Q_: return NUMinvStudentQ;
+		case BETA_: return NUMbeta;
+		case BETA2_: return NUMbeta2;
+		case LN_BETA_: return NUMlnBeta;
+		case SOUND_PRESSURE_TO_PHON_: return NUMsoundPressureToPhon;
+		default: return nullptr;
+	}
+}
+
+static Formula_function3 FormulaInstruction_function3 (int symbol) {
+	switch (symbol) {
+		case FISHER_P_: return NUMfisherP;
+		case FISHER_Q_: return NUMfisherQ;
+		case INV_FISHER_Q_: return NUMinvFisherQ;
+		case BINOMIAL_P_: return NUMbinomialP;
+		case BINOMIAL_Q_: return NUMbinomialQ;
+		case INCOMPLETE_BETA_: return NUMincompleteBeta;
+		case INV_BINOMIAL_P_: return NUMinvBinomialP;
+		case INV_BINOMIAL_Q_: return NUMinvBinomialQ;
+		default: return nullptr;
+	}
+}
+
+bool FormulaProgram_canRunOnRows (FormulaProgram me) {
+	if (my expressionType != kFormula_EXPRESSION_TYPE_NUMERIC) return false;
+	Daata source = my source;
+	int depth = 0;
+	for (int i = 1; i <= my numberOfInstructions; i ++) {
+		int symbol = my instructions [i]. symbol;
+		switch (symbol) {
+			case NUMBER_: case ROW_: case COL_: case NUMERIC_VARIABLE_:
+				depth ++;
+				break;
+			case X_:
+				if (! source || ! source -> v_hasGetX ()) return false;   // let the interpreter complain
+				depth ++;
+				break;
+			case Y_:
+				if (! source || ! source -> v_hasGetY ()) return false;
+				depth ++;
+				break;
+			case SELF0_:
+				if (! source || ! (source -> v_hasGetCell () || source -> v_hasGetVector () || source -> v_hasGetMatrix ())) return false;
+				depth ++;
+				break;
+			case NOT_: case MINUS_: case SQR_: case ABS_: case ROUND_: case FLOOR_: case CEILING_: case RECTIFY_:
+			case SQRT_: case SIN_: case COS_: case TAN_: case ARCSIN_: case ARCCOS_: case ARCTAN_:
+			case EXP_: case SINH_: case COSH_: case TANH_: case LOG2_: case LN_: case LOG10_:
+				if (depth < 1) return false;
+				break;
+			case EQ_: case NE_: case LE_: case LT_: case GE_: case GT_:
+			case ADD_: case SUB_: case MUL_: case RDIV_: case IDIV_: case MOD_: case POWER_:
+				if (depth < 2) return false;
+				depth --;
+				break;
+			case INV_CHI_SQUARE_Q_: case INV_STUDENT_Q_: case INV_FISHER_Q_: case INV_BINOMIAL_P_: case INV_BINOMIAL_Q_:
+				return false;   // these search with NUMridders, which can issue warnings; keep them to the cell-by-cell interpreter
+			default:
+				if (FormulaInstruction_function1 (symbol)) {
+					if (depth < 1) return false;
+				} else if (FormulaInstruction_function2 (symbol)) {
+					if (depth < 2) return false;
+					depth --;
+				} else if (FormulaInstruction_function3 (symbol)) {
+					if (depth < 3) return false;
+					depth -= 2;
+				} else {
+					return false;   // control flow, side effects, random numbers, strings, vectors, other objects...
+				}
+		}
+	}
+	return depth == 1;
+}
+
+template <typename Op>
+static inline void RowStackel_apply1 (struct RowStackel *x, long n, Op op) {
+	if (x -> isBlock) {
+		double *block = x -> block;
+		for (long i = 0; i < n; i ++)
+			block [i] = op (block [i]);
+	} else {
+		x -> number = op (x -> number);
+	}
+}
+
+template <typename Op>
+static inline void RowStackel_apply2 (struct RowStackel *x, const struct RowStackel *y, long n, Op op) {
+	double *block = x -> block;
+	if (x -> isBlock) {
+		if (y -> isBlock) {
+			const double *yblock = y -> block;
+			for (long i = 0; i < n; i ++)
+				block [i] = op (block [i], yblock [i]);
+		} else {
+			const double yvalue = y -> number;
+			for (long i = 0; i < n; i ++)
+				block [i] = op (block [i], yvalue);
+		}
+	} else if (y -> isBlock) {
+		const double xvalue = x -> number, *yblock = y -> block;
+		for (long i = 0; i < n; i ++)
+			block [i] = op (xvalue, yblock [i]);
+		x -> isBlock = true;
+	} else {
+		x -> number = op (x -> number, y -> number);
+	}
+}
+
+static inline double RowStackel_get (const struct RowStackel *x, long i) {
+	return x -> isBlock ? x -> block [i] : x -> number;
+}
+
+static void FormulaProgram_runOnBlock (FormulaProgram me, long row, long firstColumn, long n, struct RowStackel *stack) {
+	Daata source = my source;
+	int depth = 0;
+	for (int i = 1; i <= my numberOfInstructions; i ++) {
+		const struct structFormulaInstruction *instruction = & my instructions [i];
+		int symbol = instruction -> symbol;
+		struct RowStackel *x = depth > 0 ? & stack [depth - 1] : nullptr, *y;   // the argument of a function of one variable
+		switch (symbol) {
+			case NUMBER_: case ROW_: case Y_: case NUMERIC_VARIABLE_: {
+				struct RowStackel *top = & stack [depth ++];
+				top -> isBlock = false;
+				top -> number =
+					symbol == NUMBER_ ? instruction -> content.number :
+					symbol == ROW_ ? row :
+					symbol == Y_ ? source -> v_getY (row) :
+					instruction -> content.variable -> numericValue;
+			} break;
+			case COL_: case X_: case SELF0_: {
+				struct RowStackel *top = & stack [depth ++];
+				double *block = top -> block;
+				if (symbol == SELF0_ && source -> v_hasGetCell ()) {
+					top -> isBlock = false;
+					top -> number = source -> v_getCell ();
+					break;
+				}
+				top -> isBlock = true;
+				if (symbol == COL_) {
+					for (long j = 0; j < n; j ++) block [j] = firstColumn + j;
+				} else if (symbol == X_) {
+					for (long j = 0; j < n; j ++) block [j] = source -> v_getX (firstColumn + j);
+				} else if (source -> v_hasGetVector ()) {
+					for (long j = 0; j < n; j ++) block [j] = source -> v_getVector (row, firstColumn + j);
+				} else {
+					for (long j = 0; j < n; j ++) block [j] = source -> v_getMatrix (row, firstColumn + j);
+				}
+			} break;
+			case NOT_: RowStackel_apply1 (x, n, [] (double a) { return a == NUMundefined ? NUMundefined : a == 0.0 ? 1.0 : 0.0; }); break;
+			case MINUS_: RowStackel_apply1 (x, n, [] (double a) { return a == NUMundefined ? NUMundefined : - a; }); break;
+			case SQR_: RowStackel_apply1 (x, n, [] (double a) { return a == NUMundefined ? NUMundefined : a * a; }); break;
+			case ABS_: RowStackel_apply1 (x, n, [] (double a) { return a == NUMundefined ? NUMundefined : fabs (a); }); break;
+			case ROUND_: RowStackel_apply1 (x, n, [] (double a) { return a == NUMundefined ? NUMundefined : floor (a + 0.5); }); break;
+			case FLOOR_: RowStackel_apply1 (x, n, [] (double a) { return a == NUMundefined ? NUMundefined : floor (a); }); break;
+			case CEILING_: RowStackel_apply1 (x, n, [] (double a) { return a == NUMundefined ? NUMundefined : ceil (a); }); break;
+			case RECTIFY_: RowStackel_apply1 (x, n, [] (double a) { return a == NUMundefined ? NUMundefined : a > 0.0 ? a : 0.0; }); break;
+			case SQRT_: RowStackel_apply1 (x, n, [] (double a) { return a == NUMundefined ? NUMundefined : a < 0.0 ? NUMundefined : sqrt (a); }); break;
+			case SIN_: RowStackel_apply1 (x, n, [] (double a) { return a == NUMundefined ? NUMundefined : sin (a); }); break;
+			case COS_: RowStackel_apply1 (x, n, [] (double a) { return a == NUMundefined ? NUMundefined : cos (a); }); break;
+			case TAN_: RowStackel_apply1 (x, n, [] (double a) { return a == NUMundefined ? NUMundefined : tan (a); }); break;
+			case ARCSIN_: RowStackel_apply1 (x, n, [] (double a) { return a == NUMundefined ? NUMundefined : fabs (a) > 1.0 ? NUMundefined : asin (a); }); break;
+			case ARCCOS_: RowStackel_apply1 (x, n, [] (double a) { return a == NUMundefined ? NUMundefined : fabs (a) > 1.0 ? NUMundefined : acos (a); }); break;
+			case ARCTAN_: RowStackel_apply1 (x, n, [] (double a) { return a == NUMundefined ? NUMundefined : atan (a); }); break;
+			case EXP_: RowStackel_apply1 (x, n, [] (double a) { return a == NUMundefined ? NUMundefined : exp (a); }); break;
+			case SINH_: RowStackel_apply1 (x, n, [] (double a) { return a == NUMundefined ? NUMundefined : sinh (a); }); break;
+			case COSH_: RowStackel_apply1 (x, n, [] (double a) { return a == NUMundefined ? NUMundefined : cosh (a); }); break;
+			case TANH_: RowStackel_apply1 (x, n, [] (double a) { return a == NUMundefined ? NUMundefined : tanh (a); }); break;
+			case LOG2_: RowStackel_apply1 (x, n, [] (double a) { return a == NUMundefined ? NUMundefined : a <= 0.0 ? NUMundefined : log (a) * NUMlog2e; }); break;
+			case LN_: RowStackel_apply1 (x, n, [] (double a) { return a == NUMundefined ? NUMundefined : a <= 0.0 ? NUMundefined : log (a); }); break;
+			case LOG10_: RowStackel_apply1 (x, n, [] (double a) { return a == NUMundefined ? NUMundefined : a <= 0.0 ? NUMundefined : log10 (a); }); break;
+			case EQ_: case NE_: case LE_: case LT_: case GE_: case GT_:
+			case ADD_: case SUB_: case MUL_: case RDIV_: case IDIV_: case MOD_: case POWER_: {
+				x = & stack [depth - 2], y = & stack [depth - 1];
+				switch (symbol) {
+					case EQ_: RowStackel_apply2 (x, y, n, [] (double a, double b) { return a == b ? 1.0 : 0.0; }); break;   // even if undefined
+					case NE_: RowStackel_apply2 (x, y, n, [] (double a, double b) { return a != b ? 1.0 : 0.0; }); break;
+					case LE_: RowStackel_apply2 (x, y, n, [] (double a, double b) { return a == NUMundefined || b == NUMundefined ? NUMundefined : a <= b ? 1.0 : 0.0; }); break;
+					case LT_: RowStackel_apply2 (x, y, n, [] (double a, double b) { return a == NUMundefined || b == NUMundefined ? NUMundefined : a < b ? 1.0 : 0.0; }); break;
+					case GE_: RowStackel_apply2 (x, y, n, [] (double a, double b) { return a == NUMundefined || b == NUMundefined ? NUMundefined : a >= b ? 1.0 : 0.0; }); break;
+					case GT_: RowStackel_apply2 (x, y, n, [] (double a, double b) { return a == NUMundefined || b == NUMundefined ? NUMundefined : a > b ? 1.0 : 0.0; }); break;
+					case ADD_: RowStackel_apply2 (x, y, n, [] (double a, double b) { return a == NUMundefined || b == NUMundefined ? NUMundefined : a + b; }); break;
+					case SUB_: RowStackel_apply2 (x, y, n, [] (double a, double b) { return a == NUMundefined || b == NUMundefined ? NUMundefined : a - b; }); break;
+					case MUL_: RowStackel_apply2 (x, y, n, [] (double a, double b) { return a == NUMundefined || b == NUMundefined ? NUMundefined : a * b; }); break;
+					case RDIV_: RowStackel_apply2 (x, y, n, [] (double a, double b) { return a == NUMundefined || b == NUMundefined || b == 0.0 ? NUMundefined : a / b; }); break;
+					case IDIV_: RowStackel_apply2 (x, y, n, [] (double a, double b) { return a == NUMundefined || b == NUMundefined || b == 0.0 ? NUMundefined : floor (a / b); }); break;
+					case MOD_: RowStackel_apply2 (x, y, n, [] (double a, double b) { return a == NUMundefined || b == NUMundefined || b == 0.0 ? NUMundefined : a - floor (a / b) * b; }); break;
+					case POWER_: RowStackel_apply2 (x, y, n, [] (double a, double b) { return a == NUMundefined || b == NUMundefined ? NUMundefined : pow (a, b); }); break;
+				}
+				depth --;
+			} break;
+			default: {
+				if (Formula_function1 f = FormulaInstruction_function1 (symbol)) {
+					RowStackel_apply1 (x, n, [f] (double a) { return a == NUMundefined ? NUMundefined : f (a); });
+				} else if (Formula_function2 f2 = FormulaInstruction_function2 (symbol)) {
+					x = & stack [depth - 2], y = & stack [depth - 1];
+					RowStackel_apply2 (x, y, n, [f2] (double a, double b) { return a == NUMundefined || b == NUMundefined ? NUMundefined : f2 (a, b); });
+					depth --;
+				} else {
+					Formula_function3 f3 = FormulaInstruction_function3 (symbol);
+					Melder_assert (f3);
+					x = & stack [depth - 3], y = & stack [depth - 2];
+					const struct RowStackel *z = & stack [depth - 1];
+					if (x -> isBlock || y -> isBlock || z -> isBlock) {
+						for (long j = 0; j < n; j ++) {
+							double a = RowStackel_get (x, j), b = RowStackel_get (y, j), c = RowStackel_get (z, j);
+							x -> block [j] = a == NUMundefined || b == NUMundefined || c == NUMundefined ? NUMundefined : f3 (a, b, c);
+						}
+						x -> isBlock = true;
+					} else {
+						double a = x -> number, b = y -> number, c = z -> number;
+						x -> number = a == NUMundefined || b == NUMundefined || c == NUMundefined ? NUMundefined : f3 (a, b, c);
+					}
+					depth -= 2;
+				}
+			}
+		}
+	}
+	Melder_assert (depth == 1);
+}
+
+void FormulaProgram_runOnRow (FormulaProgram me, long row, long firstColumn, long lastColumn, double result []) {
+	/*
+		The stack can never be deeper than the number of instructions.
+	*/
+	long maximumDepth = my numberOfInstructions;
+	if ((long) theRowStack. size () < maximumDepth) {
+		theRowStackMemory. resize (maximumDepth * Formula_ROW_BLOCK_SIZE);
+		theRowStack. resize (maximumDepth);
+	}
+	for (long i = 0; i < maximumDepth; i ++)
+		theRowStack [i]. block = & theRowStackMemory [i * Formula_ROW_BLOCK_SIZE];
+	for (long column = firstColumn; column <= lastColumn; column += Formula_ROW_BLOCK_SIZE) {
+		long n = lastColumn - column + 1;
+		if (n > Formula_ROW_BLOCK_SIZE) n = Formula_ROW_BLOCK_SIZE;
+		struct RowStackel *bottom = & theRowStack [0];
+		FormulaProgram_runOnBlock (me, row, column, n, bottom);
+		/*
+			The cells of this block have all been read (as self) before we write the first result,
+			so the result can go into the matrix that the formula reads.
+		*/
+		double *target = & result [column - firstColumn];
+		if (bottom -> isBlock) {
+			for (long j = 0; j < n; j ++) target [j] = bottom -> block [j];
+		} else {
+			for (long j = 0; j < n; j ++) target [j] = bottom -> number;
+		}
+	}
+}
+
 /* End of file Formula.cpp */
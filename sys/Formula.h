@@ -76,6 +76,52 @@ Thing_declare (Interpreter);
 void Formula_compile (Interpreter interpreter, Daata data, const char32 *expression, int expressionType, bool optimize);
 
 void Formula_run (long row, long col, struct Formula_Result *result);
+/*
+	Runs the formula that was compiled most recently.
+*/
+
+Thing_define (FormulaProgram, Thing) {
+	struct structFormulaInstruction *instructions;   // owned, including their strings
+	int numberOfInstructions, _capacity, expressionType;
+	bool optimize;
+	Daata source;   // not owned
+	Interpreter interpreter;   // not owned
+
+	void v_destroy () noexcept
+		override;
+};
+
+autoFormulaProgram Formula_compileProgram (Interpreter interpreter, Daata data, const char32 *expression, int expressionType, bool optimize);
+/*
+	Compiles the formula into a program that owns its instructions,
+	so that it can be run many times, also after other formulas have been compiled or run.
+	Compilation has to take place in the main thread.
+*/
+
+void FormulaProgram_run (FormulaProgram me, long row, long col, struct Formula_Result *result);
+/*
+	Every thread has its own evaluation stack, so a program can run in several threads at the same time,
+	as long as FormulaProgram_isThreadSafe () says so.
+*/
+
+bool FormulaProgram_isThreadSafe (FormulaProgram me);
+/*
+	Whether the program computes a number only from numbers, numeric variables, x, y, row, col and self (at [row, col]),
+	with arithmetic, comparisons, conditions and functions that have no side effects and do not draw random numbers.
+	Such a program does not change any variable or object.
+*/
+
+bool FormulaProgram_canRunOnRows (FormulaProgram me);
+/*
+	Whether the program is a thread-safe program without conditions, min or max,
+	so that FormulaProgram_runOnRow () can perform each instruction on a whole block of cells at a time.
+*/
+
+void FormulaProgram_runOnRow (FormulaProgram me, long row, long firstColumn, long lastColumn, double result []);
+/*
+	Puts into result [0 .. lastColumn - firstColumn] the values that FormulaProgram_run () would give
+	for the cells [row, firstColumn .. lastColumn]. The result may overwrite the cells that the program reads as self.
+*/
 
 /* End of file Formula.h */
 #endif
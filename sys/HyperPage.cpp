@@ -596,6 +596,7 @@ void structHyperPage :: v_destroy () noexcept {
 			Melder_free (((PraatObjects) our praatObjects) -> list [iobject]. name);
 			forget (((PraatObjects) our praatObjects) -> list [iobject]. object);
 		}
+		praat_deleteObjectTable ((PraatObjects) our praatObjects);
 		Melder_free (our praatApplication);
 		Melder_free (our praatObjects);
 		Melder_free (our praatPicture);
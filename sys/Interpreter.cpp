@@ -24,6 +24,7 @@ extern structMelderDir praatDir;
 #include "Formula.h"
 #include "praat_version.h"
 #include "UnicodeData.h"
+#include <vector>
 
 #define Interpreter_WORD 1
 #define Interpreter_REAL 2
@@ -690,10 +691,77 @@ static void parameterToVariable (Interpreter me, int type, const char32 *in_para
 	}
 }
 
+/*
+	Where a 'for', 'endfor', 'if', 'else', 'while', 'procedure' and so on jumps to,
+	and on which line a procedure is defined, depends only on the lines of the script,
+	not on the values of its variables. We therefore look each of these up only once,
+	the first time that the line is executed, and keep the result with the script text,
+	so that the next iterations of a loop, and the next runs of the same script, can jump directly.
+*/
+struct ScriptJump {
+	long lineNumber;   // the line after which execution continues; -1 if not yet looked up
+	bool toElsif;   // does execution continue with an 'elsif' whose condition has to be evaluated?
+};
+struct ScriptStructure {
+	std::vector <ScriptJump> jumps, elsifJumps;   // the jump from a line, and the jump from an 'elsif' that is false
+	std::unordered_map <std::u32string, long> procedureLines;
+	bool procedureLinesAreKnown;
+};
+static std::unordered_map <std::u32string, ScriptStructure> theScriptStructures;
+static int theNumberOfRunningScripts;
+#define Interpreter_MAXNUM_SCRIPT_STRUCTURES  100
+
+static ScriptStructure *Interpreter_getScriptStructure (const char32 *text) {
+	/*
+		Scripts that are still running keep a pointer to their structure,
+		so we can forget structures only if no script is running.
+	*/
+	if (theNumberOfRunningScripts == 0 && theScriptStructures.size () >= Interpreter_MAXNUM_SCRIPT_STRUCTURES)
+		theScriptStructures.clear ();
+	return & theScriptStructures [text];
+}
+
+static void ScriptStructure_init (ScriptStructure *me, long numberOfLines) {
+	if ((long) my jumps.size () == numberOfLines + 1) return;   // the same text, hence the same lines
+	my jumps.assign (numberOfLines + 1, ScriptJump { -1, false });
+	my elsifJumps.assign (numberOfLines + 1, ScriptJump { -1, false });
+	my procedureLines.clear ();
+	my procedureLinesAreKnown = false;
+}
+
+static void ScriptStructure_indexProcedures (ScriptStructure *me, char32 **lines, long numberOfLines) {
+	/*
+		Index the procedure definitions the way in which a call would find them:
+		the first definition of a name wins, and the search stops at a 'procedure' line without a name
+		(a call to any procedure that is not defined before that line will therefore do the search itself,
+		and report the missing name).
+	*/
+	for (long iline = 1; iline <= numberOfLines; iline ++) {
+		char32 *q = lines [iline];
+		if (! str32nequ (q, U"procedure ", 10)) continue;
+		q += 10;
+		while (Melder_isblank (*q)) q ++;
+		char32 *procName = q;
+		while (*q != U'\0' && ! Melder_isblank (*q) && *q != U'(' && *q != U':') q ++;
+		if (q == procName) break;
+		my procedureLines.emplace (std::u32string (procName, q - procName), iline);
+	}
+	my procedureLinesAreKnown = true;
+}
+
+static long ScriptStructure_lookUpProcedure (ScriptStructure *me, char32 **lines, long numberOfLines, const char32 *callName) {
+	if (! my procedureLinesAreKnown)
+		ScriptStructure_indexProcedures (me, lines, numberOfLines);
+	auto it = my procedureLines.find (callName);
+	return it == my procedureLines.end () ? 1 : it -> second;   // where to start searching for the definition
+}
+
 void Interpreter_run (Interpreter me, char32 *text) {
 	autoNUMvector <char32 *> lines;   // not autostringvector, because the elements are reference copies
 	long lineNumber = 0;
 	bool assertionFailed = false;
+	ScriptStructure *structure = Interpreter_getScriptStructure (text);
+	theNumberOfRunningScripts ++;
 	try {
 		static MelderString valueString { 0 };   // to divert the info
 		static MelderString assertErrorString { 0 };
@@ -767,6 +835,8 @@ void Interpreter_run (Interpreter me, char32 *text) {
 				lines [lineNumber] = emptyLine;
 			}
 		}
+		ScriptStructure_init (structure, numberOfLines);
+		std::vector <ScriptJump>& jumps = structure -> jumps, & elsifJumps = structure -> elsifJumps;
 		/*
 		 * Copy the parameter names and argument values into the array of variables.
 		 */
@@ -929,7 +999,7 @@ void Interpreter_run (Interpreter me, char32 *text) {
 							p ++;   // step over parenthesis or colon
 						}
 						int64 callLength = str32len (callName);
-						long iline = 1;
+						long iline = ScriptStructure_lookUpProcedure (structure, lines.peek(), numberOfLines, callName);
 						for (; iline <= numberOfLines; iline ++) {
 							char32 *linei = lines [iline], *q;
 							if (linei [0] != U'p' || linei [1] != U'r' || linei [2] != U'o' || linei [3] != U'c' ||
@@ -1059,7 +1129,7 @@ void Interpreter_run (Interpreter me, char32 *text) {
 							hasArguments = *p != U'\0';
 							*p = U'\0';   // close procedure name
 							callLength = str32len (callName);
-							for (iline = 1; iline <= numberOfLines; iline ++) {
+							for (iline = ScriptStructure_lookUpProcedure (structure, lines.peek(), numberOfLines, callName); iline <= numberOfLines; iline ++) {
 								char32 *linei = lines [iline], *q;
 								int hasParameters;
 								if (linei [0] != U'p' || linei [1] != U'r' || linei [2] != U'o' || linei [3] != U'c' ||
@@ -1156,82 +1226,104 @@ void Interpreter_run (Interpreter me, char32 *text) {
 							if (str32nequ (command2.string, U"endif", 5) && wordEnd (command2.string [5])) {
 								/* Ignore. */
 							} else if (str32nequ (command2.string, U"endfor", 6) && wordEnd (command2.string [6])) {
-								int depth = 0;
-								long iline;
-								for (iline = lineNumber - 1; iline > 0; iline --) {
-									char32 *line = lines [iline];
-									if (line [0] == U'f' && line [1] == U'o' && line [2] == U'r' && line [3] == U' ') {
-										if (depth == 0) { lineNumber = iline - 1; fromendfor = true; break; }   // go before 'for'
-										else depth --;
-									} else if (str32nequ (lines [iline], U"endfor", 6) && wordEnd (lines [iline] [6])) {
-										depth ++;
+								ScriptJump& jump = jumps [lineNumber];
+								if (jump. lineNumber < 0) {
+									int depth = 0;
+									long iline;
+									for (iline = lineNumber - 1; iline > 0; iline --) {
+										char32 *line = lines [iline];
+										if (line [0] == U'f' && line [1] == U'o' && line [2] == U'r' && line [3] == U' ') {
+											if (depth == 0) { jump. lineNumber = iline - 1; break; }   // go before 'for'
+											else depth --;
+										} else if (str32nequ (lines [iline], U"endfor", 6) && wordEnd (lines [iline] [6])) {
+											depth ++;
+										}
 									}
+									if (iline <= 0) Melder_throw (U"Unmatched 'endfor'.");
 								}
-								if (iline <= 0) Melder_throw (U"Unmatched 'endfor'.");
+								lineNumber = jump. lineNumber;
+								fromendfor = true;
 							} else if (str32nequ (command2.string, U"endwhile", 8) && wordEnd (command2.string [8])) {
-								int depth = 0;
-								long iline;
-								for (iline = lineNumber - 1; iline > 0; iline --) {
-									if (str32nequ (lines [iline], U"while ", 6)) {
-										if (depth == 0) { lineNumber = iline - 1; break; }   // go before 'while'
-										else depth --;
-									} else if (str32nequ (lines [iline], U"endwhile", 8) && wordEnd (lines [iline] [8])) {
-										depth ++;
+								ScriptJump& jump = jumps [lineNumber];
+								if (jump. lineNumber < 0) {
+									int depth = 0;
+									long iline;
+									for (iline = lineNumber - 1; iline > 0; iline --) {
+										if (str32nequ (lines [iline], U"while ", 6)) {
+											if (depth == 0) { jump. lineNumber = iline - 1; break; }   // go before 'while'
+											else depth --;
+										} else if (str32nequ (lines [iline], U"endwhile", 8) && wordEnd (lines [iline] [8])) {
+											depth ++;
+										}
 									}
+									if (iline <= 0) Melder_throw (U"Unmatched 'endwhile'.");
 								}
-								if (iline <= 0) Melder_throw (U"Unmatched 'endwhile'.");
+								lineNumber = jump. lineNumber;
 							} else if (str32nequ (command2.string, U"endproc", 7) && wordEnd (command2.string [7])) {
 								if (callDepth == 0) Melder_throw (U"Unmatched 'endproc'.");
 								lineNumber = callStack [callDepth --];
 								-- my callDepth;
 							} else fail = true;
 						} else if (str32nequ (command2.string, U"else", 4) && wordEnd (command2.string [4])) {
-							int depth = 0;
-							long iline;
-							for (iline = lineNumber + 1; iline <= numberOfLines; iline ++) {
-								if (str32nequ (lines [iline], U"endif", 5) && wordEnd (lines [iline] [5])) {
-									if (depth == 0) { lineNumber = iline; break; }   // go after 'endif'
-									else depth --;
-								} else if (str32nequ (lines [iline], U"if ", 3)) {
-									depth ++;
+							ScriptJump& jump = jumps [lineNumber];
+							if (jump. lineNumber < 0) {
+								int depth = 0;
+								long iline;
+								for (iline = lineNumber + 1; iline <= numberOfLines; iline ++) {
+									if (str32nequ (lines [iline], U"endif", 5) && wordEnd (lines [iline] [5])) {
+										if (depth == 0) { jump. lineNumber = iline; break; }   // go after 'endif'
+										else depth --;
+									} else if (str32nequ (lines [iline], U"if ", 3)) {
+										depth ++;
+									}
 								}
+								if (iline > numberOfLines) Melder_throw (U"Unmatched 'else'.");
 							}
-							if (iline > numberOfLines) Melder_throw (U"Unmatched 'else'.");
+							lineNumber = jump. lineNumber;
 						} else if (str32nequ (command2.string, U"elsif ", 6) || str32nequ (command2.string, U"elif ", 5)) {
 							if (fromif) {
 								double value;
 								fromif = false;
 								Interpreter_numericExpression (me, command2.string + 5, & value);
 								if (value == 0.0) {
+									ScriptJump& jump = elsifJumps [lineNumber];
+									if (jump. lineNumber < 0) {
+										int depth = 0;
+										long iline;
+										for (iline = lineNumber + 1; iline <= numberOfLines; iline ++) {
+											if (str32nequ (lines [iline], U"endif", 5) && wordEnd (lines [iline] [5])) {
+												if (depth == 0) { jump. lineNumber = iline; break; }   // go after 'endif'
+												else depth --;
+											} else if (str32nequ (lines [iline], U"else", 4) && wordEnd (lines [iline] [4])) {
+												if (depth == 0) { jump. lineNumber = iline; break; }   // go after 'else'
+											} else if ((str32nequ (lines [iline], U"elsif", 5) && wordEnd (lines [iline] [5]))
+												|| (str32nequ (lines [iline], U"elif", 4) && wordEnd (lines [iline] [4]))) {
+												if (depth == 0) { jump. lineNumber = iline - 1; jump. toElsif = true; break; }   // go at next 'elsif' or 'elif'
+											} else if (str32nequ (lines [iline], U"if ", 3)) {
+												depth ++;
+											}
+										}
+										if (iline > numberOfLines) Melder_throw (U"Unmatched 'elsif'.");
+									}
+									lineNumber = jump. lineNumber;
+									if (jump. toElsif) fromif = true;
+								}
+							} else {
+								ScriptJump& jump = jumps [lineNumber];
+								if (jump. lineNumber < 0) {
 									int depth = 0;
 									long iline;
 									for (iline = lineNumber + 1; iline <= numberOfLines; iline ++) {
 										if (str32nequ (lines [iline], U"endif", 5) && wordEnd (lines [iline] [5])) {
-											if (depth == 0) { lineNumber = iline; break; }   // go after 'endif'
+											if (depth == 0) { jump. lineNumber = iline; break; }   /* Go after 'endif'. */
 											else depth --;
-										} else if (str32nequ (lines [iline], U"else", 4) && wordEnd (lines [iline] [4])) {
-											if (depth == 0) { lineNumber = iline; break; }   // go after 'else'
-										} else if ((str32nequ (lines [iline], U"elsif", 5) && wordEnd (lines [iline] [5]))
-											|| (str32nequ (lines [iline], U"elif", 4) && wordEnd (lines [iline] [4]))) {
-											if (depth == 0) { lineNumber = iline - 1; fromif = true; break; }   // go at next 'elsif' or 'elif'
 										} else if (str32nequ (lines [iline], U"if ", 3)) {
 											depth ++;
 										}
 									}
-									if (iline > numberOfLines) Melder_throw (U"Unmatched 'elsif'.");
+									if (iline > numberOfLines) Melder_throw (U"'elsif' not matched with 'endif'.");
 								}
-							} else {
-								int depth = 0;
-								long iline;
-								for (iline = lineNumber + 1; iline <= numberOfLines; iline ++) {
-									if (str32nequ (lines [iline], U"endif", 5) && wordEnd (lines [iline] [5])) {
-										if (depth == 0) { lineNumber = iline; break; }   /* Go after 'endif'. */
-										else depth --;
-									} else if (str32nequ (lines [iline], U"if ", 3)) {
-										depth ++;
-									}
-								}
-								if (iline > numberOfLines) Melder_throw (U"'elsif' not matched with 'endif'.");
+								lineNumber = jump. lineNumber;
 							}
 						} else if (str32nequ (command2.string, U"exit", 4)) {
 							if (command2.string [4] == U'\0') {
@@ -1269,17 +1361,21 @@ void Interpreter_run (Interpreter me, char32 *text) {
 							}
 							var -> numericValue = loopVariable;
 							if (loopVariable > toValue) {
-								int depth = 0;
-								long iline;
-								for (iline = lineNumber + 1; iline <= numberOfLines; iline ++) {
-									if (str32nequ (lines [iline], U"endfor", 6)) {
-										if (depth == 0) { lineNumber = iline; break; }   // go after 'endfor'
-										else depth --;
-									} else if (str32nequ (lines [iline], U"for ", 4)) {
-										depth ++;
+								ScriptJump& jump = jumps [lineNumber];
+								if (jump. lineNumber < 0) {
+									int depth = 0;
+									long iline;
+									for (iline = lineNumber + 1; iline <= numberOfLines; iline ++) {
+										if (str32nequ (lines [iline], U"endfor", 6)) {
+											if (depth == 0) { jump. lineNumber = iline; break; }   // go after 'endfor'
+											else depth --;
+										} else if (str32nequ (lines [iline], U"for ", 4)) {
+											depth ++;
+										}
 									}
+									if (iline > numberOfLines) Melder_throw (U"Unmatched 'for'.");
 								}
-								if (iline > numberOfLines) Melder_throw (U"Unmatched 'for'.");
+								lineNumber = jump. lineNumber;
 							}
 						} else if (str32nequ (command2.string, U"form ", 5)) {
 							long iline;
@@ -1317,21 +1413,26 @@ void Interpreter_run (Interpreter me, char32 *text) {
 							double value;
 							Interpreter_numericExpression (me, command2.string + 3, & value);
 							if (value == 0.0) {
-								int depth = 0;
-								long iline;
-								for (iline = lineNumber + 1; iline <= numberOfLines; iline ++) {
-									if (str32nequ (lines [iline], U"endif", 5)) {
-										if (depth == 0) { lineNumber = iline; break; }   // go after 'endif'
-										else depth --;
-									} else if (str32nequ (lines [iline], U"else", 4)) {
-										if (depth == 0) { lineNumber = iline; break; }   // go after 'else'
-									} else if (str32nequ (lines [iline], U"elsif ", 6) || str32nequ (lines [iline], U"elif ", 5)) {
-										if (depth == 0) { lineNumber = iline - 1; fromif = true; break; }   // go at 'elsif'
-									} else if (str32nequ (lines [iline], U"if ", 3)) {
-										depth ++;
+								ScriptJump& jump = jumps [lineNumber];
+								if (jump. lineNumber < 0) {
+									int depth = 0;
+									long iline;
+									for (iline = lineNumber + 1; iline <= numberOfLines; iline ++) {
+										if (str32nequ (lines [iline], U"endif", 5)) {
+											if (depth == 0) { jump. lineNumber = iline; break; }   // go after 'endif'
+											else depth --;
+										} else if (str32nequ (lines [iline], U"else", 4)) {
+											if (depth == 0) { jump. lineNumber = iline; break; }   // go after 'else'
+										} else if (str32nequ (lines [iline], U"elsif ", 6) || str32nequ (lines [iline], U"elif ", 5)) {
+											if (depth == 0) { jump. lineNumber = iline - 1; jump. toElsif = true; break; }   // go at 'elsif'
+										} else if (str32nequ (lines [iline], U"if ", 3)) {
+											depth ++;
+										}
 									}
+									if (iline > numberOfLines) Melder_throw (U"Unmatched 'if'.");
 								}
-								if (iline > numberOfLines) Melder_throw (U"Unmatched 'if'.");
+								lineNumber = jump. lineNumber;
+								if (jump. toElsif) fromif = true;
 							} else if (value == NUMundefined) {
 								Melder_throw (U"The value of the 'if' condition is undefined.");
 							}
@@ -1362,14 +1463,18 @@ void Interpreter_run (Interpreter me, char32 *text) {
 						break;
 					case U'p':
 						if (str32nequ (command2.string, U"procedure ", 10)) {
-							long iline = lineNumber + 1;
-							for (; iline <= numberOfLines; iline ++) {
-								if (str32nequ (lines [iline], U"endproc", 7) && wordEnd (lines [iline] [7])) {
-									lineNumber = iline;
-									break;
-								}   // go after 'endproc'
+							ScriptJump& jump = jumps [lineNumber];
+							if (jump. lineNumber < 0) {
+								long iline = lineNumber + 1;
+								for (; iline <= numberOfLines; iline ++) {
+									if (str32nequ (lines [iline], U"endproc", 7) && wordEnd (lines [iline] [7])) {
+										jump. lineNumber = iline;
+										break;
+									}   // go after 'endproc'
+								}
+								if (iline > numberOfLines) Melder_throw (U"Unmatched 'proc'.");
 							}
-							if (iline > numberOfLines) Melder_throw (U"Unmatched 'proc'.");
+							lineNumber = jump. lineNumber;
 						} else if (str32nequ (command2.string, U"print", 5)) {
 							/*
 							 * Make sure that lines like "print = 3" will not be regarded as assignments.
@@ -1400,17 +1505,21 @@ void Interpreter_run (Interpreter me, char32 *text) {
 							double value;
 							Interpreter_numericExpression (me, command2.string + 6, & value);
 							if (value == 0.0) {
-								int depth = 0;
-								long iline;
-								for (iline = lineNumber - 1; iline > 0; iline --) {
-									if (str32nequ (lines [iline], U"repeat", 6) && wordEnd (lines [iline] [6])) {
-										if (depth == 0) { lineNumber = iline; break; }   // go after 'repeat'
-										else depth --;
-									} else if (str32nequ (lines [iline], U"until ", 6)) {
-										depth ++;
+								ScriptJump& jump = jumps [lineNumber];
+								if (jump. lineNumber < 0) {
+									int depth = 0;
+									long iline;
+									for (iline = lineNumber - 1; iline > 0; iline --) {
+										if (str32nequ (lines [iline], U"repeat", 6) && wordEnd (lines [iline] [6])) {
+											if (depth == 0) { jump. lineNumber = iline; break; }   // go after 'repeat'
+											else depth --;
+										} else if (str32nequ (lines [iline], U"until ", 6)) {
+											depth ++;
+										}
 									}
+									if (iline <= 0) Melder_throw (U"Unmatched 'until'.");
 								}
-								if (iline <= 0) Melder_throw (U"Unmatched 'until'.");
+								lineNumber = jump. lineNumber;
 							}
 						} else fail = true;
 						break;
@@ -1422,17 +1531,21 @@ void Interpreter_run (Interpreter me, char32 *text) {
 							double value;
 							Interpreter_numericExpression (me, command2.string + 6, & value);
 							if (value == 0.0) {
-								int depth = 0;
-								long iline;
-								for (iline = lineNumber + 1; iline <= numberOfLines; iline ++) {
-									if (str32nequ (lines [iline], U"endwhile", 8) && wordEnd (lines [iline] [8])) {
-										if (depth == 0) { lineNumber = iline; break; }   // go after 'endwhile'
-										else depth --;
-									} else if (str32nequ (lines [iline], U"while ", 6)) {
-										depth ++;
+								ScriptJump& jump = jumps [lineNumber];
+								if (jump. lineNumber < 0) {
+									int depth = 0;
+									long iline;
+									for (iline = lineNumber + 1; iline <= numberOfLines; iline ++) {
+										if (str32nequ (lines [iline], U"endwhile", 8) && wordEnd (lines [iline] [8])) {
+											if (depth == 0) { jump. lineNumber = iline; break; }   // go after 'endwhile'
+											else depth --;
+										} else if (str32nequ (lines [iline], U"while ", 6)) {
+											depth ++;
+										}
 									}
+									if (iline > numberOfLines) Melder_throw (U"Unmatched 'while'.");
 								}
-								if (iline > numberOfLines) Melder_throw (U"Unmatched 'while'.");
+								lineNumber = jump. lineNumber;
 							}
 						} else fail = true;
 						break;
@@ -1943,7 +2056,9 @@ void Interpreter_run (Interpreter me, char32 *text) {
 		my numberOfLabels = 0;
 		my running = false;
 		my stopped = false;
+		theNumberOfRunningScripts --;
 	} catch (MelderError) {
+		theNumberOfRunningScripts --;
 		if (lineNumber > 0) {
 			bool normalExplicitExit = str32nequ (lines [lineNumber], U"exit ", 5) || Melder_hasError (U"Script exited.");
 			if (! normalExplicitExit && ! assertionFailed) {   // don't show the message twice!
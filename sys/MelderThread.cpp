@@ -0,0 +1,374 @@
+/* MelderThread.cpp
+ *
+ * Copyright (C) 2014,2016 Paul Boersma
+ *
+ * This code is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This code is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this work. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MelderThread.h"
+#include <atomic>
+#include <exception>
+#include <vector>
+#if USE_PTHREADS
+	#include <unistd.h>
+	#if defined (linux)
+		#include <sched.h>
+	#endif
+#elif USE_CPPTHREADS
+	#include <condition_variable>
+#endif
+
+/*
+	Thin wrappers around the mutexes and condition variables of the three thread libraries,
+	so that the pool below can be written once.
+*/
+#if USE_WINTHREADS
+	typedef CRITICAL_SECTION MelderThread_Mutex;
+	typedef CONDITION_VARIABLE MelderThread_Condition;
+	static void mutex_init (MelderThread_Mutex *m) { InitializeCriticalSection (m); }
+	static void mutex_lock (MelderThread_Mutex *m) { EnterCriticalSection (m); }
+	static void mutex_unlock (MelderThread_Mutex *m) { LeaveCriticalSection (m); }
+	static void condition_init (MelderThread_Condition *c) { InitializeConditionVariable (c); }
+	static void condition_wait (MelderThread_Condition *c, MelderThread_Mutex *m) { SleepConditionVariableCS (c, m, INFINITE); }
+	static void condition_broadcast (MelderThread_Condition *c) { WakeAllConditionVariable (c); }
+#elif USE_PTHREADS
+	typedef pthread_mutex_t MelderThread_Mutex;
+	typedef pthread_cond_t MelderThread_Condition;
+	static void mutex_init (MelderThread_Mutex *m) { pthread_mutex_init (m, nullptr); }
+	static void mutex_lock (MelderThread_Mutex *m) { pthread_mutex_lock (m); }
+	static void mutex_unlock (MelderThread_Mutex *m) { pthread_mutex_unlock (m); }
+	static void condition_init (MelderThread_Condition *c) { pthread_cond_init (c, nullptr); }
+	static void condition_wait (MelderThread_Condition *c, MelderThread_Mutex *m) { pthread_cond_wait (c, m); }
+	static void condition_broadcast (MelderThread_Condition *c) { pthread_cond_broadcast (c); }
+#elif USE_CPPTHREADS
+	typedef std::mutex MelderThread_Mutex;
+	typedef std::condition_variable_any MelderThread_Condition;
+	static void mutex_init (MelderThread_Mutex *) { }
+	static void mutex_lock (MelderThread_Mutex *m) { m -> lock (); }
+	static void mutex_unlock (MelderThread_Mutex *m) { m -> unlock (); }
+	static void condition_init (MelderThread_Condition *) { }
+	static void condition_wait (MelderThread_Condition *c, MelderThread_Mutex *m) { c -> wait (*m); }
+	static void condition_broadcast (MelderThread_Condition *c) { c -> notify_all (); }
+#endif
+
+int MelderThread_getNumberOfProcessors () {
+	static int numberOfProcessors = 0;
+	if (numberOfProcessors == 0) {
+		int number = 1;
+		#if USE_WINTHREADS
+			DWORD_PTR processMask, systemMask;
+			if (GetProcessAffinityMask (GetCurrentProcess (), & processMask, & systemMask)) {
+				number = 0;
+				for (; processMask != 0; processMask >>= 1)
+					if (processMask & 1) number ++;
+			}
+		#elif USE_PTHREADS
+			#if defined (linux) && defined (CPU_COUNT)
+				cpu_set_t affinity;
+				CPU_ZERO (& affinity);
+				if (sched_getaffinity (0, sizeof (affinity), & affinity) == 0)
+					number = CPU_COUNT (& affinity);
+				else
+					number = (int) sysconf (_SC_NPROCESSORS_ONLN);
+			#else
+				number = (int) sysconf (_SC_NPROCESSORS_ONLN);
+			#endif
+		#elif USE_CPPTHREADS
+			number = (int) std::thread::hardware_concurrency ();
+		#endif
+		numberOfProcessors = number < 1 ? 1 : number;
+	}
+	return numberOfProcessors;
+}
+
+/*
+	One job, i.e. one call to MelderThread_forRange.
+	Every participating thread owns a slot with a contiguous range of items still to be done;
+	the owner takes chunks from the front, thieves take halves from the back.
+*/
+struct MelderThread_Slot {
+	#if USE_WINTHREADS || USE_PTHREADS || USE_CPPTHREADS
+		MelderThread_Mutex mutex;
+	#endif
+	std::atomic <long> next, end;   // the items still to be done are next .. end - 1
+	char padding [64];   // keep the slots of different threads on different cache lines
+};
+
+struct MelderThread_Job {
+	long numberOfItems, chunkSize;
+	int numberOfThreads;
+	const std::function <void (long, long, int)> *body;
+	const std::function <void (double)> *progress;
+	std::atomic <long> numberOfItemsDone;
+	std::atomic <bool> cancelled;
+	std::exception_ptr exception;
+	char32 errorMessage [2000+1];   // the error buffer of the worker that threw first
+};
+
+#if USE_WINTHREADS || USE_PTHREADS || USE_CPPTHREADS
+
+static struct {
+	bool inited;
+	int numberOfWorkers;
+	std::vector <MelderThread_Slot> slots;   // one for each worker and one for the calling thread
+	MelderThread_Mutex mutex;   // protects everything below
+	MelderThread_Condition jobAvailable, jobDone;
+	MelderThread_Job *job;
+	int numberOfThreadsInJob;
+	long generation;   // incremented for every job
+	int numberOfBusyWorkers;
+	std::atomic <bool> busy;
+} thePool;
+
+static bool takeChunk (MelderThread_Job *job, int threadNumber, long *firstItem, long *lastItem) {
+	MelderThread_Slot *own = & thePool. slots [threadNumber];
+	mutex_lock (& own -> mutex);
+	if (own -> next < own -> end) {
+		*firstItem = own -> next;
+		own -> next += job -> chunkSize;
+		if (own -> next > own -> end) own -> next = own -> end. load ();
+		*lastItem = own -> next - 1;
+		mutex_unlock (& own -> mutex);
+		return true;
+	}
+	mutex_unlock (& own -> mutex);
+	/*
+		Our own range is exhausted. Steal the second half of what remains in the fullest other slot.
+	*/
+	for (;;) {
+		if (job -> cancelled) return false;
+		int victim = -1;
+		long mostRemaining = 0;
+		for (int ithread = 0; ithread < job -> numberOfThreads; ithread ++) {
+			if (ithread == threadNumber) continue;
+			long remaining = thePool. slots [ithread]. end - thePool. slots [ithread]. next;   // an estimate, checked again below
+			if (remaining > mostRemaining) {
+				mostRemaining = remaining;
+				victim = ithread;
+			}
+		}
+		if (victim < 0) return false;
+		MelderThread_Slot *other = & thePool. slots [victim];
+		mutex_lock (& other -> mutex);
+		long remaining = other -> end - other -> next;
+		if (remaining <= 0) {
+			mutex_unlock (& other -> mutex);
+			continue;   // somebody was quicker; look again
+		}
+		long stolenFirst = other -> end - remaining / 2;   // if only one item remains, steal it
+		if (stolenFirst == other -> end) stolenFirst = other -> next;
+		long stolenEnd = other -> end;
+		other -> end = stolenFirst;
+		mutex_unlock (& other -> mutex);
+		mutex_lock (& own -> mutex);
+		own -> next = stolenFirst;
+		own -> end = stolenEnd;
+		*firstItem = own -> next;
+		own -> next += job -> chunkSize;
+		if (own -> next > own -> end) own -> next = own -> end. load ();
+		*lastItem = own -> next - 1;
+		mutex_unlock (& own -> mutex);
+		return true;
+	}
+}
+
+static void participate (MelderThread_Job *job, int threadNumber) {
+	try {
+		long firstItem, lastItem;
+		while (! job -> cancelled && takeChunk (job, threadNumber, & firstItem, & lastItem)) {
+			(*job -> body) (firstItem, lastItem, threadNumber);
+			long numberOfItemsDone = ( job -> numberOfItemsDone += lastItem - firstItem + 1 );
+			if (threadNumber == 0 && *job -> progress)
+				(*job -> progress) ((double) numberOfItemsDone / job -> numberOfItems);
+		}
+	} catch (...) {
+		mutex_lock (& thePool. mutex);
+		if (! job -> exception) {
+			job -> exception = std::current_exception ();
+			if (threadNumber != 0) {   // a worker's error buffer is not the caller's
+				str32ncpy (job -> errorMessage, Melder_getError (), 2000);
+				job -> errorMessage [2000] = U'\0';
+			}
+		}
+		job -> cancelled = true;
+		mutex_unlock (& thePool. mutex);
+		if (threadNumber != 0)
+			Melder_clearError ();   // leave the worker's buffer empty for the next job
+	}
+}
+
+static void workerLoop (int threadNumber) {
+	long seenGeneration = 0;
+	for (;;) {
+		mutex_lock (& thePool. mutex);
+		while (thePool. generation == seenGeneration)
+			condition_wait (& thePool. jobAvailable, & thePool. mutex);
+		seenGeneration = thePool. generation;
+		if (threadNumber >= thePool. numberOfThreadsInJob) {
+			mutex_unlock (& thePool. mutex);
+			continue;   // not needed for this job (which may even be over already)
+		}
+		MelderThread_Job *job = thePool. job;
+		mutex_unlock (& thePool. mutex);
+		participate (job, threadNumber);
+		mutex_lock (& thePool. mutex);
+		if (-- thePool. numberOfBusyWorkers == 0)
+			condition_broadcast (& thePool. jobDone);
+		mutex_unlock (& thePool. mutex);
+	}
+}
+
+#if USE_WINTHREADS
+	static DWORD WINAPI workerThread (void *arg) {
+		workerLoop ((int) (intptr_t) arg);
+		return 0;
+	}
+#elif USE_PTHREADS
+	static void * workerThread (void *arg) {
+		workerLoop ((int) (intptr_t) arg);
+		return nullptr;
+	}
+#endif
+
+static void thePool_init () {
+	/*
+		Not protected against simultaneous first calls from two threads;
+		the first call comes from the interface thread, long before any worker exists.
+	*/
+	if (thePool. inited) return;
+	thePool. numberOfWorkers = MelderThread_getNumberOfProcessors () - 1;
+	thePool. slots = std::vector <MelderThread_Slot> (thePool. numberOfWorkers + 1);
+	for (int ithread = 0; ithread <= thePool. numberOfWorkers; ithread ++)
+		mutex_init (& thePool. slots [ithread]. mutex);
+	mutex_init (& thePool. mutex);
+	condition_init (& thePool. jobAvailable);
+	condition_init (& thePool. jobDone);
+	/*
+		The workers are detached: they live as long as the process does.
+	*/
+	for (int ithread = 1; ithread <= thePool. numberOfWorkers; ithread ++) {
+		#if USE_WINTHREADS
+			HANDLE thread = CreateThread (nullptr, 0, workerThread, (void *) (intptr_t) ithread, 0, nullptr);
+			if (! thread) {
+				thePool. numberOfWorkers = ithread - 1;
+				break;
+			}
+			CloseHandle (thread);
+		#elif USE_PTHREADS
+			pthread_t thread;
+			if (pthread_create (& thread, nullptr, workerThread, (void *) (intptr_t) ithread) != 0) {
+				thePool. numberOfWorkers = ithread - 1;
+				break;
+			}
+			pthread_detach (thread);
+		#elif USE_CPPTHREADS
+			std::thread (workerLoop, ithread). detach ();
+		#endif
+	}
+	thePool. inited = true;
+}
+
+int MelderThread_getNumberOfThreads () {
+	thePool_init ();
+	return thePool. numberOfWorkers + 1;
+}
+
+#else
+
+int MelderThread_getNumberOfThreads () {
+	return 1;
+}
+
+#endif
+
+int MelderThread_getNumberOfThreadsToUse (long numberOfItems, long minimumNumberOfItemsPerThread) {
+	if (minimumNumberOfItemsPerThread < 1) minimumNumberOfItemsPerThread = 1;
+	long numberOfThreads = (numberOfItems - 1) / minimumNumberOfItemsPerThread + 1;
+	const int maximumNumberOfThreads = MelderThread_getNumberOfThreads ();
+	if (numberOfThreads > maximumNumberOfThreads) numberOfThreads = maximumNumberOfThreads;
+	if (numberOfThreads < 1) numberOfThreads = 1;
+	return (int) numberOfThreads;
+}
+
+static void forRange_singleThreaded (long numberOfItems, long chunkSize,
+	const std::function <void (long, long, int)>& body, const std::function <void (double)>& progress)
+{
+	for (long firstItem = 1; firstItem <= numberOfItems; firstItem += chunkSize) {
+		long lastItem = firstItem + chunkSize - 1;
+		if (lastItem > numberOfItems) lastItem = numberOfItems;
+		body (firstItem, lastItem, 0);
+		if (progress) progress ((double) lastItem / numberOfItems);
+	}
+}
+
+void MelderThread_forRange (long numberOfItems, int numberOfThreads, long chunkSize,
+	const std::function <void (long firstItem, long lastItem, int threadNumber)>& body,
+	const std::function <void (double fractionDone)>& progress)
+{
+	if (numberOfItems < 1) return;
+	if (chunkSize < 1) chunkSize = 1;
+	if (numberOfThreads > numberOfItems) numberOfThreads = (int) numberOfItems;
+	#if USE_WINTHREADS || USE_PTHREADS || USE_CPPTHREADS
+		if (numberOfThreads > MelderThread_getNumberOfThreads ())
+			numberOfThreads = MelderThread_getNumberOfThreads ();
+		bool expected = false;
+		if (numberOfThreads <= 1 || ! thePool. busy. compare_exchange_strong (expected, true)) {
+			forRange_singleThreaded (numberOfItems, chunkSize, body, progress);
+			return;
+		}
+		MelderThread_Job job;
+		job. numberOfItems = numberOfItems;
+		job. chunkSize = chunkSize;
+		job. numberOfThreads = numberOfThreads;
+		job. body = & body;
+		job. progress = & progress;
+		job. numberOfItemsDone = 0;
+		job. cancelled = false;
+		job. errorMessage [0] = U'\0';
+		/*
+			Divide the items evenly over the threads.
+		*/
+		for (int ithread = 0; ithread < numberOfThreads; ithread ++) {
+			thePool. slots [ithread]. next = 1 + (long) ((double) numberOfItems * ithread / numberOfThreads);
+			thePool. slots [ithread]. end = 1 + (long) ((double) numberOfItems * (ithread + 1) / numberOfThreads);
+		}
+		mutex_lock (& thePool. mutex);
+		thePool. job = & job;
+		thePool. numberOfThreadsInJob = numberOfThreads;
+		thePool. numberOfBusyWorkers = numberOfThreads - 1;
+		thePool. generation ++;
+		condition_broadcast (& thePool. jobAvailable);
+		mutex_unlock (& thePool. mutex);
+
+		participate (& job, 0);
+
+		mutex_lock (& thePool. mutex);
+		while (thePool. numberOfBusyWorkers > 0)
+			condition_wait (& thePool. jobDone, & thePool. mutex);
+		thePool. job = nullptr;
+		thePool. numberOfThreadsInJob = 0;
+		mutex_unlock (& thePool. mutex);
+		thePool. busy = false;
+		if (job. exception) {
+			if (job. errorMessage [0] != U'\0')
+				Melder_appendError_noLine (job. errorMessage);
+			std::rethrow_exception (job. exception);
+		}
+	#else
+		(void) numberOfThreads;
+		forRange_singleThreaded (numberOfItems, chunkSize, body, progress);
+	#endif
+}
+
+/* End of file MelderThread.cpp */
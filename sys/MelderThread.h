@@ -18,6 +18,7 @@
  * along with this work. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <functional>
 #include <vector>
 #include "Thing.h"
 
@@ -79,94 +80,90 @@
 	#define MelderThread_UNLOCK(_mutex)  _mutex = 0
 #endif
 
-static int MelderThread_getNumberOfProcessors () {
+/*
+	A mutex that needs no MelderThread_MUTEX_INIT, so that it can be used from any thread at any time,
+	and a lock on it that is released when it goes out of scope, also if the locked code throws:
+
+		static MelderThread_StaticMutex theCacheMutex;
+		...
+		{// scope
+			autoMelderThread_Lock lock (theCacheMutex);
+			... (may allocate, i.e. may throw)
+		}
+*/
+struct MelderThread_StaticMutex {
 	#if USE_WINTHREADS
-		return 8;
+		SRWLOCK _lock = SRWLOCK_INIT;
+		void lock () { AcquireSRWLockExclusive (& _lock); }
+		void unlock () { ReleaseSRWLockExclusive (& _lock); }
 	#elif USE_PTHREADS
-		return 8;
+		pthread_mutex_t _mutex = PTHREAD_MUTEX_INITIALIZER;
+		void lock () { pthread_mutex_lock (& _mutex); }
+		void unlock () { pthread_mutex_unlock (& _mutex); }
 	#elif USE_CPPTHREADS
-		return std::thread::hardware_concurrency ();
+		std::mutex _mutex;
+		void lock () { _mutex. lock (); }
+		void unlock () { _mutex. unlock (); }
 	#else
-		return 1;
+		void lock () { }
+		void unlock () { }
 	#endif
-}
+};
 
-#if USE_WINTHREADS
-	template <class T> void MelderThread_run (DWORD (WINAPI *func) (T *), _Thing_auto <T> *args, int numberOfThreads) {
-		if (numberOfThreads == 1) {
-			func (args [0].get());
-		} else {
-			std::vector <HANDLE> threads (numberOfThreads);
-			try {
-				for (int ithread = 1; ithread < numberOfThreads; ithread ++) {
-					threads [ithread - 1] = CreateThread (nullptr, 0,
-						(DWORD (WINAPI *)(void *)) func, (void *) args [ithread - 1].get(), 0, nullptr);
-				}
-				func (args [numberOfThreads - 1].get());
-			} catch (MelderError) {
-				for (int ithread = 1; ithread < numberOfThreads; ithread ++) {
-					WaitForSingleObject (threads [ithread - 1], INFINITE);
-					CloseHandle (threads [ithread - 1]);
-				}
-				throw;
-			}
-			for (int ithread = 1; ithread < numberOfThreads; ithread ++) {
-				WaitForSingleObject (threads [ithread - 1], INFINITE);
-				CloseHandle (threads [ithread - 1]);
-			}
-		}
-	}
-#elif USE_PTHREADS
-	template <class T> void MelderThread_run (void * (*func) (T *), _Thing_auto <T> *args, int numberOfThreads) {
-		if (numberOfThreads == 1) {
-			func (args [0].get());
-		} else {
-			std::vector <pthread_t> threads (numberOfThreads);
-			try {
-				for (int ithread = 1; ithread < numberOfThreads; ithread ++) {
-					(void) pthread_create (& threads [ithread - 1],
-						nullptr, (void*(*)(void *)) func, (void *) args [ithread - 1].get());
-				}
-				func (args [numberOfThreads - 1].get());
-			} catch (MelderError) {
-				for (int ithread = 1; ithread < numberOfThreads; ithread ++) {
-					pthread_join (threads [ithread - 1], nullptr);
-				}
-				throw;
-			}
-			for (int ithread = 1; ithread < numberOfThreads; ithread ++) {
-				pthread_join (threads [ithread - 1], nullptr);
-			}
-		}
-	}
-#elif USE_CPPTHREADS
-	template <class T> void MelderThread_run (void * (*func) (T *), _Thing_auto <T> *args, int numberOfThreads) {
-		if (numberOfThreads == 1) {
-			func (args [0].get());
-		} else {
-			std::vector <std::thread> thread (numberOfThreads);
-			try {
-				for (int ithread = 1; ithread < numberOfThreads; ithread ++) {
-					thread [ithread - 1] = std::thread (func, args [ithread - 1].get());
-				}
-				func (args [numberOfThreads - 1].get());
-			} catch (MelderError) {
-				for (int ithread = 1; ithread < numberOfThreads; ithread ++) {
-					if (thread [ithread - 1]. joinable ())
-						thread [ithread - 1]. join ();
-				}
-				throw;
-			}
-			for (int ithread = 1; ithread < numberOfThreads; ithread ++) {
-				thread [ithread - 1]. join ();
-			}
-		}
-	}
-#else
-	template <class T> void MelderThread_run (void (*func) (T *), _Thing_auto <T> *args, int numberOfThreads) {
-		func (args [0].get());
-	}
-#endif
+struct autoMelderThread_Lock {
+	MelderThread_StaticMutex& _mutex;
+	autoMelderThread_Lock (MelderThread_StaticMutex& mutex) : _mutex (mutex) { _mutex. lock (); }
+	~autoMelderThread_Lock () { _mutex. unlock (); }
+	autoMelderThread_Lock (const autoMelderThread_Lock&) = delete;
+	autoMelderThread_Lock& operator= (const autoMelderThread_Lock&) = delete;
+};
+
+int MelderThread_getNumberOfProcessors ();
+/*
+	The number of processors that this process is allowed to run on
+	(on Linux, this is the size of the CPU affinity mask, so that taskset and cgroups are honoured).
+	Always at least 1.
+*/
+
+int MelderThread_getNumberOfThreads ();
+/*
+	The number of threads that can work on a single MelderThread_forRange job:
+	the calling thread plus the workers of the process-wide pool.
+*/
+
+int MelderThread_getNumberOfThreadsToUse (long numberOfItems, long minimumNumberOfItemsPerThread);
+/*
+	How many threads are worth starting for a job of `numberOfItems` items,
+	if no thread should get fewer than `minimumNumberOfItemsPerThread` items.
+	The result is between 1 and MelderThread_getNumberOfThreads ().
+	Use this to decide how many per-thread workspaces to allocate before calling MelderThread_forRange.
+*/
+
+void MelderThread_forRange (long numberOfItems, int numberOfThreads, long chunkSize,
+	const std::function <void (long firstItem, long lastItem, int threadNumber)>& body,
+	const std::function <void (double fractionDone)>& progress = nullptr);
+/*
+	Calls body (firstItem, lastItem, threadNumber) for disjoint ranges that together cover items 1 through numberOfItems.
+	The work is done by at most `numberOfThreads` threads: the calling thread (which has threadNumber 0)
+	and workers from a process-wide pool that is created at the first call and then stays alive,
+	so that short analyses do not have to pay for thread creation.
+	Each thread starts with an equal contiguous part of the items, and processes it in chunks of `chunkSize` items;
+	a thread that runs out of work steals the second half of the remaining items of another thread.
+	`threadNumber` is always less than `numberOfThreads`, so it can be used to index per-thread workspaces.
+
+	`progress` is called only from the calling thread, with the fraction of the items that has been done.
+	Typically it calls Melder_progress; if that throws (because the user clicked Cancel),
+	no new chunks are handed out, the threads are waited for, and the exception is rethrown.
+	If `body` throws in any thread, the first exception is rethrown in the calling thread in the same way.
+	Every thread has its own error buffer, so `body` can throw as usual;
+	if the first exception came from a worker, its error message is appended to that of the calling thread
+	before the rethrow. A worker's buffer is cleared after it throws, but `body` must not leave
+	a message in it without throwing (e.g. by catching an error and carrying on):
+	nobody would ever see or clear that message, so count such failures and report them after the call.
+
+	If the pool is already busy (e.g. if MelderThread_forRange is called from within `body`),
+	all the work is done in the calling thread, with threadNumber 0.
+*/
 
 #endif
 /* End of file MelderThread.h */
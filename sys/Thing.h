@@ -30,6 +30,7 @@
 	/* The input/output mechanism: */
 		#include "abcio.h"
 
+#include <atomic>
 //#include <string>
 
 #define _Thing_auto_DEBUG  0
@@ -240,7 +241,7 @@ void * _Thing_check (Thing me, ClassInfo table, const char *fileName, int line);
 
 /* For debugging. */
 
-extern long theTotalNumberOfThings;
+extern std::atomic <long> theTotalNumberOfThings;
 /* This number is 0 initially, increments at every successful `new', and decrements at every `forget'. */
 
 template <class T>
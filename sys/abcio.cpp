@@ -547,7 +547,8 @@ void texputw4 (MelderFile file, const char32 *s, const char32 *s1, const char32
 #if defined (macintosh) && TARGET_RT_BIG_ENDIAN == 1
 	#define binario_doubleIEEE8msb (sizeof (double) == 8)
 	#define binario_doubleIEEE8lsb 0
-#elif defined (_WIN32) || defined (macintosh) && TARGET_RT_LITTLE_ENDIAN == 1
+#elif defined (_WIN32) || defined (macintosh) && TARGET_RT_LITTLE_ENDIAN == 1 || \
+		defined (__BYTE_ORDER__) && defined (__ORDER_LITTLE_ENDIAN__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
 	#define binario_doubleIEEE8msb 0
 	#define binario_doubleIEEE8lsb (sizeof (double) == 8)
 #else
@@ -1376,6 +1377,76 @@ void binputr8 (double x, FILE *f) {
 	}
 }
 
+/*
+	Whole arrays of doubles are transferred with a single fread or fwrite (per buffer),
+	so that a large Sound or Matrix does not cost two stdio calls per sample.
+	On a little-endian IEEE host, the bytes are swapped in place;
+	the results are identical to those of calling bingetr8 or binputr8 for each element.
+*/
+
+static inline uint64_t swapBytes8 (uint64_t word) {
+	word = (word & 0x00000000FFFFFFFF) << 32 | (word & 0xFFFFFFFF00000000) >> 32;
+	word = (word & 0x0000FFFF0000FFFF) << 16 | (word & 0xFFFF0000FFFF0000) >> 16;
+	word = (word & 0x00FF00FF00FF00FF) << 8 | (word & 0xFF00FF00FF00FF00) >> 8;
+	return word;
+}
+
+void bingetr8_array (double *x, long n, FILE *f) {
+	if (n <= 0) return;
+	if ((binario_doubleIEEE8msb || binario_doubleIEEE8lsb) && Melder_debug != 18) {
+		try {
+			if ((long) fread (x, sizeof (double), (size_t) n, f) != n) readError (f, Melder_cat (n, U" 64-bit floating-point numbers."));
+		} catch (MelderError) {
+			Melder_throw (U"Floating-point numbers not read from binary file.");
+		}
+		if (binario_doubleIEEE8lsb) {
+			Melder_assert (sizeof (uint64_t) == sizeof (double));
+			for (long i = 0; i < n; i ++) {
+				uint64_t word;
+				memcpy (& word, & x [i], 8);
+				word = swapBytes8 (word);
+				if ((word & 0x7FF0000000000000) == 0x7FF0000000000000)   // Infinity or Not-a-Number
+					word &= 0xFFF0000000000000;   // HUGE_VAL with the sign of the file's number, as in bingetr8
+				memcpy (& x [i], & word, 8);
+			}
+		}
+	} else {
+		for (long i = 0; i < n; i ++)
+			x [i] = bingetr8 (f);
+	}
+}
+
+void binputr8_array (const double *x, long n, FILE *f) {
+	if (n <= 0) return;
+	if ((binario_doubleIEEE8msb || binario_doubleIEEE8lsb) && Melder_debug != 18) {
+		const long bufferSize = 4096;
+		uint64_t buffer [bufferSize];
+		for (long offset = 0; offset < n; offset += bufferSize) {
+			long numberOfValues = n - offset < bufferSize ? n - offset : bufferSize;
+			for (long i = 0; i < numberOfValues; i ++) {
+				double value = x [offset + i];
+				uint64_t word;
+				if (isnan (value))
+					word = 0x7FF0000000000000;   // Infinity, as in binputr8
+				else if (value == 0.0)
+					word = 0;   // no negative zero, as in binputr8
+				else
+					memcpy (& word, & value, 8);
+				buffer [i] = binario_doubleIEEE8lsb ? swapBytes8 (word) : word;
+			}
+			try {
+				if ((long) fwrite (buffer, sizeof (uint64_t), (size_t) numberOfValues, f) != numberOfValues)
+					writeError (Melder_cat (numberOfValues, U" 64-bit floating-point numbers."));
+			} catch (MelderError) {
+				Melder_throw (U"Floating-point numbers not written to binary file.");
+			}
+		}
+	} else {
+		for (long i = 0; i < n; i ++)
+			binputr8 (x [i], f);
+	}
+}
+
 void binputr10 (double x, FILE *f) {
 	try {
 		unsigned char bytes [10];
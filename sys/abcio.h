@@ -165,6 +165,11 @@ double bingetr8 (FILE *f);   void binputr8 (double x, FILE *f);
 	Denormalized: from 4.9e-324.
 	This is the native format of a `double` on Silicon Graphics Iris and PowerMac.
 */
+void bingetr8_array (double *x, long n, FILE *f);   void binputr8_array (const double *x, long n, FILE *f);
+/*
+	Read or write the `n` real numbers x [0] .. x [n - 1] as with bingetr8 or binputr8,
+	but with one call to the stream for the whole array.
+*/
 
 double bingetr10 (FILE *f);   void binputr10 (double x, FILE *f);
 /*
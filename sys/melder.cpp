@@ -34,6 +34,8 @@
 #endif
 
 #include "MelderThread.h"
+#include <string>
+#include <vector>
 
 #include "enums_getText.h"
 #include "melder_enums.h"
@@ -268,6 +270,71 @@ bool Melder_numberMatchesCriterion (double value, int which_kMelder_number, doub
 		(which_kMelder_number == kMelder_number_GREATER_THAN_OR_EQUAL_TO && value >= criterion);
 }
 
+/*
+	The most recently used compiled regular expressions, so that a criterion that is checked
+	for every row of a table or every interval of a tier is compiled only once.
+	The regular-expression engine keeps its state in globals and in the compiled expression itself,
+	so compiling and matching are both done with the mutex locked.
+*/
+#define Melder_REGEXP_CACHE_SIZE  20
+
+struct Melder_RegexpCacheEntry {
+	std::u32string pattern;
+	regexp *compiledRegexp;
+	int64 lastUse;
+};
+
+static MelderThread_StaticMutex theRegexpCacheMutex;   // protects the cache, the statistics, and the regular-expression engine
+static std::vector <struct Melder_RegexpCacheEntry> theRegexpCache;
+static int64 theNumberOfRegexpHits, theNumberOfRegexpMisses, theRegexpClock;
+
+static bool Melder_stringMatchesRegexp (const char32 *value, const char32 *pattern) {
+	autoMelderThread_Lock lock (theRegexpCacheMutex);   // also released if anything below throws
+	struct Melder_RegexpCacheEntry *entry = nullptr;
+	for (struct Melder_RegexpCacheEntry& candidate : theRegexpCache) {
+		if (str32equ (candidate. pattern. c_str (), pattern)) {
+			entry = & candidate;
+			break;
+		}
+	}
+	if (entry) {
+		theNumberOfRegexpHits += 1;
+	} else {
+		theNumberOfRegexpMisses += 1;
+		const char32 *compileMessage;
+		regexp *compiledRegexp = CompileRE (pattern, & compileMessage, 0);
+		if (! compiledRegexp)
+			Melder_throw (U"Regular expression: ", compileMessage, U".");
+		try {
+			std::u32string newPattern (pattern);
+			if (theRegexpCache. size () < Melder_REGEXP_CACHE_SIZE) {
+				theRegexpCache. push_back (Melder_RegexpCacheEntry { std::move (newPattern), compiledRegexp, 0 });
+				entry = & theRegexpCache. back ();
+			} else {
+				entry = & theRegexpCache [0];
+				for (struct Melder_RegexpCacheEntry& candidate : theRegexpCache)
+					if (candidate. lastUse < entry -> lastUse) entry = & candidate;
+				free (entry -> compiledRegexp);
+				entry -> pattern = std::move (newPattern);
+				entry -> compiledRegexp = compiledRegexp;
+			}
+		} catch (...) {
+			free (compiledRegexp);   // out of memory: leave the cache as it was
+			throw;
+		}
+	}
+	entry -> lastUse = ++ theRegexpClock;
+	return ExecRE (entry -> compiledRegexp, nullptr, value, nullptr, 0, '\0', '\0', nullptr, nullptr, nullptr) &&
+		entry -> compiledRegexp -> startp [0];
+}
+
+void Melder_getRegexpCacheStatistics (int64 *numberOfHits, int64 *numberOfMisses, long *numberOfRegexps) {
+	autoMelderThread_Lock lock (theRegexpCacheMutex);
+	if (numberOfHits) *numberOfHits = theNumberOfRegexpHits;
+	if (numberOfMisses) *numberOfMisses = theNumberOfRegexpMisses;
+	if (numberOfRegexps) *numberOfRegexps = (long) theRegexpCache. size ();
+}
+
 bool Melder_stringMatchesCriterion (const char32 *value, int which_kMelder_string, const char32 *criterion) {
 	if (! value) {
 		value = U"";   // regard null strings as empty strings, as is usual in Praat
@@ -293,12 +360,7 @@ bool Melder_stringMatchesCriterion (const char32 *value, int which_kMelder_strin
 		return (which_kMelder_string == kMelder_string_ENDS_WITH) == matchPositiveCriterion;
 	}
 	if (which_kMelder_string == kMelder_string_MATCH_REGEXP) {
-		char32 *place = nullptr;
-		regexp *compiled_regexp = CompileRE_throwable (criterion, 0);
-		if (ExecRE (compiled_regexp, nullptr, value, nullptr, 0, '\0', '\0', nullptr, nullptr, nullptr))
-			place = compiled_regexp -> startp [0];
-		free (compiled_regexp);
-		return !! place;
+		return Melder_stringMatchesRegexp (value, criterion);
 	}
 	return false;   // should not occur
 }
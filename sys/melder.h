@@ -799,6 +799,11 @@ void Melder_sprint (char32 *buffer, int64 bufferSize, Melder_16_TO_19_ARGS);
 
 bool Melder_numberMatchesCriterion (double value, int which_kMelder_number, double criterion);
 bool Melder_stringMatchesCriterion (const char32 *value, int which_kMelder_string, const char32 *criterion);
+/*
+	Compiled regular expressions (for kMelder_string_MATCH_REGEXP) are kept in a small cache,
+	from which the least recently used one is removed when a new one comes in.
+*/
+void Melder_getRegexpCacheStatistics (int64 *numberOfHits, int64 *numberOfMisses, long *numberOfRegexps);
 
 /********** STRING PARSING **********/
 
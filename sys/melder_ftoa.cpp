@@ -26,9 +26,13 @@
 #define MAXIMUM_NUMERIC_STRING_LENGTH  400
 	/* = sign + 324 + point + 60 + e + sign + 3 + null byte + ("·10^^" - "e") + 4 extra */
 
-static  char   buffers8  [NUMBER_OF_BUFFERS] [MAXIMUM_NUMERIC_STRING_LENGTH + 1];
-static  char32 buffers32 [NUMBER_OF_BUFFERS] [MAXIMUM_NUMERIC_STRING_LENGTH + 1];
-static int ibuffer = 0;
+/*
+	The rotating buffers are per thread, because the worker threads of MelderThread_forRange
+	can format numbers for their error messages.
+*/
+static thread_local char   buffers8  [NUMBER_OF_BUFFERS] [MAXIMUM_NUMERIC_STRING_LENGTH + 1];
+static thread_local char32 buffers32 [NUMBER_OF_BUFFERS] [MAXIMUM_NUMERIC_STRING_LENGTH + 1];
+static thread_local int ibuffer = 0;
 
 #define CONVERT_BUFFER_TO_CHAR32 \
 	char32 *q = buffers32 [ibuffer]; \
@@ -49,7 +53,7 @@ const char * Melder8_integer (int64 value) {
 		 * There are also buggy platforms (namely 32-bit gcc on Linux) that support long long and %I64d but that convert
 		 * the argument to a 32-bit long.
 		 */
-		static const char *formatString = nullptr;
+		static thread_local const char *formatString = nullptr;
 		if (! formatString) {
 			char tryBuffer [MAXIMUM_NUMERIC_STRING_LENGTH + 1];
 			formatString = "%lld";
@@ -303,8 +307,8 @@ const char32 * Melder_character (char32 kar) {
 	return buffers32 [ibuffer];
 }
 
-static MelderString thePadBuffers [NUMBER_OF_BUFFERS];
-static int iPadBuffer { 0 };
+static thread_local MelderString thePadBuffers [NUMBER_OF_BUFFERS];
+static thread_local int iPadBuffer { 0 };
 
 const char32 * Melder_pad (int64 width, const char32 *string) {
 	if (++ iPadBuffer == NUMBER_OF_BUFFERS) iPadBuffer = 0;
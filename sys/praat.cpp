@@ -26,6 +26,10 @@
 	#include <signal.h>
 #endif
 #include <locale.h>
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
 #if defined (UNIX)
 	#include <unistd.h>
 #endif
@@ -259,6 +263,96 @@ autoCollection praat_getSelectedObjects () {
 
 char32 *praat_name (int IOBJECT) { return str32chr (FULL_NAME, U' ') + 1; }
 
+/*
+	New objects get a higher ID than all existing objects and go to the end of the list,
+	and removing an object keeps the other objects in order, so the list is always sorted by ID.
+	To find objects by full name, each object list has an index from full names to the IDs
+	of the objects with that name, oldest first; it is updated whenever an object is created, renamed or removed.
+*/
+struct structPraat_ObjectIndex {
+	std::unordered_map <std::u32string, std::vector <long>> idsByFullName;
+};
+
+static struct structPraat_ObjectIndex *praat_getObjectIndex () {
+	if (! theCurrentPraatObjects -> index) {
+		theCurrentPraatObjects -> index = new structPraat_ObjectIndex;
+		for (int iobject = 1; iobject <= theCurrentPraatObjects -> n; iobject ++)
+			theCurrentPraatObjects -> index -> idsByFullName [theCurrentPraatObjects -> list [iobject]. name]. push_back (theCurrentPraatObjects -> list [iobject]. id);
+	}
+	return theCurrentPraatObjects -> index;
+}
+
+static void praat_ObjectIndex_remove (const char32 *fullName, long id) {
+	struct structPraat_ObjectIndex *index = praat_getObjectIndex ();
+	auto found = index -> idsByFullName. find (fullName);
+	if (found == index -> idsByFullName. end ()) return;
+	std::vector <long>& ids = found -> second;
+	for (long i = (long) ids. size () - 1; i >= 0; i --) {
+		if (ids [i] == id) {
+			ids. erase (ids. begin () + i);
+			break;
+		}
+	}
+	if (ids. empty ())
+		index -> idsByFullName. erase (found);
+}
+
+int praat_iobjectFromId (long id) {
+	int lo = 1, hi = theCurrentPraatObjects -> n;
+	while (lo <= hi) {
+		int mid = (lo + hi) / 2;
+		long midId = theCurrentPraatObjects -> list [mid]. id;
+		if (midId == id) return mid;
+		if (midId < id) lo = mid + 1; else hi = mid - 1;
+	}
+	return 0;
+}
+
+int praat_iobjectFromFullName (const char32 *fullName) {
+	struct structPraat_ObjectIndex *index = praat_getObjectIndex ();
+	auto found = index -> idsByFullName. find (fullName);
+	if (found == index -> idsByFullName. end ()) return 0;
+	int iobject = praat_iobjectFromId (found -> second. back ());
+	Melder_assert (iobject != 0);
+	return iobject;
+}
+
+void praat_setFullName (int IOBJECT, const char32 *fullName) {
+	praat_ObjectIndex_remove (FULL_NAME, ID);
+	Melder_free (FULL_NAME);
+	FULL_NAME = Melder_dup_f (fullName);
+	std::vector <long>& ids = praat_getObjectIndex () -> idsByFullName [fullName];
+	ids. insert (std::upper_bound (ids. begin (), ids. end (), ID), ID);   // a renamed object can be older than others with its new name
+}
+
+void praat_deleteObjectTable (PraatObjects objects) {
+	for (int iobject = 1; iobject <= objects -> list. _capacity; iobject ++)
+		delete objects -> list. entries [iobject];
+	free (objects -> list. entries);
+	objects -> list. entries = nullptr;
+	objects -> list. _capacity = 0;
+	delete objects -> index;
+	objects -> index = nullptr;
+}
+
+#define praat_MINIMUM_OBJECT_TABLE_CAPACITY  100
+
+static void praat_ObjectTable_resize (struct structPraat_ObjectTable *me, int newCapacity) {
+	/*
+		Entries above n are empty, so they can go when the table shrinks.
+	*/
+	for (int iobject = newCapacity + 1; iobject <= my _capacity; iobject ++)
+		delete my entries [iobject];
+	praat_Object *entries = (praat_Object *) realloc (my entries, (1 + (size_t) newCapacity) * sizeof (praat_Object));
+	if (! entries)
+		Melder_throw (U"Out of memory: cannot make room for ", newCapacity, U" objects.");
+	for (int iobject = my _capacity + 1; iobject <= newCapacity; iobject ++)
+		entries [iobject] = nullptr;   // created when needed
+	entries [0] = nullptr;
+	my entries = entries;
+	my _capacity = newCapacity;
+}
+
 void praat_write_do (UiForm dia, const char32 *extension) {
 	int IOBJECT, found = 0;
 	Daata data = nullptr;
@@ -321,6 +415,7 @@ static void praat_remove (int iobject, bool removeVisibly) {
 	}
 	MelderFile_setToNull (& theCurrentPraatObjects -> list [iobject]. file);
 	trace (U"free name");
+	praat_ObjectIndex_remove (theCurrentPraatObjects -> list [iobject]. name, theCurrentPraatObjects -> list [iobject]. id);
 	Melder_free (theCurrentPraatObjects -> list [iobject]. name);
 	trace (U"forget object");
 	forget (theCurrentPraatObjects -> list [iobject]. object);   // note: this might save a file-based object to file
@@ -371,11 +466,13 @@ void praat_newWithFile (autoDaata me, MelderFile file, const char32 *myName) {
 	}
 	MelderString_append (& name, Thing_className (me.get()), U" ", givenName.string);
 
-	if (theCurrentPraatObjects -> n == praat_MAXNUM_OBJECTS) {
-		//forget (me);
-		Melder_throw (U"The Object Window cannot contain more than ", praat_MAXNUM_OBJECTS, U" objects. You could remove some objects.");
-	}
-		
+	struct structPraat_ObjectTable *table = & theCurrentPraatObjects -> list;
+	if (theCurrentPraatObjects -> n == table -> _capacity)
+		praat_ObjectTable_resize (table, table -> _capacity < praat_MINIMUM_OBJECT_TABLE_CAPACITY / 2 ?
+			praat_MINIMUM_OBJECT_TABLE_CAPACITY : 2 * table -> _capacity);
+	if (! table -> entries [theCurrentPraatObjects -> n + 1])
+		table -> entries [theCurrentPraatObjects -> n + 1] = new structPraat_Object ();   // zeroed
+
 	int IOBJECT = ++ theCurrentPraatObjects -> n;
 	Melder_assert (FULL_NAME == nullptr);
 	FULL_NAME = Melder_dup_f (name.string);   // all right to crash if out of memory
@@ -397,6 +494,7 @@ void praat_newWithFile (autoDaata me, MelderFile file, const char32 *myName) {
 		MelderFile_setToNull (& theCurrentPraatObjects -> list [IOBJECT]. file);
 	}
 	ID = theCurrentPraatObjects -> uniqueId;
+	praat_getObjectIndex () -> idsByFullName [FULL_NAME]. push_back (ID);
 	theCurrentPraatObjects -> list [IOBJECT]. isBeingCreated = true;
 	Thing_setName (OBJECT, givenName.string);
 	theCurrentPraatObjects -> totalBeingCreated ++;
@@ -510,17 +608,19 @@ void praat_name2 (char32 *name, ClassInfo klas1, ClassInfo klas2) {
 }
 
 void praat_removeObject (int i) {
-	int j, ieditor;
 	praat_remove (i, true);   // dangle
-	for (j = i; j < theCurrentPraatObjects -> n; j ++)
-		theCurrentPraatObjects -> list [j] = theCurrentPraatObjects -> list [j + 1];   // undangle but create second references
-	theCurrentPraatObjects -> list [theCurrentPraatObjects -> n]. name = nullptr;   // undangle or remove second reference
-	theCurrentPraatObjects -> list [theCurrentPraatObjects -> n]. object = nullptr;   // undangle or remove second reference
-	theCurrentPraatObjects -> list [theCurrentPraatObjects -> n]. isSelected = 0;
-	for (ieditor = 0; ieditor < praat_MAXNUM_EDITORS; ieditor ++)
-		theCurrentPraatObjects -> list [theCurrentPraatObjects -> n]. editors [ieditor] = nullptr;   // undangle or remove second reference
-	MelderFile_setToNull (& theCurrentPraatObjects -> list [theCurrentPraatObjects -> n]. file);   // undangle or remove second reference
+	/*
+		Close the gap by moving the pointers to the later entries down;
+		the entry of the removed object is cleared and reused at the top.
+	*/
+	struct structPraat_ObjectTable *table = & theCurrentPraatObjects -> list;
+	praat_Object removed = table -> entries [i];
+	memmove (& table -> entries [i], & table -> entries [i + 1], (size_t) (theCurrentPraatObjects -> n - i) * sizeof (praat_Object));
+	*removed = structPraat_Object ();   // undangle
+	table -> entries [theCurrentPraatObjects -> n] = removed;
 	-- theCurrentPraatObjects -> n;
+	if (theCurrentPraatObjects -> n < table -> _capacity / 4 && table -> _capacity > praat_MINIMUM_OBJECT_TABLE_CAPACITY)
+		praat_ObjectTable_resize (table, table -> _capacity / 2);
 	if (! theCurrentPraatApplication -> batch) {
 		GuiList_deleteItem (praatList_objects, i);
 	}
@@ -158,7 +158,18 @@ typedef struct {
 	bool isBeingCreated;
 } structPraat_Object, *praat_Object;
 
-#define praat_MAXNUM_OBJECTS 10000   /* Maximum number of objects in the list. */
+/*
+	The table of objects grows and shrinks with the number of objects.
+	It holds pointers only, so that growing it, and closing the gap left by a removed object, is cheap,
+	and each object's entry stays at the same address as long as the object is in the list.
+	Zeroed memory is an empty table.
+*/
+struct structPraat_ObjectTable {
+	praat_Object *entries;   // entries [1.._capacity], of which [1..n] are in use
+	int _capacity;
+	structPraat_Object& operator[] (int iobject) { return * entries [iobject]; }
+};
+
 typedef struct {   /* Readonly */
 	MelderString batchName;   /* The name of the command file when called from batch. */
 	int batch;   /* Was the program called from the command line? */
@@ -167,11 +178,12 @@ typedef struct {   /* Readonly */
 } structPraatApplication, *PraatApplication;
 typedef struct {   /* Readonly */
 	int n;	 /* The current number of objects in the list. */
-	structPraat_Object list [1 + praat_MAXNUM_OBJECTS];   /* The list of objects: list [1..n]. */
+	structPraat_ObjectTable list;   /* The list of objects: list [1..n]. */
 	int totalSelection;   /* The total number of selected objects, <= n. */
 	int numberOfSelected [1 + 1000];   /* For each (readable) class. */
 	int totalBeingCreated;
 	long uniqueId;
+	struct structPraat_ObjectIndex *index;   // the objects by full name; created when first needed
 } structPraatObjects, *PraatObjects;
 typedef struct {   // readonly
 	Graphics graphics;   /* The Graphics associated with the Picture window or HyperPage window or Demo window. */
@@ -193,6 +205,20 @@ Daata praat_onlyObject_generic (ClassInfo klas);
 	/* Returns a selected Daata of class 'klas' or a subclass. */
 praat_Object praat_onlyScreenObject ();
 char32 *praat_name (int iobject);
+int praat_iobjectFromId (long id);
+/*
+	The position of the object with this unique ID in the list, or 0 if there is no such object.
+	The list is always sorted by ID, so this takes logarithmic time.
+*/
+int praat_iobjectFromFullName (const char32 *fullName);
+/*
+	The position of the most recently created object with this full name (e.g. "Sound hallo"), or 0.
+	This takes constant time, via the index of the object list.
+*/
+void praat_setFullName (int iobject, const char32 *fullName);
+	/* Renames the object in the list, keeping the index up to date. */
+void praat_deleteObjectTable (PraatObjects objects);
+	/* For object lists that are thrown away without removing their objects one by one: frees the table and the index. */
 void praat_write_do (UiForm dia, const char32 *extension);
 void praat_new (autoDaata me);
 void praat_new (autoDaata me, Melder_1_ARG);
@@ -22,10 +22,31 @@
 #include "machine.h"
 #include "GuiP.h"
 
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 #define BUTTON_LEFT  -240
 #define BUTTON_RIGHT -5
 
 static OrderedOf <structPraat_Command> theActions;
+
+/*
+	The positions in theActions of the actions with each title, in ascending order,
+	so that a script command does not have to be compared with thousands of titles.
+	The index is built when it is first needed after registration, and rebuilt after every change in theActions.
+*/
+static std::unordered_map <std::u32string, std::vector <long>> theActionsByTitle;
+static bool theActionsByTitleIsValid = false;
+
+static void indexActionsByTitle () {
+	theActionsByTitle. clear ();
+	for (long i = 1; i <= theActions.size; i ++) {
+		const char32 *title = theActions.at [i] -> title;
+		if (title) theActionsByTitle [title]. push_back (i);
+	}
+	theActionsByTitleIsValid = true;
+}
 static GuiMenu praat_writeMenu;
 static GuiMenuItem praat_writeMenuSeparator;
 static GuiForm praat_form;
@@ -72,11 +93,25 @@ static long lookUpMatchingAction (ClassInfo class1, ClassInfo class2, ClassInfo
  * Precondition:
  *	class1, class2, and class3 must be in sorted order.
  */
+	if (! title) return 0;
+	if (theActionsByTitleIsValid) {
+		auto found = theActionsByTitle. find (title);
+		if (found == theActionsByTitle. end ()) return 0;
+		for (long i : found -> second) {
+			Praat_Command action = theActions.at [i];
+			if (class1 == action -> class1 && class2 == action -> class2 &&
+			    class3 == action -> class3 && class4 == action -> class4) return i;
+		}
+		return 0;
+	}
+	/*
+		During registration, building the index after every new action would cost more than this search.
+	*/
 	for (long i = 1; i <= theActions.size; i ++) {
 		Praat_Command action = theActions.at [i];
 		if (class1 == action -> class1 && class2 == action -> class2 &&
 		    class3 == action -> class3 && class4 == action -> class4 &&
-		    title && action -> title && str32equ (action -> title, title)) return i;
+		    action -> title && str32equ (action -> title, title)) return i;
 	}
 	return 0;   // not found
 }
@@ -160,6 +195,7 @@ void praat_addAction4_ (ClassInfo class1, int n1, ClassInfo class2, int n2, Clas
 		 * Insert new command.
 		 */
 		theActions. addItemAtPosition_move (action.move(), position);
+		theActionsByTitleIsValid = false;
 	} catch (MelderError) {
 		Melder_flushError ();
 	}
@@ -247,6 +283,7 @@ void praat_addActionScript (const char32 *className1, int n1, const char32 *clas
 		long found = lookUpMatchingAction (class1, class2, class3, nullptr, title);
 		if (found) {
 			theActions. removeItem (found);
+			theActionsByTitleIsValid = false;
 		}
 
 		/*
@@ -296,6 +333,7 @@ void praat_addActionScript (const char32 *className1, int n1, const char32 *clas
 		 * Insert new command.
 		 */
 		theActions. addItemAtPosition_move (action.move(), position);
+		theActionsByTitleIsValid = false;
 		updateDynamicMenu ();
 	} catch (MelderError) {
 		Melder_throw (U"Praat: script action not added.");
@@ -314,6 +352,7 @@ void praat_removeAction (ClassInfo class1, ClassInfo class2, ClassInfo class3, c
 				U": ", title, U"\" not found.");
 		}
 		theActions. removeItem (found);
+		theActionsByTitleIsValid = false;
 	} catch (MelderError) {
 		Melder_throw (U"Praat: action not removed.");
 	}
@@ -452,6 +491,7 @@ void praat_sortActions () {
 		action -> sortingTail = i;
 	}
 	qsort (& theActions.at [1], theActions.size, sizeof (Praat_Command), compareActions);
+	theActionsByTitleIsValid = false;
 }
 
 static const char32 *numberString (int number) {
@@ -707,19 +747,31 @@ void praat_saveAddedActions (MelderString *buffer) {
 	}
 }
 
+static Praat_Command lookUpExecutableAction (const char32 *title) {
+/*
+ * The first executable action with this title, i.e. the one that the user could choose in the dynamic menu.
+ */
+	if (! theActionsByTitleIsValid) indexActionsByTitle ();
+	auto found = theActionsByTitle. find (title);
+	if (found == theActionsByTitle. end ()) return nullptr;
+	for (long i : found -> second) {
+		Praat_Command action = theActions.at [i];
+		if (action -> executable) return action;
+	}
+	return nullptr;
+}
+
 int praat_doAction (const char32 *command, const char32 *arguments, Interpreter interpreter) {
-	long i = 1;
-	while (i <= theActions.size && (! theActions.at [i] -> executable || str32cmp (theActions.at [i] -> title, command))) i ++;
-	if (i > theActions.size) return 0;   // not found
-	theActions.at [i] -> callback (nullptr, 0, nullptr, arguments, interpreter, command, false, nullptr);
+	Praat_Command action = lookUpExecutableAction (command);
+	if (! action) return 0;   // not found
+	action -> callback (nullptr, 0, nullptr, arguments, interpreter, command, false, nullptr);
 	return 1;
 }
 
 int praat_doAction (const char32 *command, int narg, Stackel args, Interpreter interpreter) {
-	long i = 1;
-	while (i <= theActions.size && (! theActions.at [i] -> executable || str32cmp (theActions.at [i] -> title, command))) i ++;
-	if (i > theActions.size) return 0;   // not found
-	theActions.at [i] -> callback (nullptr, narg, args, nullptr, interpreter, command, false, nullptr);
+	Praat_Command action = lookUpExecutableAction (command);
+	if (! action) return 0;   // not found
+	action -> callback (nullptr, narg, args, nullptr, interpreter, command, false, nullptr);
 	return 1;
 }
 
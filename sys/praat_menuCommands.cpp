@@ -21,8 +21,28 @@
 #include "praat_version.h"
 #include "GuiP.h"
 
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 static OrderedOf <structPraat_Command> theCommands;
 
+/*
+	The positions in theCommands of the commands with each title, in ascending order;
+	built when first needed after registration, and rebuilt after every change in theCommands (see praat_actions.cpp).
+*/
+static std::unordered_map <std::u32string, std::vector <long>> theCommandsByTitle;
+static bool theCommandsByTitleIsValid = false;
+
+static void indexCommandsByTitle () {
+	theCommandsByTitle. clear ();
+	for (long i = 1; i <= theCommands.size; i ++) {
+		const char32 *title = theCommands.at [i] -> title;
+		if (title) theCommandsByTitle [title]. push_back (i);
+	}
+	theCommandsByTitleIsValid = true;
+}
+
 void praat_menuCommands_init () {
 }
 
@@ -48,12 +68,25 @@ void praat_sortMenuCommands () {
 		command -> sortingTail = i;
 	}
 	qsort (& theCommands.at [1], theCommands.size, sizeof (Praat_Command), compareMenuCommands);
+	theCommandsByTitleIsValid = false;
 }
 
 static long lookUpMatchingMenuCommand (const char32 *window, const char32 *menu, const char32 *title) {
 /*
  * A menu command is fully specified by its environment (window + menu) and its title.
  */
+	if (theCommandsByTitleIsValid && title) {
+		auto found = theCommandsByTitle. find (title);
+		if (found == theCommandsByTitle. end ()) return 0;
+		for (long i : found -> second) {
+			Praat_Command command = theCommands.at [i];
+			const char32 *tryWindow = command -> window;
+			const char32 *tryMenu = command -> menu;
+			if ((window == tryWindow || (window && tryWindow && str32equ (window, tryWindow))) &&
+			    (menu == tryMenu || (menu && tryMenu && str32equ (menu, tryMenu)))) return i;
+		}
+		return 0;
+	}
 	for (long i = 1; i <= theCommands.size; i ++) {
 		Praat_Command command = theCommands.at [i];
 		const char32 *tryWindow = command -> window;
@@ -225,6 +258,7 @@ GuiMenuItem praat_addMenuCommand_ (const char32 *window, const char32 *menu, con
 	}
 	Thing_cast (GuiMenuItem, button_as_GuiMenuItem, command -> button);
 	theCommands. addItemAtPosition_move (command.move(), position);
+	theCommandsByTitleIsValid = false;
 	return button_as_GuiMenuItem;
 }
 
@@ -316,6 +350,7 @@ void praat_addMenuCommandScript (const char32 *window, const char32 *menu, const
 			}
 		}
 		theCommands. addItemAtPosition_move (command.move(), position);
+		theCommandsByTitleIsValid = false;
 
 		if (praatP.phase >= praat_HANDLING_EVENTS) praat_sortMenuCommands ();
 	} catch (MelderError) {
@@ -391,6 +426,7 @@ void praat_addFixedButtonCommand_ (GuiForm parent, const char32 *title, UiCallba
 	}
 	my executable = false;
 	theCommands. addItemAtPosition_move (me.move(), 0);
+	theCommandsByTitleIsValid = false;
 }
 
 void praat_sensitivizeFixedButtonCommand (const char32 *title, int sensitive) {
@@ -408,33 +444,30 @@ void praat_sensitivizeFixedButtonCommand (const char32 *title, int sensitive) {
 		GuiThing_setSensitive (commandFound -> button, sensitive);
 }
 
-int praat_doMenuCommand (const char32 *title, const char32 *arguments, Interpreter interpreter) {
-	Praat_Command commandFound = nullptr;
-	for (long i = 1; i <= theCommands.size; i ++) {
+static Praat_Command lookUpExecutableScriptableMenuCommand (const char32 *title) {
+/*
+ * The first executable command with this title in the Objects or Picture window.
+ */
+	if (! theCommandsByTitleIsValid) indexCommandsByTitle ();
+	auto found = theCommandsByTitle. find (title);
+	if (found == theCommandsByTitle. end ()) return nullptr;
+	for (long i : found -> second) {
 		Praat_Command command = theCommands.at [i];
-		if (command -> executable && str32equ (command -> title, title) &&
-			(str32equ (command -> window, U"Objects") || str32equ (command -> window, U"Picture")))
-		{
-			commandFound = command;
-			break;
-		}
+		if (command -> executable && (str32equ (command -> window, U"Objects") || str32equ (command -> window, U"Picture")))
+			return command;
 	}
+	return nullptr;
+}
+
+int praat_doMenuCommand (const char32 *title, const char32 *arguments, Interpreter interpreter) {
+	Praat_Command commandFound = lookUpExecutableScriptableMenuCommand (title);
 	if (! commandFound) return 0;
 	commandFound -> callback (nullptr, 0, nullptr, arguments, interpreter, title, false, nullptr);
 	return 1;
 }
 
 int praat_doMenuCommand (const char32 *title, int narg, Stackel args, Interpreter interpreter) {
-	Praat_Command commandFound = nullptr;
-	for (long i = 1; i <= theCommands.size; i ++) {
-		Praat_Command command = theCommands.at [i];
-		if (command -> executable && str32equ (command -> title, title) &&
-			(str32equ (command -> window, U"Objects") || str32equ (command -> window, U"Picture")))
-		{
-			commandFound = command;
-			break;
-		}
-	}
+	Praat_Command commandFound = lookUpExecutableScriptableMenuCommand (title);
 	if (! commandFound) return 0;
 	commandFound -> callback (nullptr, narg, args, nullptr, interpreter, title, false, nullptr);
 	return 1;
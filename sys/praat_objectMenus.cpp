@@ -65,7 +65,7 @@ DO
 	static MelderString fullName { 0 };
 	MelderString_copy (& fullName, Thing_className (OBJECT), U" ", string);
 	if (! str32equ (fullName.string, FULL_NAME)) {
-		Melder_free (FULL_NAME), FULL_NAME = Melder_dup_f (fullName.string);
+		praat_setFullName (IOBJECT, fullName.string);
 		autoMelderString listName;
 		MelderString_append (& listName, ID, U". ", fullName.string);
 		praat_list_renameAndSelect (IOBJECT, listName.string);
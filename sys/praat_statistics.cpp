@@ -19,6 +19,7 @@
 #include <time.h>
 #include <locale.h>
 #include "praatP.h"
+#include "NUM2.h"
 
 static struct {
 	long batchSessions, interactiveSessions;
@@ -139,7 +140,7 @@ void praat_reportMemoryUse () {
 	MelderInfo_writeLine (U"Currently in use:\n"
 		U"   Strings: ", MelderString_allocationCount () - MelderString_deallocationCount ());
 	MelderInfo_writeLine (U"   Arrays: ", NUM_getTotalNumberOfArrays ());
-	MelderInfo_writeLine (U"   Things: ", theTotalNumberOfThings,
+	MelderInfo_writeLine (U"   Things: ", theTotalNumberOfThings. load (),
 		U" (objects in list: ", theCurrentPraatObjects -> n, U")");
 	long numberOfMotifWidgets =
 	#if motif
@@ -163,6 +164,16 @@ void praat_reportMemoryUse () {
 		U"   Strings created: ", Melder_bigInteger (MelderString_allocationCount ()), U" (", Melder_bigInteger (MelderString_allocationSize ()), U" bytes)");
 	MelderInfo_writeLine (
 		U"   Strings deleted: ", Melder_bigInteger (MelderString_deallocationCount ()), U" (", Melder_bigInteger (MelderString_deallocationSize ()), U" bytes)");
+	int64 numberOfFftHits, numberOfFftMisses, numberOfFftBytes;
+	long numberOfFftTables;
+	NUMfft_getCacheStatistics (& numberOfFftHits, & numberOfFftMisses, & numberOfFftTables, & numberOfFftBytes);
+	MelderInfo_writeLine (U"   FFT tables cached: ", numberOfFftTables, U" (", Melder_bigInteger (numberOfFftBytes), U" bytes; ",
+		Melder_bigInteger (numberOfFftHits), U" hits, ", Melder_bigInteger (numberOfFftMisses), U" misses)");
+	int64 numberOfRegexpHits, numberOfRegexpMisses;
+	long numberOfRegexps;
+	Melder_getRegexpCacheStatistics (& numberOfRegexpHits, & numberOfRegexpMisses, & numberOfRegexps);
+	MelderInfo_writeLine (U"   Regular expressions cached: ", numberOfRegexps, U" (",
+		Melder_bigInteger (numberOfRegexpHits), U" hits, ", Melder_bigInteger (numberOfRegexpMisses), U" misses)");
 	MelderInfo_writeLine (U"\nHistory of all sessions from ", statistics.dateOfFirstSession, U" until today:");
 	MelderInfo_writeLine (U"   Sessions: ", statistics.interactiveSessions, U" interactive, ",
 		statistics.batchSessions, U" batch");